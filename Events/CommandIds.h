@@ -0,0 +1,112 @@
+#ifndef BASE_COMMANDIDS_H
+#define BASE_COMMANDIDS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Ground station commands, interned once when a message is parsed so that everything after the
+// transports works with a small integer instead of the name. The values go on the wire (binary
+// CommandById frames) and into event journals: append new commands, never renumber.
+enum class CommandId : uint8_t {
+    Unknown = 0,
+    Takeoff,
+    Land,
+    ReturnToLaunch,
+    Hold,
+    Arm,
+    Disarm,
+    SetFlightMode,
+    StartManualControl,
+    SetManualControl,
+    StopManualControl,
+    TapToFly,
+    FlyTo,
+    Info,
+    SetBrightness,
+    LinkPong,
+    Count
+};
+
+constexpr size_t CommandCount = static_cast<size_t>(CommandId::Count);
+
+namespace CommandIds {
+
+constexpr std::array<std::string_view, CommandCount> Names = {
+    "",
+    "takeoff",
+    "land",
+    "return_to_launch",
+    "hold",
+    "arm",
+    "disarm",
+    "set_flight_mode",
+    "start_manual_control",
+    "set_manual_control",
+    "stop_manual_control",
+    "tap_to_fly",
+    "fly_to",
+    "info",
+    "set_brightness",
+    "pong"
+};
+
+// Name lookup is a perfect hash: a seeded FNV-1a whose seed is searched at compile time so that
+// every name lands in its own slot. A lookup is one hash, one table load and one compare.
+constexpr size_t TableSize = 32;
+static_assert(TableSize >= CommandCount && (TableSize & (TableSize - 1)) == 0, "TableSize must be a power of two");
+
+constexpr uint32_t hash(std::string_view name, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (char c : name) {
+        h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+constexpr uint32_t findSeed() {
+    for (uint32_t seed = 1; seed < 100000; ++seed) {
+        bool used[TableSize] = {};
+        bool collision = false;
+        for (size_t i = 1; i < CommandCount && !collision; ++i) {
+            size_t slot = hash(Names[i], seed) & (TableSize - 1);
+            collision = used[slot];
+            used[slot] = true;
+        }
+        if (!collision) {
+            return seed;
+        }
+    }
+    return 0;
+}
+
+constexpr uint32_t Seed = findSeed();
+static_assert(Seed != 0, "No perfect hash seed for the command names; grow TableSize");
+
+constexpr std::array<CommandId, TableSize> makeTable() {
+    std::array<CommandId, TableSize> table{};
+    for (size_t i = 1; i < CommandCount; ++i) {
+        table[hash(Names[i], Seed) & (TableSize - 1)] = static_cast<CommandId>(i);
+    }
+    return table;
+}
+
+constexpr std::array<CommandId, TableSize> Table = makeTable();
+
+}
+
+// Unknown for names that are not commands.
+constexpr CommandId commandIdFromName(std::string_view name) {
+    CommandId id = CommandIds::Table[CommandIds::hash(name, CommandIds::Seed) & (CommandIds::TableSize - 1)];
+    return CommandIds::Names[static_cast<size_t>(id)] == name ? id : CommandId::Unknown;
+}
+
+constexpr std::string_view commandName(CommandId id) {
+    auto index = static_cast<size_t>(id);
+    return index < CommandCount && id != CommandId::Unknown ? CommandIds::Names[index] : std::string_view("unknown");
+}
+
+static_assert(commandIdFromName("fly_to") == CommandId::FlyTo && commandIdFromName("fly") == CommandId::Unknown);
+
+#endif // BASE_COMMANDIDS_H
@@ -0,0 +1,152 @@
+#ifndef BASE_COMMANDTRACE_H
+#define BASE_COMMANDTRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+
+#include "LatencyHistogram.h"
+
+// Timestamps of one ground station command on its way from the socket to the MAVSDK call that
+// carries it out. A transport starts the trace when the receive call returns and makes it current
+// while the message is parsed, so CommandScheduler::submit() picks it up from the synchronous
+// command_received handler; the lane worker makes it current again while the command runs, for
+// CommandTrace::MavsdkCall to mark. Commands from transports that do not trace are not measured.
+struct CommandTrace {
+    using Clock = std::chrono::steady_clock;
+
+    bool kernelStamped = false;
+    uint64_t kernelNs = 0;          // Kernel receive timestamp to the receive call returning
+    Clock::time_point receivedAt;   // Receive call returned; the epoch when not traced
+    Clock::time_point submittedAt;  // Handed to the scheduler
+    Clock::time_point startedAt;    // Taken by a lane worker
+    Clock::time_point callStartedAt;    // First MAVSDK call made for the command
+    Clock::time_point callEndedAt;      // Last MAVSDK call returned
+
+    bool traced() const { return receivedAt != Clock::time_point(); }
+
+    // kernelStamp is the CLOCK_REALTIME receive timestamp from the socket, or null without one;
+    // receivedRealtime is CLOCK_REALTIME read when the receive call returned.
+    static CommandTrace received(const timespec* kernelStamp, const timespec& receivedRealtime) {
+        CommandTrace trace;
+        trace.receivedAt = Clock::now();
+        if (kernelStamp) {
+            int64_t delta = (receivedRealtime.tv_sec - kernelStamp->tv_sec) * int64_t(1000000000)
+                            + (receivedRealtime.tv_nsec - kernelStamp->tv_nsec);
+            // A clock step between the two readings makes the difference meaningless
+            if (delta >= 0) {
+                trace.kernelStamped = true;
+                trace.kernelNs = static_cast<uint64_t>(delta);
+            }
+        }
+        return trace;
+    }
+
+    // The trace of the command the calling thread is working on, or null
+    static CommandTrace*& current() {
+        static thread_local CommandTrace* trace = nullptr;
+        return trace;
+    }
+
+    class Scope {
+    public:
+        explicit Scope(CommandTrace* trace) : previous(current()) { current() = trace; }
+        ~Scope() { current() = previous; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        CommandTrace* previous;
+    };
+
+    // Brackets a MAVSDK call; does nothing outside a traced command, as on the manual control timer.
+    class MavsdkCall {
+    public:
+        MavsdkCall() : trace(current() && current()->traced() ? current() : nullptr) {
+            if (trace && trace->callStartedAt == Clock::time_point()) {
+                trace->callStartedAt = Clock::now();
+            }
+        }
+        ~MavsdkCall() {
+            if (trace) {
+                trace->callEndedAt = Clock::now();
+            }
+        }
+
+        MavsdkCall(const MavsdkCall&) = delete;
+        MavsdkCall& operator=(const MavsdkCall&) = delete;
+
+    private:
+        CommandTrace* trace;
+    };
+};
+
+// Per-stage latency of traced commands since startup:
+//   kernel    kernel receive timestamp to the receive call returning (UDP and TCP only)
+//   ingress   receive to scheduler submit: transport queue, parser and event bus
+//   queue     waiting in the scheduler lane
+//   dispatch  lane worker to the first MAVSDK call: handler and CommandManager
+//   mavsdk    first MAVSDK call to the last one returning
+//   total     kernel timestamp (or receive, without one) to the last MAVSDK call returning
+// Commands that make no MAVSDK call, such as set_manual_control, stop after the queue stage.
+class CommandLatency {
+public:
+    enum Stage {
+        Kernel,
+        Ingress,
+        Queue,
+        Dispatch,
+        Mavsdk,
+        Total,
+        StageCount
+    };
+
+    void record(const CommandTrace& trace) {
+        if (!trace.traced()) {
+            return;
+        }
+        if (trace.kernelStamped) {
+            stages[Kernel].record(trace.kernelNs);
+        }
+        stages[Ingress].record(nanoseconds(trace.submittedAt - trace.receivedAt));
+        stages[Queue].record(nanoseconds(trace.startedAt - trace.submittedAt));
+        if (trace.callStartedAt == CommandTrace::Clock::time_point()) {
+            withoutCall.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        stages[Dispatch].record(nanoseconds(trace.callStartedAt - trace.startedAt));
+        stages[Mavsdk].record(nanoseconds(trace.callEndedAt - trace.callStartedAt));
+        stages[Total].record(trace.kernelNs + nanoseconds(trace.callEndedAt - trace.receivedAt));
+    }
+
+    void dump(std::ostream& out) const {
+        static const char* names[StageCount] = {"kernel", "ingress", "queue", "dispatch", "mavsdk", "total"};
+        for (int stage = 0; stage < StageCount; ++stage) {
+            auto summary = stages[stage].summarize();
+            out << "[latency] " << names[stage] << " count=" << summary.count << " p50=" << summary.p50Ns / 1000
+                << "us p90=" << summary.p90Ns / 1000 << "us p99=" << summary.p99Ns / 1000
+                << "us p99.9=" << summary.p999Ns / 1000 << "us max=" << summary.maxNs / 1000 << "us\n";
+        }
+        out << "[latency] commands without a MAVSDK call=" << withoutCall.load(std::memory_order_relaxed) << "\n";
+        out.flush();
+    }
+
+private:
+    LatencyHistogram stages[StageCount];
+    std::atomic<uint64_t> withoutCall{0};
+
+    static uint64_t nanoseconds(CommandTrace::Clock::duration duration) {
+        auto count = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        return count > 0 ? static_cast<uint64_t>(count) : 0;
+    }
+};
+
+inline CommandLatency& GetCommandLatency() {
+    static CommandLatency instance;
+    return instance;
+}
+
+#endif // BASE_COMMANDTRACE_H
@@ -0,0 +1,123 @@
+#ifndef BASE_DELEGATE_H
+#define BASE_DELEGATE_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+// Copyable callable wrapper with inline storage only. Unlike std::function it never touches
+// the heap: a callable that does not fit the buffer is rejected at compile time.
+template<typename Signature, size_t Capacity = 6 * sizeof(void*)>
+class Delegate;
+
+template<typename R, typename... Params, size_t Capacity>
+class Delegate<R(Params...), Capacity> {
+public:
+    Delegate() = default;
+
+    template<typename F, typename = typename std::enable_if<
+            !std::is_same<typename std::decay<F>::type, Delegate>::value>::type>
+    Delegate(F&& function) {
+        using Target = typename std::decay<F>::type;
+        static_assert(sizeof(Target) <= Capacity, "Callable too large for Delegate inline storage");
+        static_assert(alignof(Target) <= alignof(std::max_align_t), "Callable over-aligned for Delegate");
+        static_assert(std::is_copy_constructible<Target>::value, "Delegate requires a copyable callable");
+
+        new (&storage) Target(std::forward<F>(function));
+        invoker = [](const void* target, Params... params) -> R {
+            return (*static_cast<Target*>(const_cast<void*>(target)))(std::forward<Params>(params)...);
+        };
+        manager = [](Operation operation, void* destination, void* source) {
+            switch (operation) {
+                case Operation::Copy:
+                    new (destination) Target(*static_cast<const Target*>(source));
+                    break;
+                case Operation::Move:
+                    new (destination) Target(std::move(*static_cast<Target*>(source)));
+                    break;
+                case Operation::Destroy:
+                    static_cast<Target*>(destination)->~Target();
+                    break;
+            }
+        };
+        type = &typeid(Target);
+    }
+
+    Delegate(const Delegate& other) {
+        copyFrom(other);
+    }
+
+    Delegate(Delegate&& other) noexcept {
+        moveFrom(std::move(other));
+    }
+
+    Delegate& operator=(const Delegate& other) {
+        if (this != &other) {
+            reset();
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    Delegate& operator=(Delegate&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(std::move(other));
+        }
+        return *this;
+    }
+
+    ~Delegate() {
+        reset();
+    }
+
+    R operator()(Params... params) const {
+        return invoker(&storage, std::forward<Params>(params)...);
+    }
+
+    explicit operator bool() const { return invoker != nullptr; }
+
+    const std::type_info& target_type() const {
+        return type ? *type : typeid(void);
+    }
+
+private:
+    enum class Operation { Copy, Move, Destroy };
+
+    typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type storage;
+    R (*invoker)(const void*, Params...) = nullptr;
+    void (*manager)(Operation, void*, void*) = nullptr;
+    const std::type_info* type = nullptr;
+
+    void copyFrom(const Delegate& other) {
+        if (other.manager) {
+            other.manager(Operation::Copy, &storage, const_cast<void*>(static_cast<const void*>(&other.storage)));
+        }
+        invoker = other.invoker;
+        manager = other.manager;
+        type = other.type;
+    }
+
+    void moveFrom(Delegate&& other) {
+        if (other.manager) {
+            other.manager(Operation::Move, &storage, &other.storage);
+        }
+        invoker = other.invoker;
+        manager = other.manager;
+        type = other.type;
+        other.reset();
+    }
+
+    void reset() {
+        if (manager) {
+            manager(Operation::Destroy, &storage, nullptr);
+        }
+        invoker = nullptr;
+        manager = nullptr;
+        type = nullptr;
+    }
+};
+
+#endif // BASE_DELEGATE_H
@@ -0,0 +1,19 @@
+#ifndef BASE_EVENTCHANNELS_H
+#define BASE_EVENTCHANNELS_H
+
+#include <string>
+#include <vector>
+#include "EventManager.h"
+#include "CommandIds.h"
+
+// Application events. The names match the ones used with CREATE_EVENT / INVOKE_EVENT,
+// so GetEventChannel<Tag>() and the string macros reach the same subscribers.
+DECLARE_EVENT(SendAckEvent, "send_ack", const std::string& command);
+DECLARE_EVENT(InfoRequestEvent, "InfoRequest");
+DECLARE_EVENT(SetBrightnessEvent, "set_brightness");
+// client identifies the sending peer (its ProtocolSession); 0 when the command has no peer, as in replay
+DECLARE_EVENT(CommandReceivedEvent, "command_received", CommandId command, const std::vector<double>& parameters, uint32_t client);
+// Ground station answer to a CommunicationManager link probe, "pong:link,sequence"
+DECLARE_EVENT(LinkPongEvent, "link_pong", uint32_t link, uint32_t sequence);
+
+#endif // BASE_EVENTCHANNELS_H
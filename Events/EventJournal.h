@@ -0,0 +1,303 @@
+#ifndef BASE_EVENTJOURNAL_H
+#define BASE_EVENTJOURNAL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary encoding of event payloads for the journal. Arithmetic and enum values are stored as raw bytes,
+// strings and vectors of arithmetic values as a 32-bit length followed by their contents.
+// Events with any other payload type are not journaled.
+template<typename T, typename = void>
+struct JournalCodec {
+    static constexpr bool supported = false;
+};
+
+template<typename T>
+struct JournalCodec<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type> {
+    static constexpr bool supported = true;
+
+    static size_t size(const T&) { return sizeof(T); }
+
+    static char* write(char* out, const T& value) {
+        std::memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+
+    static bool read(const char*& in, const char* end, T& value) {
+        if (static_cast<size_t>(end - in) < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return true;
+    }
+};
+
+template<>
+struct JournalCodec<std::string> {
+    static constexpr bool supported = true;
+
+    static size_t size(const std::string& value) { return sizeof(uint32_t) + value.size(); }
+
+    static char* write(char* out, const std::string& value) {
+        out = JournalCodec<uint32_t>::write(out, static_cast<uint32_t>(value.size()));
+        std::memcpy(out, value.data(), value.size());
+        return out + value.size();
+    }
+
+    static bool read(const char*& in, const char* end, std::string& value) {
+        uint32_t length = 0;
+        if (!JournalCodec<uint32_t>::read(in, end, length) || static_cast<size_t>(end - in) < length) {
+            return false;
+        }
+        value.assign(in, length);
+        in += length;
+        return true;
+    }
+};
+
+template<typename T>
+struct JournalCodec<std::vector<T>, typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+    static constexpr bool supported = true;
+
+    static size_t size(const std::vector<T>& value) { return sizeof(uint32_t) + value.size() * sizeof(T); }
+
+    static char* write(char* out, const std::vector<T>& value) {
+        out = JournalCodec<uint32_t>::write(out, static_cast<uint32_t>(value.size()));
+        std::memcpy(out, value.data(), value.size() * sizeof(T));
+        return out + value.size() * sizeof(T);
+    }
+
+    static bool read(const char*& in, const char* end, std::vector<T>& value) {
+        uint32_t count = 0;
+        if (!JournalCodec<uint32_t>::read(in, end, count) || static_cast<size_t>(end - in) / sizeof(T) < count) {
+            return false;
+        }
+        value.resize(count);
+        std::memcpy(value.data(), in, count * sizeof(T));
+        in += count * sizeof(T);
+        return true;
+    }
+};
+
+template<typename... Args>
+struct JournalSupported : std::integral_constant<bool, (JournalCodec<Args>::supported && ...)> {};
+
+template<typename... Args>
+bool decodeJournalPayload(const char* data, size_t size, std::tuple<Args...>& values) {
+    const char* end = data + size;
+    return std::apply([&](Args&... value) { return (JournalCodec<Args>::read(data, end, value) && ...); }, values);
+}
+
+// On-disk layout: a FileHeader followed by 8-byte aligned records. Each record starts with a
+// RecordHeader whose size is written last, so a record that was still being written when the
+// process died reads as size 0 and ends the journal.
+struct EventJournalFormat {
+    static constexpr char Magic[4] = {'E', 'V', 'J', '1'};
+    static constexpr uint32_t Version = 1;
+
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        int64_t wallClockStartNs;
+        uint64_t reserved;
+    };
+
+    struct RecordHeader {
+        uint32_t size;
+        uint16_t nameLength;
+        uint16_t reserved;
+        uint64_t timestampNs;
+    };
+
+    static constexpr size_t align(size_t size) { return (size + 7) & ~size_t(7); }
+};
+
+// Append-only recorder backed by a fixed-size memory-mapped file. Writers reserve space with one
+// atomic add and encode straight into the mapping, so recording takes no lock and makes no
+// system call. Records that do not fit are counted as dropped. Timestamps are steady-clock
+// nanoseconds since the journal was opened.
+class EventJournal {
+public:
+    static std::shared_ptr<EventJournal> open(const std::string& path, size_t capacity) {
+        capacity = std::max(capacity, sizeof(EventJournalFormat::FileHeader) + 4096);
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cerr << "Failed to open event journal " << path << ": " << strerror(errno) << std::endl;
+            return nullptr;
+        }
+        if (ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+            std::cerr << "Failed to size event journal " << path << ": " << strerror(errno) << std::endl;
+            ::close(fd);
+            return nullptr;
+        }
+        void* mapping = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            std::cerr << "Failed to map event journal " << path << ": " << strerror(errno) << std::endl;
+            ::close(fd);
+            return nullptr;
+        }
+        return std::shared_ptr<EventJournal>(new EventJournal(fd, static_cast<char*>(mapping), capacity));
+    }
+
+    // Flushes the mapping and trims the file to the bytes actually used. Callers must make sure
+    // no record() is still in flight.
+    ~EventJournal() {
+        size_t used = std::min(offset.load(), capacity);
+        msync(base, capacity, MS_SYNC);
+        munmap(base, capacity);
+        if (ftruncate(fd, static_cast<off_t>(used)) != 0) {
+            std::cerr << "Failed to trim event journal: " << strerror(errno) << std::endl;
+        }
+        ::close(fd);
+    }
+
+    EventJournal(const EventJournal&) = delete;
+    EventJournal& operator=(const EventJournal&) = delete;
+
+    template<typename... Args>
+    void record(const std::string& name, const Args&... args) {
+        using Format = EventJournalFormat;
+        size_t payload = (size_t(0) + ... + JournalCodec<Args>::size(args));
+        size_t size = Format::align(sizeof(Format::RecordHeader) + name.size() + payload);
+        size_t start = offset.fetch_add(size, std::memory_order_relaxed);
+        if (start + size > capacity || size > UINT32_MAX) {
+            if (dropped.fetch_add(1, std::memory_order_relaxed) == 0) {
+                std::cerr << "Event journal full, dropping records" << std::endl;
+            }
+            return;
+        }
+
+        char* out = base + start;
+        Format::RecordHeader header{0, static_cast<uint16_t>(name.size()), 0, elapsedNs()};
+        std::memcpy(out, &header, sizeof(header));
+        char* cursor = out + sizeof(header);
+        std::memcpy(cursor, name.data(), name.size());
+        cursor += name.size();
+        ((cursor = JournalCodec<Args>::write(cursor, args)), ...);
+        __atomic_store_n(reinterpret_cast<uint32_t*>(out), static_cast<uint32_t>(size), __ATOMIC_RELEASE);
+        recorded.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t recordedCount() const { return recorded.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    EventJournal(int fd, char* base, size_t capacity)
+        : fd(fd), base(base), capacity(capacity), start(std::chrono::steady_clock::now()) {
+        using Format = EventJournalFormat;
+        Format::FileHeader header{};
+        std::memcpy(header.magic, Format::Magic, sizeof(header.magic));
+        header.version = Format::Version;
+        header.wallClockStartNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        std::memcpy(base, &header, sizeof(header));
+        offset.store(sizeof(header));
+    }
+
+    int fd;
+    char* base;
+    size_t capacity;
+    std::chrono::steady_clock::time_point start;
+    std::atomic<size_t> offset{0};
+    std::atomic<uint64_t> recorded{0};
+    std::atomic<uint64_t> dropped{0};
+
+    uint64_t elapsedNs() const {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+    }
+};
+
+// Sequential reader over a journal file, mapped read-only.
+class EventJournalReader {
+public:
+    struct Record {
+        uint64_t timestampNs;
+        std::string_view name;
+        const char* payload;
+        size_t payloadSize;
+    };
+
+    explicit EventJournalReader(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Failed to open event journal " << path << ": " << strerror(errno) << std::endl;
+            return;
+        }
+        struct stat info{};
+        if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(EventJournalFormat::FileHeader)) {
+            void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                base = static_cast<const char*>(mapping);
+                size = static_cast<size_t>(info.st_size);
+            }
+        }
+        ::close(fd);
+
+        EventJournalFormat::FileHeader header{};
+        if (base) {
+            std::memcpy(&header, base, sizeof(header));
+        }
+        if (!base || std::memcmp(header.magic, EventJournalFormat::Magic, sizeof(header.magic)) != 0 ||
+            header.version != EventJournalFormat::Version) {
+            std::cerr << "Not an event journal: " << path << std::endl;
+            return;
+        }
+        offset = sizeof(header);
+        valid = true;
+    }
+
+    ~EventJournalReader() {
+        if (base) {
+            munmap(const_cast<char*>(base), size);
+        }
+    }
+
+    EventJournalReader(const EventJournalReader&) = delete;
+    EventJournalReader& operator=(const EventJournalReader&) = delete;
+
+    bool isValid() const { return valid; }
+
+    bool next(Record& record) {
+        using Format = EventJournalFormat;
+        if (!valid || size - offset < sizeof(Format::RecordHeader)) {
+            return false;
+        }
+        Format::RecordHeader header{};
+        std::memcpy(&header, base + offset, sizeof(header));
+        if (header.size < sizeof(header) + header.nameLength || header.size > size - offset) {
+            return false;
+        }
+        const char* name = base + offset + sizeof(header);
+        record.timestampNs = header.timestampNs;
+        record.name = std::string_view(name, header.nameLength);
+        record.payload = name + header.nameLength;
+        record.payloadSize = header.size - sizeof(header) - header.nameLength;
+        offset += header.size;
+        return true;
+    }
+
+private:
+    const char* base = nullptr;
+    size_t size = 0;
+    size_t offset = 0;
+    bool valid = false;
+};
+
+#endif // BASE_EVENTJOURNAL_H
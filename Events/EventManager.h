@@ -7,49 +7,516 @@
 #include <memory>
 #include <mutex>
 #include <iostream>
-#include <list>
+#include <vector>
+#include <atomic>
+#include <thread>
 #include <any>
 #include <unordered_map>
 #include <typeinfo>
+#include <stdexcept>
+#include <type_traits>
+#include <tuple>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include "Executor.h"
+#include "Delegate.h"
+#include "LatencyHistogram.h"
+#include "TimerWheel.h"
+#include "EventJournal.h"
+
+// Per-event invoke counters and per-subscriber execution-time histograms. Set to 1 by the
+// build (CMake option EVENT_INSTRUMENTATION); when 0 none of it is compiled in.
+#ifndef EVENT_INSTRUMENTATION
+#define EVENT_INSTRUMENTATION 0
+#endif
+
+// Grace-period tracking for copy-on-write subscriber lists. Readers register in one of two
+// counters selected by the current epoch; a writer flips the epoch twice and waits for each
+// counter to drain, after which no reader can still hold a snapshot published before the flip.
+class EventReaders {
+public:
+    class Guard {
+    public:
+        explicit Guard(EventReaders& readers)
+            : readers(readers), slot(readers.epoch.load()) {
+            readers.counts[slot].fetch_add(1);
+            ++invokeDepth();
+        }
+        ~Guard() {
+            --invokeDepth();
+            readers.counts[slot].fetch_sub(1);
+        }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        EventReaders& readers;
+        unsigned slot;
+    };
+
+    // Blocks until every reader that started before the call has finished.
+    void synchronize() {
+        std::lock_guard<std::mutex> lock(syncMutex);
+        for (int pass = 0; pass < 2; ++pass) {
+            unsigned previous = epoch.load();
+            epoch.store(previous ^ 1u);
+            while (counts[previous].load() != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // A thread that is inside a callback cannot wait for a grace period: it is a reader itself.
+    static bool insideInvoke() { return invokeDepth() > 0; }
+
+private:
+    std::atomic<unsigned> epoch{0};
+    std::atomic<size_t> counts[2] = {};
+    std::mutex syncMutex;
+
+    static int& invokeDepth() {
+        static thread_local int depth = 0;
+        return depth;
+    }
+};
+
+// Readers of one event: synchronous invokes and asynchronous callbacks running on executors.
+// They are tracked apart so a slow async handler does not hold up subscribe().
+struct EventGracePeriods {
+    EventReaders invocations;
+    EventReaders dispatches;
+
+    void synchronize() {
+        invocations.synchronize();
+        dispatches.synchronize();
+    }
+};
+
+// Move-only handle returned by subscribe(). Destroying it unsubscribes in constant time: the
+// subscriber is flagged inactive and the call waits until no invoke on another thread can still
+// be running it. From inside a callback the wait is skipped, since that thread is a reader.
+// release() keeps the subscription alive for the lifetime of the event.
+class [[nodiscard]] EventSubscription {
+public:
+    EventSubscription() = default;
+
+    EventSubscription(std::shared_ptr<std::atomic<bool>> active, std::weak_ptr<EventGracePeriods> grace)
+        : active(std::move(active)), grace(std::move(grace)) {}
+
+    EventSubscription(EventSubscription&& other) noexcept = default;
+
+    EventSubscription& operator=(EventSubscription&& other) noexcept {
+        if (this != &other) {
+            unsubscribe();
+            active = std::move(other.active);
+            grace = std::move(other.grace);
+        }
+        return *this;
+    }
+
+    EventSubscription(const EventSubscription&) = delete;
+    EventSubscription& operator=(const EventSubscription&) = delete;
+
+    ~EventSubscription() {
+        unsubscribe();
+    }
+
+    void unsubscribe() {
+        if (!active) {
+            return;
+        }
+        active->store(false);
+        active.reset();
+        auto periods = grace.lock();
+        grace.reset();
+        if (periods && !EventReaders::insideInvoke()) {
+            periods->synchronize();
+        }
+    }
+
+    void release() {
+        active.reset();
+        grace.reset();
+    }
+
+    bool isActive() const {
+        return active && active->load();
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> active;
+    std::weak_ptr<EventGracePeriods> grace;
+};
+
+// Counters for asynchronous subscriptions of one event. Latency is measured from the
+// invoke that queued a callback to the moment an executor starts running it.
+struct EventDispatchStats {
+    struct Snapshot {
+        uint64_t queueDepth;
+        uint64_t dispatched;
+        uint64_t averageLatencyUs;
+        uint64_t maxLatencyUs;
+        uint64_t coalesced;
+    };
+
+    std::atomic<uint64_t> queued{0};
+    std::atomic<uint64_t> coalesced{0};
+    std::atomic<uint64_t> dispatched{0};
+    std::atomic<uint64_t> totalLatencyNs{0};
+    std::atomic<uint64_t> maxLatencyNs{0};
+
+    void recordDispatch(std::chrono::steady_clock::time_point queuedAt) {
+        auto latency = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - queuedAt).count());
+        dispatched.fetch_add(1, std::memory_order_relaxed);
+        totalLatencyNs.fetch_add(latency, std::memory_order_relaxed);
+        uint64_t previous = maxLatencyNs.load(std::memory_order_relaxed);
+        while (latency > previous && !maxLatencyNs.compare_exchange_weak(previous, latency, std::memory_order_relaxed)) {
+        }
+    }
+
+    Snapshot snapshot() const {
+        uint64_t done = dispatched.load(std::memory_order_relaxed);
+        uint64_t total = queued.load(std::memory_order_relaxed);
+        return Snapshot{
+            total > done ? total - done : 0,
+            done,
+            done ? totalLatencyNs.load(std::memory_order_relaxed) / done / 1000 : 0,
+            maxLatencyNs.load(std::memory_order_relaxed) / 1000,
+            coalesced.load(std::memory_order_relaxed)
+        };
+    }
+};
+
+#if EVENT_INSTRUMENTATION
+struct EventMetrics {
+    struct SubscriberMetrics {
+        uint32_t id;
+        bool async;
+        LatencyHistogram::Summary executionTime;
+    };
+
+    uint64_t invokes;
+    size_t subscribers;
+    std::vector<SubscriberMetrics> subscriberMetrics;
+};
+#endif
 
 template<typename... Args>
 class Event {
 public:
-    using EventCallback = std::function<void(Args...)>;
+    // Payloads are passed by const reference and callbacks live in inline storage, so a
+    // synchronous invoke allocates nothing no matter how many subscribers there are.
+    using EventCallback = Delegate<void(const Args&...)>;
+    // Maps a payload to its coalescing key. An empty key means the payload is never coalesced.
+    using KeyFunction = Delegate<std::string(const Args&...)>;
 
-    void subscribe(EventCallback callback) {
-        callbacks.push_back(callback);
+    explicit Event(std::string name = std::string())
+        : name(std::move(name)),
+          subscribers(new SubscriberList()),
+          grace(std::make_shared<EventGracePeriods>()),
+          stats(std::make_shared<EventDispatchStats>()) {}
+
+    ~Event() {
+        delete subscribers.load();
+        for (auto list : retired) {
+            delete list;
+        }
     }
 
+    Event(const Event&) = delete;
+    Event& operator=(const Event&) = delete;
+
+    EventSubscription subscribe(EventCallback callback) {
+        auto subscriber = std::make_shared<Subscriber>();
+        subscriber->callback = std::move(callback);
+#if EVENT_INSTRUMENTATION
+        subscriber->id = nextSubscriberId.fetch_add(1, std::memory_order_relaxed);
+#endif
+        add(subscriber);
+        return makeSubscription(subscriber);
+    }
+
+    // Removes every subscriber whose callable has the same type. Prefer the subscription token.
     void unsubscribe(EventCallback callback) {
-        callbacks.remove_if([&](const EventCallback& other) {
-            return callback.target_type() == other.target_type();
-        });
+        std::unique_lock<std::mutex> lock(writeMutex);
+        auto next = new SubscriberList();
+        for (auto& other : *subscribers.load()) {
+            if (callback.target_type() == other->callback.target_type()) {
+                other->active.store(false);
+            } else if (other->active.load()) {
+                next->push_back(other);
+            }
+        }
+        publish(next, lock);
+    }
+
+    // The callback runs on the executor; invoke only copies the payload and queues it. Tasks
+    // still queued when the subscription ends are dropped.
+    EventSubscription subscribeAsync(std::shared_ptr<Executor> executor, EventCallback callback) {
+        return subscribeCoalesced(std::move(executor), KeyFunction(), std::move(callback));
+    }
+
+    // Like subscribeAsync, but while a payload with the same key is still waiting for the
+    // executor, a newer one replaces it instead of queuing behind it. Only the newest payload
+    // per key is delivered; replaced ones are counted in the dispatch stats.
+    EventSubscription subscribeCoalesced(std::shared_ptr<Executor> executor, KeyFunction key, EventCallback callback) {
+        auto subscriber = std::make_shared<Subscriber>();
+        auto dispatch = std::make_shared<AsyncDispatch>();
+        dispatch->executor = std::move(executor);
+        dispatch->callback = std::move(callback);
+        dispatch->key = std::move(key);
+        dispatch->stats = stats;
+        dispatch->grace = grace;
+        dispatch->self = subscriber;
+        subscriber->callback = [dispatch](const Args&... args) {
+            dispatch->enqueue(args...);
+        };
+#if EVENT_INSTRUMENTATION
+        subscriber->id = nextSubscriberId.fetch_add(1, std::memory_order_relaxed);
+        subscriber->async = true;
+#endif
+        add(subscriber);
+        return makeSubscription(subscriber);
     }
 
-    void invoke(Args... args) {
-        for (auto& callback : callbacks) {
-            callback(args...);
+    // Wait-free with respect to subscribe/unsubscribe: walks an immutable snapshot.
+    void invoke(const Args&... args) {
+        EventReaders::Guard guard(grace->invocations);
+        if constexpr (JournalSupported<Args...>::value) {
+            if (EventJournal* sink = journal.load(std::memory_order_acquire)) {
+                sink->record(name, args...);
+            }
+        }
+#if EVENT_INSTRUMENTATION
+        invokes.fetch_add(1, std::memory_order_relaxed);
+#endif
+        for (auto& subscriber : *subscribers.load()) {
+            if (subscriber->active.load()) {
+#if EVENT_INSTRUMENTATION
+                // Async subscribers are timed where they run, not where they are queued.
+                ScopedLatency timer(subscriber->async ? nullptr : &subscriber->executionTime);
+#endif
+                subscriber->callback(args...);
+            }
         }
     }
 
     void clear() {
-        callbacks.clear();
+        std::unique_lock<std::mutex> lock(writeMutex);
+        for (auto& subscriber : *subscribers.load()) {
+            subscriber->active.store(false);
+        }
+        publish(new SubscriberList(), lock);
+    }
+
+    size_t subscriberCount() const {
+        size_t count = 0;
+        for (auto& subscriber : *subscribers.load()) {
+            count += subscriber->active.load() ? 1 : 0;
+        }
+        return count;
     }
 
+    const std::shared_ptr<EventDispatchStats>& dispatchStats() const {
+        return stats;
+    }
+
+    // Starts recording invokes into the journal, or stops with null. Stopping waits until no
+    // invoke is still writing to the old journal, so it must not be called from a callback.
+    // Events whose payload has no JournalCodec are never recorded.
+    void attachJournal(EventJournal* sink) {
+        if (!journal.exchange(sink) || sink) {
+            return;
+        }
+        grace->invocations.synchronize();
+    }
+
+    // Decodes a recorded payload and invokes the event with it.
+    bool replay(const char* data, size_t size) {
+        if constexpr (JournalSupported<Args...>::value) {
+            std::tuple<Args...> payload;
+            if (!decodeJournalPayload(data, size, payload)) {
+                return false;
+            }
+            std::apply([this](const Args&... args) { invoke(args...); }, payload);
+            return true;
+        } else {
+            (void)data;
+            (void)size;
+            return false;
+        }
+    }
+
+#if EVENT_INSTRUMENTATION
+    EventMetrics metrics() {
+        EventReaders::Guard guard(grace->invocations);
+        EventMetrics result{invokes.load(std::memory_order_relaxed), 0, {}};
+        for (auto& subscriber : *subscribers.load()) {
+            if (subscriber->active.load()) {
+                result.subscriberMetrics.push_back({subscriber->id, subscriber->async, subscriber->executionTime.summarize()});
+            }
+        }
+        result.subscribers = result.subscriberMetrics.size();
+        return result;
+    }
+#endif
+
 private:
-    std::list<EventCallback> callbacks;
+    struct Subscriber {
+        EventCallback callback;
+        std::atomic<bool> active{true};
+#if EVENT_INSTRUMENTATION
+        uint32_t id = 0;
+        bool async = false;
+        LatencyHistogram executionTime;
+#endif
+    };
+
+    struct AsyncDispatch : std::enable_shared_from_this<AsyncDispatch> {
+        using Payload = std::tuple<Args...>;
+
+        std::shared_ptr<Executor> executor;
+        EventCallback callback;
+        KeyFunction key;
+        std::shared_ptr<EventDispatchStats> stats;
+        std::shared_ptr<EventGracePeriods> grace;
+        std::weak_ptr<Subscriber> self;
+
+        std::mutex pendingMutex;
+        std::unordered_map<std::string, Payload> pending;
+
+        void enqueue(const Args&... args) {
+            auto queuedAt = std::chrono::steady_clock::now();
+            std::string coalesceKey = key ? key(args...) : std::string();
+            if (!coalesceKey.empty()) {
+                std::lock_guard<std::mutex> lock(pendingMutex);
+                auto it = pending.find(coalesceKey);
+                if (it != pending.end()) {
+                    it->second = Payload(args...);
+                    stats->coalesced.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                pending.emplace(coalesceKey, Payload(args...));
+            }
+
+            stats->queued.fetch_add(1, std::memory_order_relaxed);
+            auto dispatch = this->shared_from_this();
+            if (coalesceKey.empty()) {
+                executor->post([dispatch, queuedAt, payload = Payload(args...)]() {
+                    dispatch->run(queuedAt, payload);
+                });
+            } else {
+                executor->post([dispatch, queuedAt, coalesceKey = std::move(coalesceKey)]() {
+                    typename std::unordered_map<std::string, Payload>::node_type node;
+                    {
+                        std::lock_guard<std::mutex> lock(dispatch->pendingMutex);
+                        node = dispatch->pending.extract(coalesceKey);
+                    }
+                    dispatch->run(queuedAt, node.mapped());
+                });
+            }
+        }
+
+        void run(std::chrono::steady_clock::time_point queuedAt, const Payload& payload) {
+            stats->recordDispatch(queuedAt);
+            EventReaders::Guard guard(grace->dispatches);
+            auto subscriber = self.lock();
+            if (subscriber && subscriber->active.load()) {
+#if EVENT_INSTRUMENTATION
+                ScopedLatency timer(&subscriber->executionTime);
+#endif
+                std::apply(callback, payload);
+            }
+        }
+    };
+
+    using SubscriberList = std::vector<std::shared_ptr<Subscriber>>;
+
+    const std::string name;
+    std::atomic<EventJournal*> journal{nullptr};
+    std::atomic<const SubscriberList*> subscribers;
+    std::shared_ptr<EventGracePeriods> grace;
+    std::mutex writeMutex;
+    std::vector<const SubscriberList*> retired;
+    std::shared_ptr<EventDispatchStats> stats;
+#if EVENT_INSTRUMENTATION
+    std::atomic<uint64_t> invokes{0};
+    std::atomic<uint32_t> nextSubscriberId{1};
+#endif
+
+    EventSubscription makeSubscription(const std::shared_ptr<Subscriber>& subscriber) {
+        return EventSubscription(std::shared_ptr<std::atomic<bool>>(subscriber, &subscriber->active), grace);
+    }
+
+    // Unsubscribed entries are only flagged inactive; they are dropped here, when the next
+    // subscriber is added and the list is copied anyway.
+    void add(std::shared_ptr<Subscriber> subscriber) {
+        std::unique_lock<std::mutex> lock(writeMutex);
+        auto next = new SubscriberList();
+        for (auto& existing : *subscribers.load()) {
+            if (existing->active.load()) {
+                next->push_back(existing);
+            }
+        }
+        next->push_back(std::move(subscriber));
+        publish(next, lock);
+    }
+
+    // Swaps in a new snapshot and frees the old one once no reader can see it. The grace period
+    // is waited out without holding writeMutex, so a callback may itself subscribe; publishing
+    // from inside a callback defers the free to the next publish made outside of one.
+    void publish(const SubscriberList* next, std::unique_lock<std::mutex>& lock) {
+        retired.push_back(subscribers.exchange(next));
+        if (EventReaders::insideInvoke()) {
+            return;
+        }
+        auto garbage = std::move(retired);
+        retired.clear();
+        lock.unlock();
+
+        grace->invocations.synchronize();
+        for (auto list : garbage) {
+            delete list;
+        }
+    }
+};
+
+// Compile-time description of an event: its name and payload types. Declared once with
+// DECLARE_EVENT and used as the template argument of EventChannel.
+template<typename Signature>
+struct EventTag;
+
+template<typename... Args>
+struct EventTag<void(Args...)> {
+    using EventType = Event<typename std::decay<Args>::type...>;
 };
 
 class EventManager {
 public:
+    ~EventManager() {
+        stopJournal();
+        stopMetricsDump();
+    }
+
     template<typename... Args>
     void createEvent(const std::string& eventName) {
         std::lock_guard<std::mutex> lock(mutex);
-        events[eventName] = std::make_shared<Event<Args...>>();
-        clearFunctions[eventName] = [this, eventName]() {
-            std::any_cast<std::shared_ptr<Event<Args...>>&>(events[eventName])->clear();
-        };
+        createEventLocked<Event<Args...>>(eventName);
+    }
+
+    // Finds or creates the event behind a typed tag. Channels and the string API share the
+    // same Event object, so callers can be migrated one at a time.
+    template<typename Tag>
+    std::shared_ptr<typename Tag::EventType> registerChannel() {
+        using EventType = typename Tag::EventType;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = events.find(Tag::name);
+        if (it != events.end() && !std::any_cast<std::shared_ptr<EventType>>(&it->second)) {
+            throw std::logic_error(std::string("Event '") + Tag::name + "' already exists with a different signature.");
+        }
+        return createEventLocked<EventType>(Tag::name);
     }
 
     template<typename... Args>
@@ -73,13 +540,37 @@ public:
     }
 
     template<typename... Args>
-    void subscribe(const std::string& eventName, typename Event<Args...>::EventCallback callback) {
-        getEvent<Args...>(eventName)->subscribe(callback);
+    EventSubscription subscribe(const std::string& eventName, typename Event<Args...>::EventCallback callback) {
+        return getEvent<Args...>(eventName)->subscribe(callback);
+    }
+
+    template<typename Func>
+    EventSubscription subscribeHelper(const std::string& eventName, Func callback) {
+        return subscribeHelperImpl(eventName, callback, &Func::operator());
+    }
+
+    template<typename... Args>
+    EventSubscription subscribeAsync(const std::string& eventName, std::shared_ptr<Executor> executor,
+                                     typename Event<Args...>::EventCallback callback) {
+        return getEvent<Args...>(eventName)->subscribeAsync(std::move(executor), callback);
+    }
+
+    template<typename... Args>
+    EventSubscription subscribeCoalesced(const std::string& eventName, std::shared_ptr<Executor> executor,
+                                         typename Event<Args...>::KeyFunction key,
+                                         typename Event<Args...>::EventCallback callback) {
+        return getEvent<Args...>(eventName)->subscribeCoalesced(std::move(executor), std::move(key), callback);
+    }
+
+    template<typename KeyFunc, typename Func>
+    EventSubscription subscribeCoalescedHelper(const std::string& eventName, std::shared_ptr<Executor> executor,
+                                               KeyFunc key, Func callback) {
+        return subscribeCoalescedHelperImpl(eventName, std::move(executor), key, callback, &Func::operator());
     }
 
     template<typename Func>
-    void subscribeHelper(const std::string& eventName, Func callback) {
-        subscribeHelperImpl(eventName, callback, &Func::operator());
+    EventSubscription subscribeAsyncHelper(const std::string& eventName, std::shared_ptr<Executor> executor, Func callback) {
+        return subscribeAsyncHelperImpl(eventName, std::move(executor), callback, &Func::operator());
     }
 
     template<typename... Args>
@@ -100,7 +591,17 @@ public:
     void removeEvent(const std::string& eventName) {
         std::lock_guard<std::mutex> lock(mutex);
         events.erase(eventName);
+        auto journalIt = journalFunctions.find(eventName);
+        if (journalIt != journalFunctions.end()) {
+            journalIt->second(nullptr);
+            journalFunctions.erase(journalIt);
+        }
         clearFunctions.erase(eventName);
+        replayFunctions.erase(eventName);
+        dispatchStats.erase(eventName);
+#if EVENT_INSTRUMENTATION
+        metricsFunctions.erase(eventName);
+#endif
     }
 
     void clearEvent(const std::string& eventName) {
@@ -123,14 +624,239 @@ public:
         return events.size();
     }
 
+    EventDispatchStats::Snapshot getDispatchStats(const std::string& eventName) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = dispatchStats.find(eventName);
+        if (it == dispatchStats.end()) {
+            throw std::out_of_range("Event '" + eventName + "' does not exist.");
+        }
+        return it->second->snapshot();
+    }
+
+#if EVENT_INSTRUMENTATION
+    std::map<std::string, EventMetrics> getEventMetrics() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::map<std::string, EventMetrics> result;
+        for (auto& [name, metricsFunc] : metricsFunctions) {
+            result[name] = metricsFunc();
+        }
+        return result;
+    }
+#endif
+
+    void dumpMetrics(std::ostream& out) const {
+#if EVENT_INSTRUMENTATION
+        auto metrics = getEventMetrics();
+        for (auto& [name, dispatch] : getAllDispatchStats()) {
+            auto& event = metrics[name];
+            out << "[events] " << name << " invokes=" << event.invokes << " subscribers=" << event.subscribers
+                << " queue=" << dispatch.queueDepth << " dispatched=" << dispatch.dispatched
+                << " coalesced=" << dispatch.coalesced << " avg_wait=" << dispatch.averageLatencyUs << "us"
+                << " max_wait=" << dispatch.maxLatencyUs << "us\n";
+            for (auto& subscriber : event.subscriberMetrics) {
+                auto& time = subscriber.executionTime;
+                out << "    subscriber #" << subscriber.id << (subscriber.async ? " (async)" : "")
+                    << " calls=" << time.count << " p50=" << time.p50Ns / 1000 << "us p90=" << time.p90Ns / 1000
+                    << "us p99=" << time.p99Ns / 1000 << "us p99.9=" << time.p999Ns / 1000
+                    << "us max=" << time.maxNs / 1000 << "us\n";
+            }
+        }
+        out.flush();
+#else
+        (void)out;
+#endif
+    }
+
+    // Writes dumpMetrics to stdout on a fixed schedule. A no-op without EVENT_INSTRUMENTATION.
+    void startMetricsDump(std::chrono::milliseconds interval) {
+#if EVENT_INSTRUMENTATION
+        stopMetricsDump();
+        std::lock_guard<std::mutex> lock(dumpMutex);
+        dumpTimer = timerWheel.scheduleEvery(interval, [this]() {
+            dumpMetrics(std::cout);
+        });
+#else
+        (void)interval;
+#endif
+    }
+
+    void stopMetricsDump() {
+        std::lock_guard<std::mutex> lock(dumpMutex);
+        if (dumpTimer) {
+            timerWheel.cancel(dumpTimer);
+            dumpTimer = 0;
+        }
+    }
+
+    // Shared timer thread for delayed and periodic work, started on first use.
+    TimerWheel& timers() {
+        return timerWheel;
+    }
+
+    // Records every invoke of every event into a memory-mapped journal of fixed capacity,
+    // replacing a journal that is already open. Returns false if the file cannot be created.
+    bool startJournal(const std::string& path, size_t capacityBytes) {
+        auto opened = EventJournal::open(path, capacityBytes);
+        if (!opened) {
+            return false;
+        }
+        stopJournal();
+        std::lock_guard<std::mutex> lock(mutex);
+        journal = std::move(opened);
+        for (auto& [name, attach] : journalFunctions) {
+            attach(journal.get());
+        }
+        return true;
+    }
+
+    void stopJournal() {
+        std::shared_ptr<EventJournal> closing;
+        std::vector<std::function<void(EventJournal*)>> detach;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = std::move(journal);
+            journal.reset();
+            for (auto& [name, attach] : journalFunctions) {
+                detach.push_back(attach);
+            }
+        }
+        if (!closing) {
+            return;
+        }
+        // Detached outside the lock: waiting for in-flight invokes must not block subscribers.
+        for (auto& attach : detach) {
+            attach(nullptr);
+        }
+        std::cout << "Event journal closed: " << closing->recordedCount() << " records, "
+                  << closing->droppedCount() << " dropped" << std::endl;
+    }
+
+    enum class ReplaySpeed {
+        RealTime,
+        AsFastAsPossible
+    };
+
+    // Re-injects a journal into the events of the same name, in order and on the calling thread.
+    // RealTime keeps the recorded spacing between invokes. Returns the number of records
+    // replayed; records of unknown events or with undecodable payloads are skipped.
+    size_t replayJournal(const std::string& path, ReplaySpeed speed) {
+        EventJournalReader reader(path);
+        if (!reader.isValid()) {
+            return 0;
+        }
+        size_t replayed = 0;
+        size_t skipped = 0;
+        bool first = true;
+        uint64_t firstTimestampNs = 0;
+        auto start = std::chrono::steady_clock::now();
+        EventJournalReader::Record record{};
+        while (reader.next(record)) {
+            std::function<bool(const char*, size_t)> replay;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = replayFunctions.find(std::string(record.name));
+                if (it != replayFunctions.end()) {
+                    replay = it->second;
+                }
+            }
+            if (first) {
+                firstTimestampNs = record.timestampNs;
+                first = false;
+            }
+            if (speed == ReplaySpeed::RealTime) {
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds(record.timestampNs - firstTimestampNs));
+            }
+            if (replay && replay(record.payload, record.payloadSize)) {
+                ++replayed;
+            } else {
+                ++skipped;
+            }
+        }
+        if (skipped) {
+            std::cerr << "Event journal replay skipped " << skipped << " records" << std::endl;
+        }
+        return replayed;
+    }
+
+    std::map<std::string, EventDispatchStats::Snapshot> getAllDispatchStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::map<std::string, EventDispatchStats::Snapshot> result;
+        for (auto& [name, stats] : dispatchStats) {
+            result[name] = stats->snapshot();
+        }
+        return result;
+    }
+
 private:
     mutable std::mutex mutex;
     std::map<std::string, std::any> events;
     std::unordered_map<std::string, std::function<void()>> clearFunctions;
+    std::unordered_map<std::string, std::function<void(EventJournal*)>> journalFunctions;
+    std::unordered_map<std::string, std::function<bool(const char*, size_t)>> replayFunctions;
+    std::shared_ptr<EventJournal> journal;
+    std::unordered_map<std::string, std::shared_ptr<EventDispatchStats>> dispatchStats;
+#if EVENT_INSTRUMENTATION
+    std::unordered_map<std::string, std::function<EventMetrics()>> metricsFunctions;
+#endif
+
+    std::mutex dumpMutex;
+    TimerWheel::TimerId dumpTimer = 0;
+
+    // Declared last so the timer thread stops before anything its callbacks may touch.
+    TimerWheel timerWheel;
+
+    // Keeps an existing event of the same type so channels already handed out stay valid.
+    template<typename EventType>
+    std::shared_ptr<EventType> createEventLocked(const std::string& eventName) {
+        auto it = events.find(eventName);
+        if (it != events.end()) {
+            if (auto existing = std::any_cast<std::shared_ptr<EventType>>(&it->second)) {
+                return *existing;
+            }
+            // The replaced event may still be held elsewhere; it must not keep the journal.
+            auto journalIt = journalFunctions.find(eventName);
+            if (journalIt != journalFunctions.end()) {
+                journalIt->second(nullptr);
+            }
+        }
+        auto event = std::make_shared<EventType>(eventName);
+        events[eventName] = event;
+        clearFunctions[eventName] = [event]() {
+            event->clear();
+        };
+        journalFunctions[eventName] = [event](EventJournal* sink) {
+            event->attachJournal(sink);
+        };
+        replayFunctions[eventName] = [event](const char* data, size_t size) {
+            return event->replay(data, size);
+        };
+        if (journal) {
+            event->attachJournal(journal.get());
+        }
+        dispatchStats[eventName] = event->dispatchStats();
+#if EVENT_INSTRUMENTATION
+        metricsFunctions[eventName] = [event]() {
+            return event->metrics();
+        };
+#endif
+        return event;
+    }
+
+    template<typename Func, typename... Args>
+    EventSubscription subscribeHelperImpl(const std::string& eventName, Func callback, void (Func::*)(Args...) const) {
+        return subscribe<typename std::decay<Args>::type...>(eventName, callback);
+    }
 
     template<typename Func, typename... Args>
-    void subscribeHelperImpl(const std::string& eventName, Func callback, void (Func::*)(Args...) const) {
-        subscribe<typename std::decay<Args>::type...>(eventName, callback);
+    EventSubscription subscribeAsyncHelperImpl(const std::string& eventName, std::shared_ptr<Executor> executor, Func callback,
+                                               void (Func::*)(Args...) const) {
+        return subscribeAsync<typename std::decay<Args>::type...>(eventName, std::move(executor), callback);
+    }
+
+    template<typename KeyFunc, typename Func, typename... Args>
+    EventSubscription subscribeCoalescedHelperImpl(const std::string& eventName, std::shared_ptr<Executor> executor,
+                                                   KeyFunc key, Func callback, void (Func::*)(Args...) const) {
+        return subscribeCoalesced<typename std::decay<Args>::type...>(eventName, std::move(executor), key, callback);
     }
 };
 
@@ -139,11 +865,94 @@ inline EventManager& GetEventManager() {
     return instance;
 }
 
+// Cheap typed handle to an event declared with DECLARE_EVENT. The event is resolved once,
+// after which invoke is a direct call: no map lookup, no string hashing and no lock.
+// Payload type mismatches are compile errors instead of a bad_any_cast at runtime.
+template<typename Tag>
+class EventChannel {
+public:
+    using EventType = typename Tag::EventType;
+    using EventCallback = typename EventType::EventCallback;
+
+    explicit EventChannel(std::shared_ptr<EventType> event) : event(std::move(event)) {}
+
+    template<typename... Args>
+    void invoke(Args&&... args) const {
+        event->invoke(std::forward<Args>(args)...);
+    }
+
+    EventSubscription subscribe(EventCallback callback) const {
+        return event->subscribe(std::move(callback));
+    }
+
+    void unsubscribe(EventCallback callback) const {
+        event->unsubscribe(std::move(callback));
+    }
+
+    EventSubscription subscribeAsync(std::shared_ptr<Executor> executor, EventCallback callback) const {
+        return event->subscribeAsync(std::move(executor), std::move(callback));
+    }
+
+    EventSubscription subscribeCoalesced(std::shared_ptr<Executor> executor, typename EventType::KeyFunction key,
+                                         EventCallback callback) const {
+        return event->subscribeCoalesced(std::move(executor), std::move(key), std::move(callback));
+    }
+
+    // Invokes the event from the timer thread once the delay has passed. The payload is copied
+    // now; cancel with GetEventManager().timers().cancel(id).
+    template<typename... Args>
+    TimerWheel::TimerId invokeAfter(TimerWheel::Clock::duration delay, Args&&... args) const {
+        return GetEventManager().timers().scheduleAfter(delay, bindInvoke(std::forward<Args>(args)...));
+    }
+
+    template<typename... Args>
+    TimerWheel::TimerId invokeAt(TimerWheel::Clock::time_point deadline, Args&&... args) const {
+        return GetEventManager().timers().scheduleAt(deadline, bindInvoke(std::forward<Args>(args)...));
+    }
+
+    template<typename... Args>
+    TimerWheel::TimerId invokeEvery(TimerWheel::Clock::duration period, Args&&... args) const {
+        return GetEventManager().timers().scheduleEvery(period, bindInvoke(std::forward<Args>(args)...));
+    }
+
+    EventDispatchStats::Snapshot dispatchStats() const {
+        return event->dispatchStats()->snapshot();
+    }
+
+    const char* name() const { return Tag::name; }
+
+private:
+    std::shared_ptr<EventType> event;
+
+    template<typename... Args>
+    TimerWheel::Callback bindInvoke(Args&&... args) const {
+        return [event = event, payload = std::make_tuple(typename std::decay<Args>::type(std::forward<Args>(args))...)]() {
+            std::apply([&event](const auto&... values) { event->invoke(values...); }, payload);
+        };
+    }
+};
+
+template<typename Tag>
+EventChannel<Tag>& GetEventChannel() {
+    static EventChannel<Tag> channel(GetEventManager().registerChannel<Tag>());
+    return channel;
+}
+
+#define DECLARE_EVENT(tagName, eventName, ...) \
+    struct tagName : EventTag<void(__VA_ARGS__)> { static constexpr const char* name = eventName; }
+
 #define CREATE_EVENT(eventName, ...) \
     GetEventManager().createEventHelper(eventName, static_cast<void (*)(__VA_ARGS__)>(nullptr))
 
+// The macros keep their subscriptions for the lifetime of the event.
 #define SUBSCRIBE_TO_EVENT(eventName, callback) \
-    GetEventManager().subscribeHelper(eventName, callback)
+    GetEventManager().subscribeHelper(eventName, callback).release()
+
+#define SUBSCRIBE_TO_EVENT_ASYNC(eventName, executor, callback) \
+    GetEventManager().subscribeAsyncHelper(eventName, executor, callback).release()
+
+#define SUBSCRIBE_TO_EVENT_COALESCED(eventName, executor, keyFunction, callback) \
+    GetEventManager().subscribeCoalescedHelper(eventName, executor, keyFunction, callback).release()
 
 #define INVOKE_EVENT(eventName, ...) \
     GetEventManager().invokeHelper(eventName, ##__VA_ARGS__)
@@ -0,0 +1,149 @@
+#ifndef BASE_EXECUTOR_H
+#define BASE_EXECUTOR_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+// Runs tasks posted by asynchronous event subscriptions. post() must not block the caller.
+class Executor {
+public:
+    using Task = std::function<void()>;
+
+    virtual ~Executor() = default;
+
+    virtual void post(Task task) = 0;
+};
+
+// A pool of worker threads sharing one queue. A pool of one is a dedicated thread.
+class ThreadPoolExecutor : public Executor {
+public:
+    explicit ThreadPoolExecutor(size_t threadCount = std::thread::hardware_concurrency())
+        : state(std::make_shared<State>()) {
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back(&ThreadPoolExecutor::run, state);
+        }
+    }
+
+    // Drains the tasks that are already queued, then joins the workers. Tasks may own the last
+    // reference to their executor; a worker that ends up here is detached instead of joined and
+    // finishes on the shared state.
+    ~ThreadPoolExecutor() override {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->stopping = true;
+        }
+        state->condition.notify_all();
+        for (auto& worker : workers) {
+            if (worker.get_id() == std::this_thread::get_id()) {
+                worker.detach();
+            } else if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    void post(Task task) override {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->tasks.push_back(std::move(task));
+        }
+        state->condition.notify_one();
+    }
+
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->tasks.size();
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<Task> tasks;
+        bool stopping = false;
+    };
+
+    std::shared_ptr<State> state;
+    std::vector<std::thread> workers;
+
+    static void run(std::shared_ptr<State> state) {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                state->condition.wait(lock, [&state] { return state->stopping || !state->tasks.empty(); });
+                if (state->tasks.empty()) {
+                    return;
+                }
+                task = std::move(state->tasks.front());
+                state->tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+class ThreadExecutor : public ThreadPoolExecutor {
+public:
+    ThreadExecutor() : ThreadPoolExecutor(1) {}
+};
+
+// Serialises tasks on top of another executor: tasks posted to the same strand run one at a
+// time and in order, while different strands share the underlying threads.
+class StrandExecutor : public Executor, public std::enable_shared_from_this<StrandExecutor> {
+public:
+    static std::shared_ptr<StrandExecutor> create(std::shared_ptr<Executor> executor) {
+        return std::shared_ptr<StrandExecutor>(new StrandExecutor(std::move(executor)));
+    }
+
+    void post(Task task) override {
+        bool schedule = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+            if (!scheduled) {
+                scheduled = true;
+                schedule = true;
+            }
+        }
+        if (schedule) {
+            auto self = shared_from_this();
+            executor->post([self]() { self->drain(); });
+        }
+    }
+
+private:
+    explicit StrandExecutor(std::shared_ptr<Executor> executor) : executor(std::move(executor)) {}
+
+    std::shared_ptr<Executor> executor;
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    bool scheduled = false;
+
+    void drain() {
+        while (true) {
+            Task task;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (tasks.empty()) {
+                    scheduled = false;
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+#endif // BASE_EXECUTOR_H
@@ -0,0 +1,271 @@
+#ifndef BASE_TIMERWHEEL_H
+#define BASE_TIMERWHEEL_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Hierarchical timer wheel driven by a single thread. Four levels of 64 slots at a 1 ms tick
+// cover about 4.6 hours; later deadlines wait in the top level and are re-cascaded. Insert and
+// cancel are O(1). Deadlines are absolute, so periodic timers do not drift: each run is
+// scheduled one period after the previous deadline, not after the previous run finished.
+// Callbacks run on the timer thread and should hand long work to an executor.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    explicit TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(1))
+        : tick(tick), origin(Clock::now()) {}
+
+    ~TimerWheel() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        condition.notify_all();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    TimerId scheduleAt(Clock::time_point deadline, Callback callback) {
+        return add(deadline, Clock::duration::zero(), std::move(callback));
+    }
+
+    TimerId scheduleAfter(Clock::duration delay, Callback callback) {
+        return add(Clock::now() + delay, Clock::duration::zero(), std::move(callback));
+    }
+
+    TimerId scheduleEvery(Clock::duration period, Callback callback) {
+        return add(Clock::now() + period, period, std::move(callback));
+    }
+
+    TimerId scheduleEvery(Clock::duration period, Clock::time_point firstDeadline, Callback callback) {
+        return add(firstDeadline, period, std::move(callback));
+    }
+
+    // Returns false if the timer already fired (one-shot) or does not exist. If the callback is
+    // running on the timer thread, waits for it to return unless called from that callback.
+    bool cancel(TimerId id) {
+        std::unique_lock<std::mutex> lock(mutex);
+        bool found = timers.erase(id) > 0;
+        if (expiries.size() > 2 * timers.size() + 64) {
+            rebuildExpiries();
+        }
+        if (std::this_thread::get_id() != thread.get_id()) {
+            idle.wait(lock, [this, id] { return firing != id; });
+        }
+        return found;
+    }
+
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return timers.size();
+    }
+
+private:
+    static constexpr int LevelBits = 6;
+    static constexpr size_t SlotsPerLevel = size_t(1) << LevelBits;
+    static constexpr int Levels = 4;
+
+    struct Timer {
+        Clock::time_point deadline;
+        Clock::duration period;
+        uint64_t expiry;
+        Callback callback;
+    };
+
+    const Clock::duration tick;
+    const Clock::time_point origin;
+
+    mutable std::mutex mutex;
+    std::condition_variable condition;
+    std::condition_variable idle;
+    std::thread thread;
+    bool running = false;
+
+    std::unordered_map<TimerId, Timer> timers;
+    std::array<std::array<std::vector<TimerId>, SlotsPerLevel>, Levels> wheel;
+    // Expiry of every armed timer, earliest on top. Entries of cancelled, fired or re-armed timers
+    // stay until they reach the top, or until cancel finds more stale entries than live ones.
+    using Expiry = std::pair<uint64_t, TimerId>;
+    std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry>> expiries;
+    uint64_t currentTick = 0;
+    TimerId nextId = 1;
+    TimerId firing = 0;
+
+    // Deadlines round up to the next tick and the clock rounds down, so nothing fires early.
+    uint64_t tickFor(Clock::time_point deadline) const {
+        if (deadline <= origin) {
+            return 0;
+        }
+        return static_cast<uint64_t>((deadline - origin + tick - Clock::duration(1)) / tick);
+    }
+
+    uint64_t elapsedTicks() const {
+        return static_cast<uint64_t>((Clock::now() - origin) / tick);
+    }
+
+    TimerId add(Clock::time_point deadline, Clock::duration period, Callback callback) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            running = true;
+            thread = std::thread(&TimerWheel::run, this);
+        }
+        if (timers.empty()) {
+            // Nothing is pending, so idle ticks can be skipped instead of walked.
+            currentTick = std::max(currentTick, elapsedTicks());
+        }
+        TimerId id = nextId++;
+        Timer& timer = timers[id];
+        timer = Timer{deadline, period, std::max(tickFor(deadline), currentTick + 1), std::move(callback)};
+        place(id, timer.expiry);
+        expiries.emplace(timer.expiry, id);
+        condition.notify_all();
+        return id;
+    }
+
+    // Puts a timer in the lowest level where its expiry shares the current tick's higher bits,
+    // so the slot is reached before the level wraps. Expiries beyond the top level park in the
+    // slot visited last and are placed again when it cascades.
+    void place(TimerId id, uint64_t expiry) {
+        for (int level = 0; level < Levels; ++level) {
+            int shift = LevelBits * (level + 1);
+            if ((expiry >> shift) == (currentTick >> shift)) {
+                wheel[level][(expiry >> (LevelBits * level)) & (SlotsPerLevel - 1)].push_back(id);
+                return;
+            }
+        }
+        int top = LevelBits * (Levels - 1);
+        wheel[Levels - 1][((currentTick >> top) + SlotsPerLevel - 1) & (SlotsPerLevel - 1)].push_back(id);
+    }
+
+    // Tick boundary of the earliest pending expiry; the thread sleeps until then instead of ticking.
+    Clock::time_point nextWake() {
+        while (!expiries.empty()) {
+            auto [expiry, id] = expiries.top();
+            auto it = timers.find(id);
+            if (it != timers.end() && it->second.expiry == expiry) {
+                return origin + tick * static_cast<Clock::rep>(expiry);
+            }
+            expiries.pop();
+        }
+        return Clock::time_point::max();
+    }
+
+    void rebuildExpiries() {
+        std::vector<Expiry> live;
+        live.reserve(timers.size());
+        for (auto& [id, timer] : timers) {
+            live.emplace_back(timer.expiry, id);
+        }
+        expiries = decltype(expiries)(std::greater<Expiry>(), std::move(live));
+    }
+
+    // Advances one tick: cascades every level whose lower levels just wrapped, top-down so a
+    // timer can fall through several levels in one step, then collects the due level-0 slot.
+    void advance(std::vector<TimerId>& due) {
+        ++currentTick;
+        int highest = 0;
+        while (highest + 1 < Levels && (currentTick & ((uint64_t(1) << (LevelBits * (highest + 1))) - 1)) == 0) {
+            ++highest;
+        }
+        for (int level = highest; level >= 1; --level) {
+            auto& slot = wheel[level][(currentTick >> (LevelBits * level)) & (SlotsPerLevel - 1)];
+            std::vector<TimerId> cascading;
+            cascading.swap(slot);
+            for (TimerId id : cascading) {
+                auto it = timers.find(id);
+                if (it != timers.end()) {
+                    place(id, std::max(it->second.expiry, currentTick));
+                }
+            }
+        }
+
+        auto& slot = wheel[0][currentTick & (SlotsPerLevel - 1)];
+        std::vector<TimerId> expiring;
+        expiring.swap(slot);
+        for (TimerId id : expiring) {
+            auto it = timers.find(id);
+            if (it == timers.end()) {
+                continue;
+            }
+            if (it->second.expiry <= currentTick) {
+                due.push_back(id);
+            } else {
+                place(id, it->second.expiry);
+            }
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::vector<TimerId> due;
+        while (running) {
+            uint64_t target = elapsedTicks();
+            if (timers.empty()) {
+                currentTick = std::max(currentTick, target);
+            }
+            while (currentTick < target) {
+                advance(due);
+            }
+
+            for (TimerId id : due) {
+                auto it = timers.find(id);
+                if (it == timers.end()) {
+                    continue;
+                }
+                Callback callback = it->second.period == Clock::duration::zero()
+                        ? std::move(it->second.callback) : it->second.callback;
+                if (it->second.period == Clock::duration::zero()) {
+                    timers.erase(it);
+                }
+
+                firing = id;
+                lock.unlock();
+                callback();
+                lock.lock();
+                firing = 0;
+                idle.notify_all();
+
+                it = timers.find(id);
+                if (it != timers.end()) {
+                    Timer& timer = it->second;
+                    timer.deadline += timer.period;
+                    auto now = Clock::now();
+                    if (timer.deadline <= now) {
+                        // Overran by more than a period: skip the missed runs, keep the phase.
+                        auto missed = (now - timer.deadline) / timer.period + 1;
+                        timer.deadline += timer.period * missed;
+                    }
+                    timer.expiry = std::max(tickFor(timer.deadline), currentTick + 1);
+                    place(id, timer.expiry);
+                    expiries.emplace(timer.expiry, id);
+                }
+            }
+            due.clear();
+
+            auto wake = nextWake();
+            if (wake == Clock::time_point::max()) {
+                condition.wait(lock);
+            } else {
+                condition.wait_until(lock, wake);
+            }
+        }
+    }
+};
+
+#endif // BASE_TIMERWHEEL_H
@@ -0,0 +1,371 @@
+#include "BinaryProtocol.h"
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace BinaryProtocol {
+
+namespace {
+
+constexpr std::array<uint16_t, 256> makeCrcTable() {
+    std::array<uint16_t, 256> table{};
+    for (int i = 0; i < 256; ++i) {
+        uint16_t crc = static_cast<uint16_t>(i << 8);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint16_t, 256> CrcTable = makeCrcTable();
+
+uint16_t readU16(const char* data) {
+    auto bytes = reinterpret_cast<const uint8_t*>(data);
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+void appendU16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+template<typename T>
+void appendValue(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template<typename T>
+bool readValue(std::string_view& in, double& value) {
+    if (in.size() < sizeof(T)) {
+        return false;
+    }
+    T raw;
+    std::memcpy(&raw, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    value = static_cast<double>(raw);
+    return true;
+}
+
+bool encodeCommandPayload(std::string& out, MessageId id, std::string_view prefix, const Field* fields, size_t fieldCount) {
+    if (fieldCount > ParsedCommand::MaxParameters) {
+        return false;
+    }
+    std::string payload;
+    payload.reserve(prefix.size() + 1 + fieldCount * 9);
+    payload.append(prefix.data(), prefix.size());
+    payload.push_back(static_cast<char>(fieldCount));
+    for (size_t i = 0; i < fieldCount; ++i) {
+        payload.push_back(static_cast<char>(fields[i].type));
+        switch (fields[i].type) {
+            case FieldType::Float32: appendValue(payload, static_cast<float>(fields[i].value)); break;
+            case FieldType::Float64: appendValue(payload, fields[i].value); break;
+            case FieldType::Int32: appendValue(payload, static_cast<int32_t>(fields[i].value)); break;
+            case FieldType::UInt16: appendValue(payload, static_cast<uint16_t>(fields[i].value)); break;
+        }
+    }
+    return encodeFrame(out, id, payload);
+}
+
+}
+
+const char* frameStatusString(FrameStatus status) {
+    switch (status) {
+        case FrameStatus::Ok: return "ok";
+        case FrameStatus::Incomplete: return "incomplete frame";
+        case FrameStatus::BadMagic: return "bad magic byte";
+        case FrameStatus::UnsupportedVersion: return "unsupported version";
+        case FrameStatus::TooLarge: return "frame too large";
+        case FrameStatus::BadCrc: return "CRC mismatch";
+    }
+    return "unknown status";
+}
+
+uint16_t crc16(const uint8_t* data, size_t size, uint16_t crc) {
+    for (size_t i = 0; i < size; ++i) {
+        crc = static_cast<uint16_t>((crc << 8) ^ CrcTable[((crc >> 8) ^ data[i]) & 0xFF]);
+    }
+    return crc;
+}
+
+DecodeResult decodeFrame(std::string_view buffer, Frame& frame) {
+    if (buffer.empty()) {
+        return {FrameStatus::Incomplete, 0};
+    }
+    if (static_cast<uint8_t>(buffer[0]) != Magic) {
+        return {FrameStatus::BadMagic, 1};
+    }
+    if (buffer.size() < HeaderSize) {
+        return {FrameStatus::Incomplete, 0};
+    }
+    size_t length = readU16(buffer.data() + 3);
+    if (length > MaxPayload) {
+        return {FrameStatus::TooLarge, 1};
+    }
+    size_t total = HeaderSize + length + CrcSize;
+    if (buffer.size() < total) {
+        return {FrameStatus::Incomplete, 0};
+    }
+
+    auto bytes = reinterpret_cast<const uint8_t*>(buffer.data());
+    if (crc16(bytes + 1, HeaderSize - 1 + length) != readU16(buffer.data() + HeaderSize + length)) {
+        // The length may be what got corrupted, so resynchronise on the next byte
+        return {FrameStatus::BadCrc, 1};
+    }
+
+    frame.version = bytes[1];
+    frame.id = static_cast<MessageId>(bytes[2]);
+    frame.payload = buffer.substr(HeaderSize, length);
+    if (frame.version != Version) {
+        return {FrameStatus::UnsupportedVersion, total};
+    }
+    return {FrameStatus::Ok, total};
+}
+
+StreamScan scanStream(std::string_view buffer, size_t maxLineLength) {
+    StreamScan scan;
+    while (scan.complete < buffer.size()) {
+        std::string_view rest = buffer.substr(scan.complete);
+        if (static_cast<uint8_t>(rest[0]) == Magic) {
+            if (rest.size() < HeaderSize) {
+                break;
+            }
+            size_t length = readU16(rest.data() + 3);
+            if (length > MaxPayload) {
+                scan.error = FrameStatus::TooLarge;
+                break;
+            }
+            if (rest.size() < HeaderSize + length + CrcSize) {
+                break;
+            }
+            scan.complete += HeaderSize + length + CrcSize;
+        } else {
+            size_t newline = rest.find('\n');
+            if (newline == std::string_view::npos) {
+                if (rest.size() > maxLineLength) {
+                    scan.error = FrameStatus::TooLarge;
+                }
+                break;
+            }
+            scan.complete += newline + 1;
+        }
+    }
+    return scan;
+}
+
+ParseResult decodeCommand(const Frame& frame, ParsedCommand& command) {
+    command.name = std::string_view();
+    command.id = CommandId::Unknown;
+    command.parameterCount = 0;
+
+    std::string_view in = frame.payload;
+    if (in.empty()) {
+        return {ParseError::EmptyCommand, 0};
+    }
+    if (frame.id == MessageId::CommandById) {
+        command.id = static_cast<CommandId>(in[0]);
+        command.name = commandName(command.id);
+        in.remove_prefix(1);
+        if (static_cast<size_t>(command.id) >= CommandCount || command.id == CommandId::Unknown) {
+            command.id = CommandId::Unknown;
+            return {ParseError::UnknownCommand, 0};
+        }
+    } else {
+        size_t nameLength = static_cast<uint8_t>(in[0]);
+        in.remove_prefix(1);
+        if (nameLength == 0 || in.size() < nameLength) {
+            return {ParseError::EmptyCommand, 1};
+        }
+        command.name = in.substr(0, nameLength);
+        command.id = commandIdFromName(command.name);
+        in.remove_prefix(nameLength);
+        if (command.id == CommandId::Unknown) {
+            return {ParseError::UnknownCommand, 1};
+        }
+    }
+
+    if (in.empty()) {
+        return {ParseError::EmptyParameter, frame.payload.size()};
+    }
+    size_t fieldCount = static_cast<uint8_t>(in[0]);
+    in.remove_prefix(1);
+    if (fieldCount > ParsedCommand::MaxParameters) {
+        return {ParseError::TooManyParameters, frame.payload.size() - in.size() - 1};
+    }
+
+    for (size_t i = 0; i < fieldCount; ++i) {
+        size_t position = frame.payload.size() - in.size();
+        if (in.empty()) {
+            return {ParseError::EmptyParameter, position};
+        }
+        auto type = static_cast<FieldType>(in[0]);
+        in.remove_prefix(1);
+
+        double value = 0.0;
+        bool ok = false;
+        switch (type) {
+            case FieldType::Float32: ok = readValue<float>(in, value); break;
+            case FieldType::Float64: ok = readValue<double>(in, value); break;
+            case FieldType::Int32: ok = readValue<int32_t>(in, value); break;
+            case FieldType::UInt16: ok = readValue<uint16_t>(in, value); break;
+        }
+        if (!ok || !std::isfinite(value)) {
+            return {ParseError::InvalidParameter, position};
+        }
+        command.parameters[command.parameterCount++] = value;
+    }
+    return {};
+}
+
+bool encodeFrame(std::string& out, MessageId id, std::string_view payload) {
+    if (payload.size() > MaxPayload) {
+        return false;
+    }
+    size_t start = out.size();
+    out.reserve(start + HeaderSize + payload.size() + CrcSize);
+    out.push_back(static_cast<char>(Magic));
+    out.push_back(static_cast<char>(Version));
+    out.push_back(static_cast<char>(id));
+    appendU16(out, static_cast<uint16_t>(payload.size()));
+    out.append(payload.data(), payload.size());
+    appendU16(out, crc16(reinterpret_cast<const uint8_t*>(out.data() + start + 1), HeaderSize - 1 + payload.size()));
+    return true;
+}
+
+bool encodeCommand(std::string& out, std::string_view name, const Field* fields, size_t fieldCount) {
+    if (name.empty() || name.size() > 255) {
+        return false;
+    }
+    std::string prefix(1, static_cast<char>(name.size()));
+    prefix.append(name.data(), name.size());
+    return encodeCommandPayload(out, MessageId::Command, prefix, fields, fieldCount);
+}
+
+bool encodeCommand(std::string& out, CommandId id, const Field* fields, size_t fieldCount) {
+    if (id == CommandId::Unknown || static_cast<size_t>(id) >= CommandCount) {
+        return false;
+    }
+    const char prefix = static_cast<char>(id);
+    return encodeCommandPayload(out, MessageId::CommandById, std::string_view(&prefix, 1), fields, fieldCount);
+}
+
+bool encodeHello(std::string& out, uint8_t lowestVersion, uint8_t highestVersion) {
+    const char payload[] = {static_cast<char>(lowestVersion), static_cast<char>(highestVersion)};
+    return encodeFrame(out, MessageId::Hello, std::string_view(payload, sizeof(payload)));
+}
+
+}
+
+namespace {
+// 0 is left for commands that have no peer
+std::atomic<uint32_t> nextClientId{1};
+}
+
+ProtocolSession::ProtocolSession(Framing framing)
+    : client(nextClientId.fetch_add(1, std::memory_order_relaxed)), framing(framing) {
+}
+
+void ProtocolSession::receive(std::string_view data, std::string& reply, const char* transport) {
+    using namespace BinaryProtocol;
+
+    // Text peers that never sent a frame keep the old path with no buffering
+    if (pending.empty() && !isBinary() && data.find(static_cast<char>(Magic)) == std::string_view::npos) {
+        publishCommands(data, transport, client);
+        return;
+    }
+
+    std::string_view buffer = data;
+    if (framing == Framing::Stream) {
+        pending.append(data.data(), data.size());
+        buffer = pending;
+    }
+    while (!buffer.empty()) {
+        if (static_cast<uint8_t>(buffer[0]) != Magic) {
+            size_t next = buffer.find(static_cast<char>(Magic));
+            std::string_view skipped = buffer.substr(0, next);
+            if (isBinary()) {
+                std::cerr << transport << ": skipping " << skipped.size() << " bytes outside a binary frame" << std::endl;
+            } else {
+                publishCommands(skipped, transport, client);
+            }
+            buffer.remove_prefix(skipped.size());
+            continue;
+        }
+
+        Frame frame;
+        DecodeResult result = decodeFrame(buffer, frame);
+        if (result.status == FrameStatus::Incomplete) {
+            if (framing == Framing::Datagram) {
+                // The rest can never arrive: the next datagram starts a message of its own
+                std::cerr << transport << ": discarding " << buffer.size() << " bytes of a truncated binary frame" << std::endl;
+                buffer = std::string_view();
+            }
+            break;
+        }
+        if (result.status == FrameStatus::Ok) {
+            handleFrame(frame, reply, transport);
+        } else {
+            std::cerr << transport << ": discarding binary frame: " << frameStatusString(result.status) << std::endl;
+        }
+        buffer.remove_prefix(result.consumed);
+    }
+    if (framing == Framing::Stream) {
+        pending.erase(0, pending.size() - buffer.size());
+    }
+}
+
+void ProtocolSession::handleFrame(const BinaryProtocol::Frame& frame, std::string& reply, const char* transport) {
+    using namespace BinaryProtocol;
+
+    switch (frame.id) {
+        case MessageId::Hello: {
+            if (frame.payload.size() < 2 || static_cast<uint8_t>(frame.payload[0]) > Version ||
+                static_cast<uint8_t>(frame.payload[1]) < Version) {
+                std::cerr << transport << ": peer offered no supported binary protocol version" << std::endl;
+                encodeHello(reply, 0, 0);
+                return;
+            }
+            binary.store(true, std::memory_order_relaxed);
+            encodeHello(reply, Version, Version);
+            std::cout << transport << ": peer switched to binary protocol v" << int(Version) << std::endl;
+            return;
+        }
+        case MessageId::Command:
+        case MessageId::CommandById: {
+            binary.store(true, std::memory_order_relaxed);
+            ParsedCommand command;
+            ParseResult result = decodeCommand(frame, command);
+            if (!result) {
+                std::cerr << transport << ": invalid binary command: " << parseErrorString(result.error)
+                          << " at offset " << result.position << std::endl;
+                return;
+            }
+            publishCommand(command, client);
+            return;
+        }
+        case MessageId::Text:
+            binary.store(true, std::memory_order_relaxed);
+            publishCommands(frame.payload, transport, client);
+            return;
+    }
+    std::cerr << transport << ": unknown binary message id " << int(frame.id) << std::endl;
+}
+
+std::string ProtocolSession::encodeOutbound(const std::string& message) const {
+    if (!isBinary()) {
+        return message;
+    }
+    std::string framed;
+    // Messages longer than one frame (e.g. telemetry dumps) are split across Text frames
+    size_t offset = 0;
+    do {
+        BinaryProtocol::encodeFrame(framed, BinaryProtocol::MessageId::Text,
+                                    std::string_view(message).substr(offset, BinaryProtocol::MaxPayload));
+        offset += BinaryProtocol::MaxPayload;
+    } while (offset < message.size());
+    return framed;
+}
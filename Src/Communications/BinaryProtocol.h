@@ -0,0 +1,132 @@
+#ifndef BINARYPROTOCOL_H
+#define BINARYPROTOCOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "CommandParser.h"
+
+// Compact binary alternative to the text protocol. All integers are little-endian.
+//
+//   magic (0xA5) | version | message id | payload length (u16) | payload | CRC-16 (u16)
+//
+// The CRC is CRC-16/CCITT-FALSE over everything after the magic byte up to the end of the
+// payload. A Command payload is: name length (u8), name, field count (u8), then per field a
+// BinaryFieldType byte followed by the value. CommandById replaces the name with its CommandId
+// byte. Text frames carry a text protocol message, which is how replies reach peers that
+// negotiated the binary protocol.
+namespace BinaryProtocol {
+
+constexpr uint8_t Magic = 0xA5;
+constexpr uint8_t Version = 1;
+constexpr size_t HeaderSize = 5;
+constexpr size_t CrcSize = 2;
+constexpr size_t MaxPayload = 1024;
+
+enum class MessageId : uint8_t {
+    Hello = 0x01,   // Payload: lowest and highest supported version; the reply carries the chosen one
+    Command = 0x02,
+    Text = 0x03,
+    CommandById = 0x04
+};
+
+enum class FieldType : uint8_t {
+    Float32 = 1,
+    Float64 = 2,    // Latitude and longitude need the full double
+    Int32 = 3,
+    UInt16 = 4      // RC channel values
+};
+
+struct Field {
+    FieldType type;
+    double value;
+};
+
+enum class FrameStatus {
+    Ok,
+    Incomplete,         // Need more bytes
+    BadMagic,
+    UnsupportedVersion, // Well-formed frame of another version; skip it
+    TooLarge,
+    BadCrc
+};
+
+struct Frame {
+    uint8_t version = 0;
+    MessageId id = MessageId::Command;
+    std::string_view payload;   // Points into the decoded buffer
+};
+
+struct DecodeResult {
+    FrameStatus status = FrameStatus::Incomplete;
+    size_t consumed = 0;    // Bytes to drop from the front of the buffer; 0 when incomplete
+};
+
+const char* frameStatusString(FrameStatus status);
+
+uint16_t crc16(const uint8_t* data, size_t size, uint16_t crc = 0xFFFF);
+
+// Decodes the frame at the start of the buffer.
+DecodeResult decodeFrame(std::string_view buffer, Frame& frame);
+
+struct StreamScan {
+    size_t complete = 0;                    // Length of the prefix that holds only whole messages
+    FrameStatus error = FrameStatus::Ok;    // TooLarge when the stream cannot be framed any further
+};
+
+// Splits a byte stream at message boundaries: text lines ending in '\n' and whole binary frames,
+// judged by their length field alone. The CRC is left to the session. A frame over MaxPayload or
+// an unterminated line longer than maxLineLength means the peer is out of sync.
+StreamScan scanStream(std::string_view buffer, size_t maxLineLength);
+
+// Fills command from a Command or CommandById frame. The name points into the frame's payload
+// or, for CommandById, into CommandIds::Names.
+ParseResult decodeCommand(const Frame& frame, ParsedCommand& command);
+
+// Append one encoded frame to out. Return false if the payload would exceed MaxPayload.
+bool encodeFrame(std::string& out, MessageId id, std::string_view payload);
+bool encodeCommand(std::string& out, std::string_view name, const Field* fields, size_t fieldCount);
+bool encodeCommand(std::string& out, CommandId id, const Field* fields, size_t fieldCount);
+bool encodeHello(std::string& out, uint8_t lowestVersion = Version, uint8_t highestVersion = Version);
+
+}
+
+// Protocol state of one peer: whether it negotiated the binary protocol and, on a stream, any
+// partial frame received so far. A peer switches to binary with a Hello or any valid frame; until then its
+// bytes are handled as text. receive() runs on one thread per session, isBinary() may be
+// called from any.
+class ProtocolSession {
+public:
+    enum class Framing {
+        Stream,     // TCP and serial: a frame may continue in the next receive()
+        Datagram    // UDP and SOCK_SEQPACKET: each receive() is one datagram, frames never span two
+    };
+
+    explicit ProtocolSession(Framing framing = Framing::Stream);
+
+    // Publishes the commands in newly received bytes. Replies owed to the peer, such as the
+    // Hello answer, are appended to reply.
+    void receive(std::string_view data, std::string& reply, const char* transport);
+
+    bool isBinary() const { return binary.load(std::memory_order_relaxed); }
+
+    // Unique per session for the life of the process, never 0; sent with each command so
+    // consumers can tell peers apart.
+    uint32_t clientId() const { return client; }
+
+    // The outgoing text message as bytes for this peer: unchanged for text peers, a Text frame
+    // for binary ones.
+    std::string encodeOutbound(const std::string& message) const;
+
+private:
+    const uint32_t client;
+    const Framing framing;
+    std::string pending;    // Stream framing only
+    std::atomic<bool> binary{false};
+
+    void handleFrame(const BinaryProtocol::Frame& frame, std::string& reply, const char* transport);
+};
+
+#endif // BINARYPROTOCOL_H
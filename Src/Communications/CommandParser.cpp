@@ -0,0 +1,162 @@
+#include "CommandParser.h"
+#include <charconv>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "../../Events/EventChannels.h"
+
+namespace {
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\0';
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && isSpace(text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && isSpace(text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+}
+
+const char* parseErrorString(ParseError error) {
+    switch (error) {
+        case ParseError::None: return "ok";
+        case ParseError::MissingSeparator: return "missing ':' separator";
+        case ParseError::EmptyCommand: return "empty command name";
+        case ParseError::UnknownCommand: return "unknown command";
+        case ParseError::EmptyParameter: return "empty parameter";
+        case ParseError::InvalidParameter: return "invalid parameter";
+        case ParseError::TooManyParameters: return "too many parameters";
+    }
+    return "unknown error";
+}
+
+ParseResult parseCommand(std::string_view message, ParsedCommand& command) {
+    command.name = std::string_view();
+    command.id = CommandId::Unknown;
+    command.parameterCount = 0;
+
+    message = trim(message);
+    size_t colon = message.find(':');
+    if (colon == std::string_view::npos) {
+        return {ParseError::MissingSeparator, message.size()};
+    }
+
+    std::string_view name = trim(message.substr(0, colon));
+    if (name.empty()) {
+        return {ParseError::EmptyCommand, 0};
+    }
+    command.name = name;
+    command.id = commandIdFromName(name);
+    if (command.id == CommandId::Unknown) {
+        return {ParseError::UnknownCommand, 0};
+    }
+
+    size_t offset = colon + 1;
+    while (offset < message.size()) {
+        size_t comma = message.find(',', offset);
+        size_t end = comma == std::string_view::npos ? message.size() : comma;
+        std::string_view value = trim(message.substr(offset, end - offset));
+
+        if (value.empty()) {
+            return {ParseError::EmptyParameter, offset};
+        }
+        if (command.parameterCount == ParsedCommand::MaxParameters) {
+            return {ParseError::TooManyParameters, offset};
+        }
+        // from_chars takes no '+'; one is allowed in front of the number, not of its sign
+        if (value.front() == '+') {
+            value.remove_prefix(1);
+            if (!value.empty() && value.front() == '-') {
+                return {ParseError::InvalidParameter, offset};
+            }
+        }
+
+        double parsed = 0.0;
+        auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), parsed);
+        if (ec != std::errc() || ptr != value.data() + value.size() || !std::isfinite(parsed)) {
+            return {ParseError::InvalidParameter, offset};
+        }
+        command.parameters[command.parameterCount++] = parsed;
+
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        offset = comma + 1;
+    }
+    return {};
+}
+
+BatchParseResult parseCommandBatch(std::string_view buffer, ParsedCommand* commands, size_t capacity) {
+    BatchParseResult result;
+    while (result.consumed < buffer.size() && result.parsed < capacity) {
+        size_t newline = buffer.find('\n', result.consumed);
+        size_t end = newline == std::string_view::npos ? buffer.size() : newline;
+        std::string_view line = buffer.substr(result.consumed, end - result.consumed);
+        size_t lineStart = result.consumed;
+        result.consumed = newline == std::string_view::npos ? buffer.size() : newline + 1;
+
+        if (trim(line).empty()) {
+            continue;
+        }
+        ParseResult parsed = parseCommand(line, commands[result.parsed]);
+        if (parsed) {
+            ++result.parsed;
+        } else {
+            if (result.failed++ == 0) {
+                result.firstError = {parsed.error, lineStart + parsed.position};
+            }
+        }
+    }
+    return result;
+}
+
+void publishCommand(const ParsedCommand& command, uint32_t client) {
+    // Reused across calls so the event payload does not allocate per command
+    thread_local std::vector<double> parameters;
+
+    switch (command.id) {
+        case CommandId::Info:
+            GetEventChannel<InfoRequestEvent>().invoke();
+            break;
+        case CommandId::SetBrightness:
+            GetEventChannel<SetBrightnessEvent>().invoke();
+            break;
+        case CommandId::LinkPong:
+            if (command.parameterCount == 2 && command.parameters[0] >= 0 && command.parameters[1] >= 0) {
+                GetEventChannel<LinkPongEvent>().invoke(static_cast<uint32_t>(command.parameters[0]),
+                                                        static_cast<uint32_t>(command.parameters[1]));
+            }
+            break;
+        default:
+            parameters.assign(command.parameters.begin(), command.parameters.begin() + command.parameterCount);
+            GetEventChannel<CommandReceivedEvent>().invoke(command.id, parameters, client);
+            break;
+    }
+}
+
+size_t publishCommands(std::string_view buffer, const char* transport, uint32_t client) {
+    ParsedCommand commands[8];
+    size_t published = 0;
+    while (!buffer.empty()) {
+        BatchParseResult batch = parseCommandBatch(buffer, commands, std::size(commands));
+        if (batch.failed) {
+            std::cerr << transport << ": dropped " << batch.failed << " invalid message(s), first: "
+                      << parseErrorString(batch.firstError.error) << " at offset " << batch.firstError.position
+                      << std::endl;
+        }
+
+        for (size_t i = 0; i < batch.parsed; ++i) {
+            publishCommand(commands[i], client);
+        }
+        published += batch.parsed;
+        buffer.remove_prefix(batch.consumed);
+    }
+    return published;
+}
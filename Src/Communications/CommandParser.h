@@ -0,0 +1,65 @@
+#ifndef COMMANDPARSER_H
+#define COMMANDPARSER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "../../Events/CommandIds.h"
+
+// Parser for the ground station text protocol, "command:param1,param2,...", shared by all
+// transports; the binary protocol decodes into the same ParsedCommand. It works on string_views
+// into the receive buffer and writes into caller-provided storage, so parsing allocates nothing
+// and never throws.
+struct ParsedCommand {
+    static constexpr size_t MaxParameters = 16;
+
+    std::string_view name;  // Points into the parsed buffer
+    CommandId id = CommandId::Unknown;
+    std::array<double, MaxParameters> parameters;
+    size_t parameterCount = 0;
+};
+
+enum class ParseError {
+    None,
+    MissingSeparator,   // No ':' after the command name
+    EmptyCommand,
+    UnknownCommand,     // Name is not in CommandIds
+    EmptyParameter,     // Nothing between two commas
+    InvalidParameter,   // Not a finite number, or trailing characters after it
+    TooManyParameters
+};
+
+struct ParseResult {
+    ParseError error = ParseError::None;
+    size_t position = 0;  // Offset of the offending token in the message
+
+    explicit operator bool() const { return error == ParseError::None; }
+};
+
+struct BatchParseResult {
+    size_t parsed = 0;
+    size_t failed = 0;
+    size_t consumed = 0;    // Bytes of the buffer handled; less than its size when storage ran out
+    ParseResult firstError;
+};
+
+const char* parseErrorString(ParseError error);
+
+// Surrounding whitespace and line endings are ignored. A trailing comma is accepted.
+// The name is interned into command.id; names that are not commands fail with UnknownCommand.
+ParseResult parseCommand(std::string_view message, ParsedCommand& command);
+
+// Parses newline-separated messages into commands[0..capacity). Malformed lines are counted
+// and skipped, empty lines are ignored.
+BatchParseResult parseCommandBatch(std::string_view buffer, ParsedCommand* commands, size_t capacity);
+
+// Invokes the event matching command.id: info, set_brightness, link_pong or command_received.
+// client goes into the command_received payload; see ProtocolSession::clientId().
+void publishCommand(const ParsedCommand& command, uint32_t client = 0);
+
+// Parses every message in the buffer and publishes each command.
+// Malformed messages are logged with the transport name. Returns the number of commands published.
+size_t publishCommands(std::string_view buffer, const char* transport, uint32_t client = 0);
+
+#endif // COMMANDPARSER_H
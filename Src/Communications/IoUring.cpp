@@ -0,0 +1,171 @@
+#include "IoUring.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+IoUring::~IoUring() {
+    if (bufferMemory) {
+        munmap(bufferMemory, bufferMemorySize);
+    }
+    if (bufferRing) {
+        munmap(bufferRing, bufferRingSize);
+    }
+    if (sqes) {
+        munmap(sqes, sqesSize);
+    }
+    if (ringMemory) {
+        munmap(ringMemory, ringSize);
+    }
+    if (ringFd >= 0) {
+        close(ringFd);
+    }
+}
+
+bool IoUring::supported() {
+    static const bool available = [] {
+        IoUring ring;
+        if (!ring.init(4)) {
+            std::cerr << "io_uring unavailable: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        constexpr unsigned probeOps = 256;
+        alignas(io_uring_probe) char storage[sizeof(io_uring_probe) + probeOps * sizeof(io_uring_probe_op)] = {};
+        auto* probe = reinterpret_cast<io_uring_probe*>(storage);
+        if (syscall(__NR_io_uring_register, ring.ringFd, IORING_REGISTER_PROBE, probe, probeOps) < 0) {
+            std::cerr << "io_uring unavailable: probe failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        // IORING_OP_SEND_ZC arrived in the same release as multishot receive, which has no probe bit
+        for (int op : {IORING_OP_RECVMSG, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_SENDMSG, IORING_OP_ACCEPT,
+                       IORING_OP_READ, IORING_OP_ASYNC_CANCEL, IORING_OP_SEND_ZC}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                std::cerr << "io_uring unavailable: kernel older than 6.0" << std::endl;
+                return false;
+            }
+        }
+        if (!ring.registerBuffers(2, 64)) {
+            std::cerr << "io_uring unavailable: cannot register a buffer ring: " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }();
+    return available;
+}
+
+bool IoUring::init(unsigned entries) {
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CLAMP;
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        return false;
+    }
+    ringFd = fd;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        errno = ENOSYS;
+        return false;
+    }
+
+    ringSize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    void* ring = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (ring == MAP_FAILED) {
+        return false;
+    }
+    ringMemory = ring;
+
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* entryMemory = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (entryMemory == MAP_FAILED) {
+        return false;
+    }
+    sqes = static_cast<io_uring_sqe*>(entryMemory);
+
+    char* base = static_cast<char*>(ringMemory);
+    sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    sqEntries = params.sq_entries;
+    sqLocalTail = *sqTail;
+    // Submission slot i always holds entry i, so entries are filled in ring order
+    unsigned* sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    for (unsigned i = 0; i < sqEntries; ++i) {
+        sqArray[i] = i;
+    }
+
+    cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+    return true;
+}
+
+bool IoUring::registerBuffers(unsigned count, unsigned size) {
+    bufferRingSize = count * sizeof(io_uring_buf);
+    void* ring = mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        return false;
+    }
+    bufferRing = static_cast<io_uring_buf_ring*>(ring);
+
+    bufferMemorySize = static_cast<size_t>(count) * size;
+    void* memory = mmap(nullptr, bufferMemorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+    bufferMemory = static_cast<char*>(memory);
+
+    io_uring_buf_reg registration{};
+    registration.ring_addr = reinterpret_cast<uintptr_t>(bufferRing);
+    registration.ring_entries = count;
+    registration.bgid = bufferGroup;
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+        return false;
+    }
+
+    bufferSize = size;
+    bufferMask = count - 1;
+    for (unsigned id = 0; id < count; ++id) {
+        recycleBuffer(static_cast<uint16_t>(id));
+    }
+    return true;
+}
+
+io_uring_sqe* IoUring::getSqe() {
+    if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+        submit();
+        if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+            return nullptr;
+        }
+    }
+    io_uring_sqe* sqe = &sqes[sqLocalTail & sqMask];
+    ++sqLocalTail;
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int IoUring::submit(unsigned waitFor) {
+    unsigned pending = sqLocalTail - *sqTail;
+    if (pending == 0 && waitFor == 0) {
+        return 0;
+    }
+    __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+    ++enters;
+    return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, pending, waitFor,
+                                    waitFor ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+}
+
+void IoUring::recycleBuffer(uint16_t id) {
+    // Indexed by hand: compiled as C++, the uapi header's flexible-array wrapper puts bufs 8 bytes
+    // past the start of the ring. Slot 0 shares its last field with the ring tail, which this does
+    // not touch.
+    io_uring_buf& slot = reinterpret_cast<io_uring_buf*>(bufferRing)[bufferTail & bufferMask];
+    slot.addr = reinterpret_cast<uintptr_t>(buffer(id));
+    slot.len = bufferSize;
+    slot.bid = id;
+    ++bufferTail;
+    __atomic_store_n(&bufferRing->tail, bufferTail, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,84 @@
+#ifndef IOURING_H
+#define IOURING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+
+// Minimal io_uring driver over the kernel ABI, without liburing: one submission/completion ring
+// plus one ring of provided buffers that multishot receives fill. Not thread-safe; a transport
+// owns one and drives it from a single thread.
+class IoUring {
+public:
+    IoUring() = default;
+    ~IoUring();
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // Whether this kernel lets the process create rings with everything the io_uring transports
+    // need (multishot receive and provided buffer rings, Linux 6.0). Probed once; logs why not.
+    static bool supported();
+
+    bool init(unsigned entries);
+
+    // Registers count buffers of size bytes each as the buffer group receives select from.
+    // count must be a power of two.
+    bool registerBuffers(unsigned count, unsigned size);
+
+    // Zeroed submission entry, or nullptr if the ring is full even after submitting
+    io_uring_sqe* getSqe();
+
+    // Submits every prepared entry and waits for at least waitFor completions, in one syscall
+    int submit(unsigned waitFor = 0);
+
+    // Passes each ready completion to onCompletion and hands the slots back to the kernel
+    template <typename Callback>
+    unsigned forEachCompletion(Callback&& onCompletion) {
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+        for (; head != tail; ++head, ++count) {
+            onCompletion(cqes[head & cqMask]);
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    char* buffer(uint16_t id) const { return bufferMemory + static_cast<size_t>(id) * bufferSize; }
+    // Returns a provided buffer to the kernel once its contents have been copied out
+    void recycleBuffer(uint16_t id);
+
+    static constexpr uint16_t bufferGroup = 0;
+
+    uint64_t enterCalls() const { return enters; }
+
+private:
+    int ringFd = -1;
+    void* ringMemory = nullptr;
+    size_t ringSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    unsigned sqLocalTail = 0;       // Prepared but not yet published
+
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    io_uring_buf_ring* bufferRing = nullptr;
+    size_t bufferRingSize = 0;
+    char* bufferMemory = nullptr;
+    size_t bufferMemorySize = 0;
+    unsigned bufferSize = 0;
+    unsigned bufferMask = 0;
+    uint16_t bufferTail = 0;
+
+    uint64_t enters = 0;
+};
+
+#endif // IOURING_H
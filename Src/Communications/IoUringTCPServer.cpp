@@ -0,0 +1,482 @@
+#include "IoUringTCPServer.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/eventfd.h>
+
+#include "CommandParser.h"
+
+namespace {
+const size_t receiveBufferSize = 16 * 1024;
+const size_t maxLineLength = 1024;
+const unsigned ringEntries = 256;
+const unsigned receiveBuffers = 256;
+const unsigned providedBufferSize = 4096;
+
+// Low byte of user_data; the rest is the connection id
+enum Operation : uint64_t {
+    AcceptOp = 1,
+    WakeOp = 2,
+    CancelOp = 3,
+    ReceiveOp = 4,
+    SendOp = 5
+};
+}
+
+IoUringTCPServer::IoUringTCPServer(int port)
+    : serverSocket(-1), wakeFd(-1), port(port), running(false), outboundConfig(OutboundQueue::loadConfig()) {
+}
+
+IoUringTCPServer::~IoUringTCPServer() {
+    stop();
+}
+
+bool IoUringTCPServer::start() {
+    serverSocket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (serverSocket < 0) {
+        std::cerr << "Error creating socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in serverAddr{};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_addr.s_addr = INADDR_ANY;
+    serverAddr.sin_port = htons(port);
+    if (bind(serverSocket, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+        std::cerr << "Error binding socket: " << strerror(errno) << std::endl;
+        close(serverSocket);
+        return false;
+    }
+
+    if (listen(serverSocket, SOMAXCONN) < 0) {
+        std::cerr << "Error listening on socket: " << strerror(errno) << std::endl;
+        close(serverSocket);
+        return false;
+    }
+
+    ring = std::make_unique<IoUring>();
+    wakeFd = eventfd(0, EFD_CLOEXEC);   // Blocking: io_uring completes reads of a non-blocking fd with EAGAIN instead of waiting
+    if (!ring->init(ringEntries) || !ring->registerBuffers(receiveBuffers, providedBufferSize) || wakeFd < 0) {
+        std::cerr << "Error setting up io_uring: " << strerror(errno) << std::endl;
+        ring.reset();
+        if (wakeFd >= 0) {
+            close(wakeFd);
+        }
+        close(serverSocket);
+        return false;
+    }
+
+    running = true;
+    std::cout << "Server (io_uring) started on port " << port << std::endl;
+
+    ringThread = std::thread(&IoUringTCPServer::runRing, this);
+    commandProcessorThread = std::thread(&IoUringTCPServer::processCommands, this);
+
+    return true;
+}
+
+void IoUringTCPServer::stop() {
+    if (running) {
+        running = false;
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {
+            std::cerr << "Error waking TCP ring: " << strerror(errno) << std::endl;
+        }
+        if (ringThread.joinable()) {
+            ringThread.join();
+        }
+        ring.reset();
+        close(serverSocket);
+        close(wakeFd);
+        std::cout << "Server stopped." << std::endl;
+
+        queueCondition.notify_all();
+        if (commandProcessorThread.joinable()) {
+            commandProcessorThread.join();
+        }
+    }
+}
+
+void IoUringTCPServer::runRing() {
+    std::vector<std::pair<std::shared_ptr<Connection>, std::string>> received;
+    armAccept();
+    armWake();
+
+    while (running) {
+        submitSends();
+        if (ring->submit(1) < 0 && errno != EINTR) {
+            std::cerr << "Error waiting for TCP completions: " << strerror(errno) << std::endl;
+            break;
+        }
+        ring->forEachCompletion([&](const io_uring_cqe& cqe) { handleCompletion(cqe, received); });
+
+        if (!received.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (commandQueue.empty()) {
+                    commandQueue.swap(received);
+                } else {
+                    commandQueue.insert(commandQueue.end(), std::make_move_iterator(received.begin()), std::make_move_iterator(received.end()));
+                }
+            }
+            received.clear();
+            queueCondition.notify_one();
+        }
+    }
+
+    // The kernel may still read send buffers and write receive buffers; cancel everything and
+    // wait for the last completion before any of that memory goes away
+    if (io_uring_sqe* sqe = ring->getSqe()) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+        sqe->user_data = CancelOp;
+    }
+    while (inFlight > 0) {
+        if (ring->submit(1) < 0 && errno != EINTR) {
+            break;
+        }
+        ring->forEachCompletion([&](const io_uring_cqe& cqe) { handleCompletion(cqe, received); });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(clientSocketsMutex);
+        connections.clear();
+    }
+    for (auto& [id, connection] : ringConnections) {
+        close(connection->socket);
+    }
+    ringConnections.clear();
+}
+
+void IoUringTCPServer::armAccept() {
+    io_uring_sqe* sqe = ring->getSqe();
+    if (!sqe) {
+        std::cerr << "io_uring submission queue full, accept not armed" << std::endl;
+        return;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = serverSocket;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = AcceptOp;
+    ++inFlight;
+}
+
+void IoUringTCPServer::armWake() {
+    io_uring_sqe* sqe = ring->getSqe();
+    if (!sqe) {
+        std::cerr << "io_uring submission queue full, TCP wake-up not armed" << std::endl;
+        return;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wakeFd;
+    sqe->addr = reinterpret_cast<uintptr_t>(&wakeValue);
+    sqe->len = sizeof(wakeValue);
+    sqe->user_data = WakeOp;
+    ++inFlight;
+}
+
+void IoUringTCPServer::armReceive(Connection& connection) {
+    io_uring_sqe* sqe = ring->getSqe();
+    if (!sqe) {
+        std::cerr << "io_uring submission queue full, closing " << connection.peer << std::endl;
+        beginClose(connection);
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = connection.socket;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = IoUring::bufferGroup;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = (connection.id << 8) | ReceiveOp;
+    connection.receiveArmed = true;
+    ++inFlight;
+}
+
+// Prepares one send for every connection with bytes waiting and none in flight; the next
+// submit() hands them all to the kernel at once.
+void IoUringTCPServer::submitSends() {
+    std::vector<std::shared_ptr<Connection>> overflowed;
+    {
+        std::lock_guard<std::mutex> lock(clientSocketsMutex);
+        wakePending = false;
+        for (auto& [id, connection] : connections) {
+            if (connection->disconnecting) {
+                overflowed.push_back(connection);
+                continue;
+            }
+            bool idle = connection->sendOffset == connection->sending.size();
+            if (connection->sendInFlight || (idle && connection->outbound.empty())) {
+                continue;
+            }
+            io_uring_sqe* sqe = ring->getSqe();
+            if (!sqe) {
+                break;  // The rest go out once completions free up the ring
+            }
+            if (idle) {
+                connection->sending = connection->outbound.take();
+                connection->sendOffset = 0;
+            }
+            sqe->opcode = IORING_OP_SEND;
+            sqe->fd = connection->socket;
+            sqe->addr = reinterpret_cast<uintptr_t>(connection->sending.data() + connection->sendOffset);
+            sqe->len = static_cast<uint32_t>(connection->sending.size() - connection->sendOffset);
+            sqe->msg_flags = MSG_NOSIGNAL;
+            sqe->user_data = (id << 8) | SendOp;
+            connection->sendInFlight = true;
+            ++inFlight;
+        }
+    }
+
+    for (auto& connection : overflowed) {
+        beginClose(*connection);
+        finishCloseIfIdle(*connection);
+    }
+}
+
+void IoUringTCPServer::handleCompletion(const io_uring_cqe& cqe, std::vector<std::pair<std::shared_ptr<Connection>, std::string>>& received) {
+    uint64_t operation = cqe.user_data & 0xff;
+    bool finished = !(cqe.flags & IORING_CQE_F_MORE);
+    switch (operation) {
+        case CancelOp:
+            return;
+
+        case WakeOp:
+            --inFlight;
+            if (running) {
+                armWake();
+            }
+            return;
+
+        case AcceptOp:
+            if (cqe.res >= 0) {
+                acceptConnection(cqe.res);
+            } else if (cqe.res != -ECANCELED) {
+                std::cerr << "Error accepting connection: " << strerror(-cqe.res) << std::endl;
+            }
+            if (finished) {
+                --inFlight;
+                if (running) {
+                    armAccept();
+                }
+            }
+            return;
+    }
+
+    auto it = ringConnections.find(cqe.user_data >> 8);
+    if (it == ringConnections.end()) {
+        return;
+    }
+    std::shared_ptr<Connection> connection = it->second;
+
+    if (operation == ReceiveOp) {
+        bool keep = true;
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            uint16_t id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (cqe.res > 0 && !connection->closing) {
+                keep = receiveBytes(connection, ring->buffer(id), static_cast<size_t>(cqe.res), received);
+            }
+            ring->recycleBuffer(id);
+        }
+        if (cqe.res == 0) {
+            std::cout << "Client disconnected." << std::endl;
+            keep = false;
+        } else if (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+            std::cerr << "Error receiving data: " << strerror(-cqe.res) << std::endl;
+            keep = false;
+        }
+        if (finished) {
+            connection->receiveArmed = false;
+            --inFlight;
+        }
+        if (!keep) {
+            beginClose(*connection);
+        } else if (finished && running && !connection->closing) {
+            armReceive(*connection);
+        }
+    } else if (operation == SendOp) {
+        connection->sendInFlight = false;
+        --inFlight;
+        if (cqe.res < 0) {
+            if (!connection->closing && cqe.res != -ECANCELED) {
+                std::cerr << "Failed to send message to client. Error: " << strerror(-cqe.res) << std::endl;
+                beginClose(*connection);
+            }
+        } else {
+            // A short write leaves the rest for the next submitSends()
+            connection->sendOffset += static_cast<size_t>(cqe.res);
+            if (connection->sendOffset >= connection->sending.size()) {
+                connection->sending.clear();
+                connection->sendOffset = 0;
+            }
+        }
+    }
+    finishCloseIfIdle(*connection);
+}
+
+void IoUringTCPServer::acceptConnection(int clientSocket) {
+    if (!running) {
+        close(clientSocket);
+        return;
+    }
+
+    sockaddr_in clientAddr{};
+    socklen_t clientAddrLen = sizeof(clientAddr);
+    getpeername(clientSocket, (struct sockaddr*)&clientAddr, &clientAddrLen);
+    char addr[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &clientAddr.sin_addr, addr, sizeof(addr));
+
+    uint64_t id = nextConnectionId++;
+    auto connection = std::make_shared<Connection>(id, clientSocket, std::string(addr) + ":" + std::to_string(ntohs(clientAddr.sin_port)),
+                                                   receiveBufferSize, outboundConfig);
+    ringConnections.emplace(id, connection);
+    {
+        std::lock_guard<std::mutex> lock(clientSocketsMutex);
+        connections.emplace(id, connection);
+    }
+    armReceive(*connection);
+    finishCloseIfIdle(*connection);
+    std::cout << "Client connected." << std::endl;
+}
+
+// Frames bytes from one provided buffer into the connection's stream buffer. Returns false when
+// the connection should be closed.
+bool IoUringTCPServer::receiveBytes(const std::shared_ptr<Connection>& connection, const char* data, size_t size,
+                                    std::vector<std::pair<std::shared_ptr<Connection>, std::string>>& received) {
+    StreamBuffer& buffer = connection->buffer;
+    while (size > 0) {
+        size_t chunk = std::min(size, buffer.writable());
+        if (chunk == 0) {
+            std::cerr << "Receive buffer full for client " << connection->peer << ", closing connection." << std::endl;
+            return false;
+        }
+        std::memcpy(buffer.writePointer(), data, chunk);
+        buffer.commit(chunk);
+        data += chunk;
+        size -= chunk;
+
+        BinaryProtocol::StreamScan scan = BinaryProtocol::scanStream(buffer.data(), maxLineLength);
+        if (scan.complete > 0) {
+            received.emplace_back(connection, std::string(buffer.data().substr(0, scan.complete)));
+            buffer.consume(scan.complete);
+        }
+        if (scan.error != BinaryProtocol::FrameStatus::Ok) {
+            std::cerr << "Framing error from client: " << BinaryProtocol::frameStatusString(scan.error)
+                      << ", closing connection." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Stops new sends and cancels what the kernel still holds for the connection; the socket is
+// closed by finishCloseIfIdle() once those operations have completed.
+void IoUringTCPServer::beginClose(Connection& connection) {
+    if (connection.closing) {
+        return;
+    }
+    connection.closing = true;
+    {
+        std::lock_guard<std::mutex> lock(clientSocketsMutex);
+        connections.erase(connection.id);
+    }
+    if (connection.receiveArmed || connection.sendInFlight) {
+        if (io_uring_sqe* sqe = ring->getSqe()) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = connection.socket;
+            sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+            sqe->user_data = CancelOp;
+        }
+    }
+}
+
+void IoUringTCPServer::finishCloseIfIdle(Connection& connection) {
+    if (!connection.closing || connection.receiveArmed || connection.sendInFlight) {
+        return;
+    }
+    close(connection.socket);
+    ringConnections.erase(connection.id);
+}
+
+void IoUringTCPServer::processCommands() {
+    std::vector<std::pair<std::shared_ptr<Connection>, std::string>> pending;
+    while (running) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return !commandQueue.empty() || !running; });
+            pending.swap(commandQueue);
+        }
+
+        for (auto& [connection, message] : pending) {
+            std::string reply;
+            connection->session.receive(message, reply, "TCP");
+            if (!reply.empty()) {
+                std::lock_guard<std::mutex> clientsLock(clientSocketsMutex);
+                sendToClient(*connection, std::move(reply));
+            }
+        }
+        pending.clear();
+    }
+}
+
+bool IoUringTCPServer::send_message(const std::string& message) {
+    std::lock_guard<std::mutex> lock(clientSocketsMutex);
+    if (connections.empty()) {
+        std::cerr << "No clients connected" << std::endl;
+        return false;
+    }
+
+    for (auto& [id, connection] : connections) {
+        sendToClient(*connection, connection->session.encodeOutbound(message));
+    }
+
+    return true;
+}
+
+// Callers hold clientSocketsMutex. Queues the bytes and wakes the ring thread, which sends them.
+bool IoUringTCPServer::sendToClient(Connection& connection, std::string bytes) {
+    if (connection.disconnecting) {
+        return false;
+    }
+
+    switch (connection.outbound.push(std::move(bytes))) {
+        case OutboundQueue::PushResult::Queued:
+            break;
+        case OutboundQueue::PushResult::Dropped: {
+            uint64_t dropped = connection.outbound.stats().dropped;
+            if (dropped % 100 == 1) {
+                std::cerr << "TCP client " << connection.peer << " is not keeping up, " << dropped
+                          << " message(s) dropped (" << OutboundQueue::policyString(outboundConfig.policy) << ")" << std::endl;
+            }
+            break;
+        }
+        case OutboundQueue::PushResult::Overflow:
+            std::cerr << "TCP client " << connection.peer << " is not keeping up, disconnecting." << std::endl;
+            connection.disconnecting = true;
+            break;
+    }
+
+    if (!wakePending) {
+        wakePending = true;
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {
+            std::cerr << "Error waking TCP ring: " << strerror(errno) << std::endl;
+        }
+    }
+    return !connection.disconnecting;
+}
+
+std::vector<ClientQueueStats> IoUringTCPServer::getClientQueueStats() {
+    std::lock_guard<std::mutex> lock(clientSocketsMutex);
+    std::vector<ClientQueueStats> stats;
+    stats.reserve(connections.size());
+    for (auto& [id, connection] : connections) {
+        stats.push_back({connection->peer, connection->outbound.stats()});
+    }
+    return stats;
+}
@@ -0,0 +1,98 @@
+#ifndef IOURINGTCPSERVER_H
+#define IOURINGTCPSERVER_H
+
+#include <string>
+#include <cstdint>
+#include <netinet/in.h>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <condition_variable>
+#include <unordered_map>
+
+#include "ICommunication.h"
+#include "BinaryProtocol.h"
+#include "StreamBuffer.h"
+#include "OutboundQueue.h"
+#include "IoUring.h"
+
+// TCPServer on io_uring. One ring thread keeps a multishot accept on the listening socket and a
+// multishot receive on every client over kernel-registered buffers, and hands each client's
+// next queued message to the kernel, all in a single submission per loop. Framing, outbound
+// queues and the command processor thread are the same as TCPServer's.
+class IoUringTCPServer : public ICommunication {
+public:
+    IoUringTCPServer(int port);
+    ~IoUringTCPServer();
+
+    bool start() override;
+    void stop() override;
+    bool send_message(const std::string& message) override;
+
+    std::vector<ClientQueueStats> getClientQueueStats();
+
+private:
+    struct Connection {
+        Connection(uint64_t id, int socket, std::string peer, size_t bufferSize, const OutboundQueue::Config& outboundConfig)
+            : id(id), socket(socket), peer(std::move(peer)), outbound(outboundConfig), buffer(bufferSize) {}
+
+        uint64_t id;
+        int socket;
+        std::string peer;
+        ProtocolSession session;
+
+        // Guarded by clientSocketsMutex
+        OutboundQueue outbound;
+        bool disconnecting = false; // Overflowed under the disconnect policy; the ring thread closes it
+
+        // Ring thread only
+        StreamBuffer buffer;
+        std::string sending;        // Message the kernel is writing, which must outlive the send
+        size_t sendOffset = 0;
+        bool sendInFlight = false;
+        bool receiveArmed = false;
+        bool closing = false;
+    };
+
+    int serverSocket;
+    int wakeFd;
+    int port;
+    std::atomic<bool> running;
+    std::unique_ptr<IoUring> ring;
+    std::thread ringThread;
+    std::thread commandProcessorThread;
+
+    // Open connections, for senders
+    std::unordered_map<uint64_t, std::shared_ptr<Connection>> connections;
+    std::mutex clientSocketsMutex;
+    OutboundQueue::Config outboundConfig;
+    bool wakePending = false;   // Guarded by clientSocketsMutex
+
+    // Ring thread only: every connection until its last operation completes and its socket is closed
+    std::unordered_map<uint64_t, std::shared_ptr<Connection>> ringConnections;
+    uint64_t nextConnectionId = 1;
+    uint64_t wakeValue = 0;
+    unsigned inFlight = 0;
+
+    std::vector<std::pair<std::shared_ptr<Connection>, std::string>> commandQueue;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+
+    void runRing();
+    void armAccept();
+    void armWake();
+    void armReceive(Connection& connection);
+    void submitSends();
+    void handleCompletion(const io_uring_cqe& cqe, std::vector<std::pair<std::shared_ptr<Connection>, std::string>>& received);
+    void acceptConnection(int clientSocket);
+    bool receiveBytes(const std::shared_ptr<Connection>& connection, const char* data, size_t size,
+                      std::vector<std::pair<std::shared_ptr<Connection>, std::string>>& received);
+    void beginClose(Connection& connection);
+    void finishCloseIfIdle(Connection& connection);
+    void processCommands();
+    bool sendToClient(Connection& connection, std::string bytes);
+};
+
+#endif // IOURINGTCPSERVER_H
@@ -0,0 +1,382 @@
+#include "IoUringUDPServer.h"
+#include <iostream>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/eventfd.h>
+
+#include "CommandParser.h"
+#include "../../Events/EventChannels.h"
+#include "../../inih/cpp/INIReader.h"
+
+namespace {
+const unsigned ringEntries = 256;
+const unsigned receiveBuffers = 256;
+const size_t datagramBufferSize = 2048;
+// Each provided buffer holds the recvmsg header and source address ahead of the payload
+const unsigned receiveBufferSize = sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in) + datagramBufferSize;
+
+// Completion tags; a send completion carries its Client pointer instead
+const uint64_t ReceiveTag = 1;
+const uint64_t WakeTag = 2;
+const uint64_t CancelTag = 3;
+}
+
+IoUringUDPServer::IoUringUDPServer(int port)
+    : serverSocket(-1), wakeFd(-1), port(port), running(false), outboundConfig(OutboundQueue::loadConfig()) {
+    std::memset(&receiveHeader, 0, sizeof(receiveHeader));
+    INIReader reader("../config.ini");
+    clientLease = std::chrono::seconds(reader.GetInteger("UDP", "ClientLeaseSeconds", 30));
+}
+
+IoUringUDPServer::~IoUringUDPServer() {
+    stop();
+}
+
+bool IoUringUDPServer::start() {
+    serverSocket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (serverSocket < 0) {
+        std::cerr << "Error creating socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    sockaddr_in serverAddr{};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_addr.s_addr = INADDR_ANY;
+    serverAddr.sin_port = htons(port);
+    if (bind(serverSocket, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+        std::cerr << "Error binding socket: " << strerror(errno) << std::endl;
+        close(serverSocket);
+        return false;
+    }
+
+    ring = std::make_unique<IoUring>();
+    wakeFd = eventfd(0, EFD_CLOEXEC);   // Blocking: io_uring completes reads of a non-blocking fd with EAGAIN instead of waiting
+    if (!ring->init(ringEntries) || !ring->registerBuffers(receiveBuffers, receiveBufferSize) || wakeFd < 0) {
+        std::cerr << "Error setting up io_uring: " << strerror(errno) << std::endl;
+        ring.reset();
+        if (wakeFd >= 0) {
+            close(wakeFd);
+        }
+        close(serverSocket);
+        return false;
+    }
+    receiveHeader.msg_namelen = sizeof(sockaddr_in);
+
+    running = true;
+    std::cout << "UDP Server (io_uring) started on port " << port << std::endl;
+    ringThread = std::thread(&IoUringUDPServer::runRing, this);
+    commandProcessorThread = std::thread(&IoUringUDPServer::processCommands, this);
+
+    return true;
+}
+
+void IoUringUDPServer::stop() {
+    if (running) {
+        running = false;
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {
+            std::cerr << "Error waking UDP ring: " << strerror(errno) << std::endl;
+        }
+        if (ringThread.joinable()) {
+            ringThread.join();
+        }
+        ring.reset();
+        close(serverSocket);
+        close(wakeFd);
+        std::cout << "Server stopped." << std::endl;
+
+        queueCondition.notify_all();
+        if (commandProcessorThread.joinable()) {
+            commandProcessorThread.join();
+        }
+    }
+}
+
+void IoUringUDPServer::runRing() {
+    std::vector<std::pair<std::string, sockaddr_in>> received;
+    armReceive();
+    armWake();
+
+    while (running) {
+        submitSends();
+        if (ring->submit(1) < 0 && errno != EINTR) {
+            std::cerr << "Error waiting for UDP completions: " << strerror(errno) << std::endl;
+            break;
+        }
+        ring->forEachCompletion([&](const io_uring_cqe& cqe) { handleCompletion(cqe, received); });
+
+        if (!received.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (commandQueue.empty()) {
+                    commandQueue.swap(received);
+                } else {
+                    commandQueue.insert(commandQueue.end(), std::make_move_iterator(received.begin()), std::make_move_iterator(received.end()));
+                }
+            }
+            received.clear();
+            queueCondition.notify_one();
+        }
+    }
+
+    // The kernel may still read send buffers and write receive buffers; cancel everything and
+    // wait for the last completion before any of that memory goes away
+    if (io_uring_sqe* sqe = ring->getSqe()) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+        sqe->user_data = CancelTag;
+    }
+    while (inFlight > 0) {
+        if (ring->submit(1) < 0 && errno != EINTR) {
+            break;
+        }
+        ring->forEachCompletion([&](const io_uring_cqe& cqe) { handleCompletion(cqe, received); });
+    }
+    inFlightSends.clear();
+}
+
+void IoUringUDPServer::armReceive() {
+    io_uring_sqe* sqe = ring->getSqe();
+    if (!sqe) {
+        std::cerr << "io_uring submission queue full, UDP receive not armed" << std::endl;
+        return;
+    }
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = serverSocket;
+    sqe->addr = reinterpret_cast<uintptr_t>(&receiveHeader);
+    sqe->len = 1;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = IoUring::bufferGroup;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = ReceiveTag;
+    ++inFlight;
+}
+
+void IoUringUDPServer::armWake() {
+    io_uring_sqe* sqe = ring->getSqe();
+    if (!sqe) {
+        std::cerr << "io_uring submission queue full, UDP wake-up not armed" << std::endl;
+        return;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wakeFd;
+    sqe->addr = reinterpret_cast<uintptr_t>(&wakeValue);
+    sqe->len = sizeof(wakeValue);
+    sqe->user_data = WakeTag;
+    ++inFlight;
+}
+
+// Prepares one sendmsg for every client with a datagram queued and none in flight; the next
+// submit() hands them all to the kernel at once.
+void IoUringUDPServer::submitSends() {
+    std::lock_guard<std::mutex> lock(clientAddressesMutex);
+    wakePending = false;
+    for (auto& [key, client] : clientAddresses) {
+        if (client->sendInFlight || client->outbound.empty()) {
+            continue;
+        }
+        io_uring_sqe* sqe = ring->getSqe();
+        if (!sqe) {
+            break;  // The rest go out once completions free up the ring
+        }
+        client->sending = client->outbound.take();
+        client->sendVector = {client->sending.data(), client->sending.size()};
+        client->sendHeader = {};
+        client->sendHeader.msg_name = &client->address;
+        client->sendHeader.msg_namelen = sizeof(client->address);
+        client->sendHeader.msg_iov = &client->sendVector;
+        client->sendHeader.msg_iovlen = 1;
+
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = serverSocket;
+        sqe->addr = reinterpret_cast<uintptr_t>(&client->sendHeader);
+        sqe->len = 1;
+        sqe->user_data = reinterpret_cast<uintptr_t>(client.get());
+        client->sendInFlight = true;
+        inFlightSends.emplace(client.get(), client);
+        ++inFlight;
+    }
+}
+
+void IoUringUDPServer::handleCompletion(const io_uring_cqe& cqe, std::vector<std::pair<std::string, sockaddr_in>>& received) {
+    bool finished = !(cqe.flags & IORING_CQE_F_MORE);
+    switch (cqe.user_data) {
+        case CancelTag:
+            return;
+
+        case WakeTag:
+            --inFlight;
+            if (running) {
+                armWake();
+            }
+            return;
+
+        case ReceiveTag:
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                uint16_t id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                const char* buffer = ring->buffer(id);
+                if (cqe.res >= static_cast<int>(sizeof(io_uring_recvmsg_out))) {
+                    io_uring_recvmsg_out header;
+                    std::memcpy(&header, buffer, sizeof(header));
+                    sockaddr_in clientAddr{};
+                    std::memcpy(&clientAddr, buffer + sizeof(header), sizeof(clientAddr));
+                    const char* payload = buffer + sizeof(header) + receiveHeader.msg_namelen + receiveHeader.msg_controllen;
+                    if (header.flags & MSG_TRUNC) {
+                        std::cerr << "Dropping datagram from " << clientAddrToString(clientAddr)
+                                  << " larger than " << datagramBufferSize << " bytes" << std::endl;
+                    } else {
+                        received.emplace_back(std::string(payload, header.payloadlen), clientAddr);
+                    }
+                }
+                ring->recycleBuffer(id);
+            } else if (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+                std::cerr << "Error receiving data: " << strerror(-cqe.res) << std::endl;
+            }
+            // Multishot stops when the buffers run out or on error; buffers are back by now
+            if (finished) {
+                --inFlight;
+                if (running) {
+                    armReceive();
+                }
+            }
+            return;
+
+        default: {
+            auto it = inFlightSends.find(reinterpret_cast<Client*>(cqe.user_data));
+            if (it == inFlightSends.end()) {
+                return;
+            }
+            Client& client = *it->second;
+            if (cqe.res < 0 && cqe.res != -ECANCELED) {
+                std::cerr << "Failed to send message to client " << client.name << ". Error: " << strerror(-cqe.res) << std::endl;
+            }
+            client.sendInFlight = false;
+            inFlightSends.erase(it);
+            --inFlight;
+            return;
+        }
+    }
+}
+
+void IoUringUDPServer::processCommands() {
+    std::vector<std::pair<std::string, sockaddr_in>> pending;
+    std::vector<std::shared_ptr<Client>> senders;
+    while (running) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return !commandQueue.empty() || !running; });
+            pending.swap(commandQueue);
+        }
+
+        {
+            auto now = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> clientsLock(clientAddressesMutex);
+            for (const auto& datagram : pending) {
+                senders.push_back(addClientAddress(datagram.second, now));
+            }
+        }
+
+        for (size_t i = 0; i < pending.size(); ++i) {
+            Client& client = *senders[i];
+            std::string reply;
+            client.session.receive(pending[i].first, reply, "UDP");
+            if (!reply.empty()) {
+                std::lock_guard<std::mutex> clientsLock(clientAddressesMutex);
+                queueForClient(client, std::move(reply));
+            }
+        }
+        pending.clear();
+        senders.clear();
+    }
+}
+
+bool IoUringUDPServer::send_message(const std::string& message) {
+    std::lock_guard<std::mutex> lock(clientAddressesMutex);
+    expireClients(std::chrono::steady_clock::now());
+    if (clientAddresses.empty()) {
+        std::cerr << "No clients to send the message to" << std::endl;
+        return false;
+    }
+
+    for (auto it = clientAddresses.begin(); it != clientAddresses.end();) {
+        Client& client = *it->second;
+        if (queueForClient(client, client.session.encodeOutbound(message)) == OutboundQueue::PushResult::Overflow) {
+            std::cerr << "UDP client " << client.name << " is not keeping up, dropping it." << std::endl;
+            it = clientAddresses.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return true;
+}
+
+// Callers hold clientAddressesMutex.
+OutboundQueue::PushResult IoUringUDPServer::queueForClient(Client& client, std::string bytes) {
+    OutboundQueue::PushResult result = client.outbound.push(std::move(bytes));
+    if (result == OutboundQueue::PushResult::Dropped) {
+        uint64_t dropped = client.outbound.stats().dropped;
+        if (dropped % 100 == 1) {
+            std::cerr << "UDP client " << client.name << " is not keeping up, " << dropped
+                      << " message(s) dropped (" << OutboundQueue::policyString(outboundConfig.policy) << ")" << std::endl;
+        }
+    }
+    if (!wakePending) {
+        wakePending = true;
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {
+            std::cerr << "Error waking UDP ring: " << strerror(errno) << std::endl;
+        }
+    }
+    return result;
+}
+
+std::vector<ClientQueueStats> IoUringUDPServer::getClientQueueStats() {
+    std::lock_guard<std::mutex> lock(clientAddressesMutex);
+    std::vector<ClientQueueStats> stats;
+    stats.reserve(clientAddresses.size());
+    for (auto& [key, client] : clientAddresses) {
+        stats.push_back({client->name, client->outbound.stats()});
+    }
+    return stats;
+}
+
+// Callers hold clientAddressesMutex.
+std::shared_ptr<IoUringUDPServer::Client> IoUringUDPServer::addClientAddress(const sockaddr_in& clientAddr,
+                                                                             std::chrono::steady_clock::time_point now) {
+    auto [it, added] = clientAddresses.try_emplace(clientKey(clientAddr));
+    if (added) {
+        it->second = std::make_shared<Client>(clientAddr, clientAddrToString(clientAddr), outboundConfig);
+    }
+    it->second->lastSeen = now;
+    if (added) {
+        expireClients(now);
+    }
+    return it->second;
+}
+
+// Callers hold clientAddressesMutex.
+void IoUringUDPServer::expireClients(std::chrono::steady_clock::time_point now) {
+    if (clientLease.count() <= 0) {
+        return;
+    }
+    for (auto it = clientAddresses.begin(); it != clientAddresses.end();) {
+        if (now - it->second->lastSeen > clientLease) {
+            std::cerr << "UDP client " << it->second->name << " silent for over " << clientLease.count()
+                      << " s, dropping it." << std::endl;
+            it = clientAddresses.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+uint64_t IoUringUDPServer::clientKey(const sockaddr_in& clientAddr) {
+    return (static_cast<uint64_t>(ntohl(clientAddr.sin_addr.s_addr)) << 16) | ntohs(clientAddr.sin_port);
+}
+
+std::string IoUringUDPServer::clientAddrToString(const sockaddr_in& clientAddr) {
+    char addr[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &clientAddr.sin_addr, addr, sizeof(addr));
+    return std::string(addr) + ":" + std::to_string(ntohs(clientAddr.sin_port));
+}
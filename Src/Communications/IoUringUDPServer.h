@@ -0,0 +1,93 @@
+#ifndef IOURINGUDPSERVER_H
+#define IOURINGUDPSERVER_H
+
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <condition_variable>
+#include <unordered_map>
+
+#include "ICommunication.h"
+#include "BinaryProtocol.h"
+#include "OutboundQueue.h"
+#include "IoUring.h"
+
+// UDPServer on io_uring. One ring thread keeps a multishot recvmsg armed over kernel-registered
+// buffers and hands every client with something queued one sendmsg, all in a single submission
+// per loop; commands go to a processor thread as in UDPServer. Client leases, outbound queues
+// and their config are the same as UDPServer's.
+class IoUringUDPServer : public ICommunication {
+public:
+    IoUringUDPServer(int port);
+    ~IoUringUDPServer();
+
+    bool start() override;
+    void stop() override;
+    bool send_message(const std::string& message) override;
+
+    std::vector<ClientQueueStats> getClientQueueStats();
+
+private:
+    struct Client {
+        Client(const sockaddr_in& address, std::string name, const OutboundQueue::Config& outboundConfig)
+            : address(address), name(std::move(name)), outbound(outboundConfig) {}
+
+        sockaddr_in address;
+        std::string name;
+        ProtocolSession session{ProtocolSession::Framing::Datagram};
+        OutboundQueue outbound;     // Guarded by clientAddressesMutex
+        std::chrono::steady_clock::time_point lastSeen;     // Guarded by clientAddressesMutex
+
+        // Ring thread only: the datagram the kernel is sending, which must outlive the send
+        std::string sending;
+        iovec sendVector;
+        msghdr sendHeader;
+        bool sendInFlight = false;
+    };
+
+    int serverSocket;
+    int wakeFd;
+    int port;
+    std::atomic<bool> running;
+    std::unique_ptr<IoUring> ring;
+    std::thread ringThread;
+    std::thread commandProcessorThread;
+
+    // Ring thread only
+    msghdr receiveHeader;       // Multishot recvmsg layout: room for the source address, no control data
+    uint64_t wakeValue = 0;
+    unsigned inFlight = 0;      // Operations the kernel will still complete
+    std::unordered_map<Client*, std::shared_ptr<Client>> inFlightSends;     // Keeps dropped clients alive until their send completes
+
+    std::vector<std::pair<std::string, sockaddr_in>> commandQueue;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+
+    // Keyed by the packed address and port, as in UDPServer
+    std::unordered_map<uint64_t, std::shared_ptr<Client>> clientAddresses;
+    std::mutex clientAddressesMutex;
+    std::chrono::seconds clientLease;
+    OutboundQueue::Config outboundConfig;
+    bool wakePending = false;   // Guarded by clientAddressesMutex
+
+    void runRing();
+    void armReceive();
+    void armWake();
+    void submitSends();
+    void handleCompletion(const io_uring_cqe& cqe, std::vector<std::pair<std::string, sockaddr_in>>& received);
+    void processCommands();
+    OutboundQueue::PushResult queueForClient(Client& client, std::string bytes);
+    std::shared_ptr<Client> addClientAddress(const sockaddr_in& clientAddr, std::chrono::steady_clock::time_point now);
+    void expireClients(std::chrono::steady_clock::time_point now);
+    static uint64_t clientKey(const sockaddr_in& clientAddr);
+    std::string clientAddrToString(const sockaddr_in& clientAddr);
+};
+
+#endif // IOURINGUDPSERVER_H
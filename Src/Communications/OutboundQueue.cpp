@@ -0,0 +1,93 @@
+#include "OutboundQueue.h"
+#include <iostream>
+#include "../../inih/cpp/INIReader.h"
+
+OutboundQueue::Config OutboundQueue::loadConfig() {
+    Config config;
+    INIReader reader("../config.ini");
+    if (reader.ParseError() < 0) {
+        return config;
+    }
+
+    config.maxMessages = static_cast<size_t>(reader.GetInteger("Outbound", "QueueMessages", config.maxMessages));
+    config.maxBytes = static_cast<size_t>(reader.GetInteger("Outbound", "QueueBytes", config.maxBytes));
+    std::string policy = reader.GetString("Outbound", "OverflowPolicy", "drop_oldest");
+    if (policy == "drop_oldest") {
+        config.policy = Policy::DropOldest;
+    } else if (policy == "drop_newest") {
+        config.policy = Policy::DropNewest;
+    } else if (policy == "disconnect") {
+        config.policy = Policy::Disconnect;
+    } else {
+        std::cerr << "Unknown [Outbound] OverflowPolicy '" << policy << "', using drop_oldest" << std::endl;
+    }
+    return config;
+}
+
+const char* OutboundQueue::policyString(Policy policy) {
+    switch (policy) {
+        case Policy::DropOldest: return "drop_oldest";
+        case Policy::DropNewest: return "drop_newest";
+        case Policy::Disconnect: return "disconnect";
+    }
+    return "unknown";
+}
+
+OutboundQueue::PushResult OutboundQueue::push(std::string message) {
+    auto fits = [this, &message] {
+        return messages.size() < config.maxMessages && queuedBytes + message.size() <= config.maxBytes;
+    };
+    if (fits()) {
+        queuedBytes += message.size();
+        messages.push_back(std::move(message));
+        return PushResult::Queued;
+    }
+
+    switch (config.policy) {
+        case Policy::DropNewest:
+            ++dropped;
+            return PushResult::Dropped;
+        case Policy::Disconnect:
+            ++dropped;
+            return PushResult::Overflow;
+        case Policy::DropOldest:
+            break;
+    }
+
+    // A partially written message has to be finished or the stream would be corrupted
+    size_t oldest = frontOffset > 0 ? 1 : 0;
+    while (!fits() && messages.size() > oldest) {
+        queuedBytes -= messages[oldest].size();
+        messages.erase(messages.begin() + oldest);
+        ++dropped;
+    }
+    if (!fits()) {
+        ++dropped;  // Larger than the whole queue
+        return PushResult::Dropped;
+    }
+    queuedBytes += message.size();
+    messages.push_back(std::move(message));
+    return PushResult::Dropped;
+}
+
+void OutboundQueue::consume(size_t bytes) {
+    frontOffset += bytes;
+    if (frontOffset >= messages.front().size()) {
+        queuedBytes -= messages.front().size();
+        messages.pop_front();
+        frontOffset = 0;
+        ++sent;
+    }
+}
+
+std::string OutboundQueue::take() {
+    std::string message = std::move(messages.front());
+    messages.pop_front();
+    queuedBytes -= message.size();
+    ++sent;
+    return message;
+}
+
+OutboundQueue::Stats OutboundQueue::stats() const {
+    return Stats{messages.size(), queuedBytes - frontOffset, sent, dropped};
+}
@@ -0,0 +1,76 @@
+#ifndef OUTBOUNDQUEUE_H
+#define OUTBOUNDQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+// Bounded queue of messages waiting to be written to one client, so a stalled client costs its
+// own memory and messages instead of blocking every broadcast. Not thread-safe; the owning
+// transport guards it with its client mutex. Limits and the overflow policy come from the
+// [Outbound] section of config.ini.
+class OutboundQueue {
+public:
+    enum class Policy {
+        DropOldest,     // Make room by discarding the oldest unsent messages (telemetry stays fresh)
+        DropNewest,     // Keep what is queued and discard the new message
+        Disconnect      // Give up on the client
+    };
+
+    struct Config {
+        size_t maxMessages = 256;
+        size_t maxBytes = 1 << 20;
+        Policy policy = Policy::DropOldest;
+    };
+
+    struct Stats {
+        size_t depth = 0;       // Messages waiting, including a partially written one
+        size_t bytes = 0;       // Bytes waiting
+        uint64_t sent = 0;
+        uint64_t dropped = 0;
+    };
+
+    enum class PushResult {
+        Queued,
+        Dropped,    // The queue was full; a message was discarded according to the policy
+        Overflow    // The queue was full under Policy::Disconnect; the caller drops the client
+    };
+
+    static Config loadConfig();
+    static const char* policyString(Policy policy);
+
+    explicit OutboundQueue(const Config& config) : config(config) {}
+
+    PushResult push(std::string message);
+
+    bool empty() const { return messages.empty(); }
+
+    // Unwritten bytes of the oldest message.
+    std::string_view front() const { return std::string_view(messages.front()).substr(frontOffset); }
+
+    // Marks bytes of front() as written; the message is removed once all of it is.
+    void consume(size_t bytes);
+
+    // Removes the oldest message whole, for a writer that must own the bytes until an asynchronous
+    // send completes (io_uring). Not mixed with consume() on the same queue.
+    std::string take();
+
+    Stats stats() const;
+
+private:
+    Config config;
+    std::deque<std::string> messages;
+    size_t frontOffset = 0;     // Stream transports may write a message in several parts
+    size_t queuedBytes = 0;
+    uint64_t sent = 0;
+    uint64_t dropped = 0;
+};
+
+struct ClientQueueStats {
+    std::string client;
+    OutboundQueue::Stats queue;
+};
+
+#endif // OUTBOUNDQUEUE_H
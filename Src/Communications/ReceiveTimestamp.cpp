@@ -0,0 +1,22 @@
+#include "ReceiveTimestamp.h"
+
+namespace ReceiveTimestamp {
+
+bool enable(int socket) {
+    int on = 1;
+    return setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0;
+}
+
+const timespec* find(const msghdr& message) {
+    if (message.msg_flags & MSG_CTRUNC) {
+        return nullptr;
+    }
+    for (cmsghdr* control = CMSG_FIRSTHDR(&message); control; control = CMSG_NXTHDR(const_cast<msghdr*>(&message), control)) {
+        if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SCM_TIMESTAMPNS) {
+            return reinterpret_cast<const timespec*>(CMSG_DATA(control));
+        }
+    }
+    return nullptr;
+}
+
+}
@@ -0,0 +1,23 @@
+#ifndef RECEIVETIMESTAMP_H
+#define RECEIVETIMESTAMP_H
+
+#include <ctime>
+#include <sys/socket.h>
+
+// Kernel software receive timestamps (SO_TIMESTAMPNS): the CLOCK_REALTIME time the packet entered
+// the network stack, delivered as a control message with each receive. Hardware timestamps would
+// need the NIC clock kept in step with CLOCK_REALTIME, so they are not used.
+namespace ReceiveTimestamp {
+
+// Room for the timestamp control message in msghdr::msg_control
+constexpr size_t ControlSize = CMSG_SPACE(sizeof(timespec));
+
+// Returns false when the socket cannot timestamp; receives still work, just without the stamp.
+bool enable(int socket);
+
+// The timestamp control message of a received message, or null when it carries none.
+const timespec* find(const msghdr& message);
+
+}
+
+#endif // RECEIVETIMESTAMP_H
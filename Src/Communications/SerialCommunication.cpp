@@ -11,17 +11,25 @@
 #include <map>
 #include <unordered_map>
 #include <stdexcept>
-#include "../../Events/EventManager.h"
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "CommandParser.h"
+
+namespace {
+// Largest packet accepted from the ground station; anything longer is line noise.
+const size_t maxReceivedPacket = 4096;
+}
 
 
-SerialCommunication::SerialCommunication(const std::string &port, int baud_rate)
-        : port_name(port), baud_rate(baud_rate), serial_port(-1), stop_flag(false) {
+SerialCommunication::SerialCommunication(const std::string &port, int baud_rate, size_t send_queue_capacity)
+        : port_name(port), baud_rate(baud_rate), serial_port(-1), stop_flag(false),
+          send_queue_capacity(send_queue_capacity), decoder(maxReceivedPacket) {
     openPort();
 }
 
 SerialCommunication::~SerialCommunication() {
-    stopWorker();
-    closePort();
+    stop();
 }
 
 speed_t SerialCommunication::convertBaudRate(int baudRate) {
@@ -63,15 +71,14 @@ speed_t SerialCommunication::convertBaudRate(int baudRate) {
 }
 
 void SerialCommunication::openPort() {
-    serial_port = open(port_name.c_str(), O_RDWR | O_NOCTTY | O_NDELAY);
+    // Non-blocking: the reader waits in epoll and the writer in poll, never in read() or write()
+    serial_port = open(port_name.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
 
     if (serial_port < 0) {
         std::cerr << "Error " << errno << " opening " << port_name << ": " << strerror(errno) << std::endl;
         return;
     }
 
-    fcntl(serial_port, F_SETFL, 0);
-
     termios tty;
     if (tcgetattr(serial_port, &tty) != 0) {
         std::cerr << "Error " << errno << " from tcgetattr: " << strerror(errno) << std::endl;
@@ -101,8 +108,8 @@ void SerialCommunication::openPort() {
     tty.c_oflag &= ~OPOST; // Prevent special interpretation of output bytes (e.g. newline chars)
     tty.c_oflag &= ~ONLCR; // Prevent conversion of newline to carriage return/line feed
 
-    tty.c_cc[VTIME] = 10;    // Wait for up to 1s (10 deciseconds), returning as soon as any data is received.
-    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;    // With O_NONBLOCK this makes read() fail with EAGAIN when the port is empty,
+    tty.c_cc[VMIN] = 1;     // so a return of 0 only ever means the port went away
 
     if (tcsetattr(serial_port, TCSANOW, &tty) != 0) {
         std::cerr << "Error " << errno << " from tcsetattr: " << strerror(errno) << std::endl;
@@ -114,6 +121,7 @@ void SerialCommunication::openPort() {
 }
 
 void SerialCommunication::closePort() {
+    std::lock_guard<std::mutex> lock(send_mutex);
     if (serial_port >= 0) {
         close(serial_port);
         serial_port = -1;
@@ -121,95 +129,191 @@ void SerialCommunication::closePort() {
 }
 
 void SerialCommunication::startWorker() {
-    worker_thread = std::thread(&SerialCommunication::workerFunction, this);
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd < 0) {
+        std::cerr << "Error creating eventfd: " << strerror(errno) << std::endl;
+        return;
+    }
+    stop_flag = false;
+    reader_thread = std::thread(&SerialCommunication::readerFunction, this);
+    writer_thread = std::thread(&SerialCommunication::writerFunction, this);
 }
 
 void SerialCommunication::stopWorker() {
-    stop_flag = true;
-    if (worker_thread.joinable()) {
-        worker_thread.join();
+    {
+        std::lock_guard<std::mutex> lock(send_mutex);
+        stop_flag = true;
+    }
+    send_condition.notify_all();
+    if (wake_fd >= 0) {
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof(one)) < 0) {
+            std::cerr << "Error signalling serial threads: " << strerror(errno) << std::endl;
+        }
+    }
+    if (reader_thread.joinable()) {
+        reader_thread.join();
+    }
+    if (writer_thread.joinable()) {
+        writer_thread.join();
+    }
+    if (wake_fd >= 0) {
+        close(wake_fd);
+        wake_fd = -1;
     }
 }
 
-void SerialCommunication::workerFunction() {
-    while (!stop_flag) {
-        std::string message = receiveMessage();
-        if (!message.empty()) {
-            processReceivedMessage(message);
+void SerialCommunication::readerFunction() {
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        std::cerr << "Error creating epoll instance: " << strerror(errno) << std::endl;
+        return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = serial_port;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, serial_port, &event);
+    event.data.fd = wake_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+
+    char buffer[512];
+    bool port_open = true;
+    while (!stop_flag && port_open) {
+        epoll_event events[2];
+        int ready = epoll_wait(epoll_fd, events, 2, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error waiting on serial port: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < ready && port_open; ++i) {
+            if (events[i].data.fd == wake_fd) {
+                port_open = false;
+                break;
+            }
+            // Drain everything available; one wakeup may cover several packets
+            while (true) {
+                ssize_t n = read(serial_port, buffer, sizeof(buffer));
+                if (n > 0) {
+                    processReceivedBytes(std::string_view(buffer, n));
+                    continue;
+                }
+                if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+                    break;
+                }
+                std::cerr << "Serial port " << port_name << " closed: "
+                          << (n == 0 ? "hang-up" : strerror(errno)) << std::endl;
+                port_open = false;
+                break;
+            }
         }
     }
+    close(epoll_fd);
 }
 
-std::string SerialCommunication::receiveMessage() {
-    if (serial_port < 0) {
-        std::cerr << "Serial port not opened." << std::endl;
-        return "";
+void SerialCommunication::processReceivedBytes(std::string_view bytes) {
+    uint64_t dropped = decoder.droppedCount();
+    decoder.feed(bytes, [this](std::string_view packet) {
+        std::string reply;
+        session.receive(packet, reply, "Serial");
+        if (!reply.empty()) {
+            std::string framed;
+            Slip::encodePacket(framed, reply);
+            enqueue_packet(std::move(framed));
+        }
+    });
+    if (decoder.droppedCount() != dropped) {
+        std::cerr << "Serial: dropped " << decoder.droppedCount() - dropped << " corrupted packet(s)" << std::endl;
     }
+}
 
-    char buffer[256];
-    memset(buffer, 0, sizeof(buffer));
-    int n = read(serial_port, buffer, sizeof(buffer));
+bool SerialCommunication::send_message(const std::string &message) {
+    std::string packet;
+    Slip::encodePacket(packet, session.encodeOutbound(message));
+    return enqueue_packet(std::move(packet));
+}
 
-    if (n > 0) {
-        return std::string(buffer, n);
-    } else {
-        return "";
+bool SerialCommunication::enqueue_packet(std::string packet) {
+    {
+        std::lock_guard<std::mutex> lock(send_mutex);
+        if (serial_port < 0) {
+            std::cerr << "Serial port not opened." << std::endl;
+            return false;
+        }
+        if (send_queue.size() >= send_queue_capacity) {
+            // At 57600 baud a burst can outrun the port; report once per 100 drops
+            if (send_dropped++ % 100 == 0) {
+                std::cerr << "Serial send queue full, " << send_dropped << " message(s) dropped so far" << std::endl;
+            }
+            return false;
+        }
+        send_queue.push_back(std::move(packet));
     }
+    send_condition.notify_one();
+    return true;
 }
 
-void SerialCommunication::processReceivedMessage(const std::string &message) {
+void SerialCommunication::writerFunction() {
+    while (true) {
+        std::string packet;
+        {
+            std::unique_lock<std::mutex> lock(send_mutex);
+            send_condition.wait(lock, [this] { return stop_flag || !send_queue.empty(); });
+            if (stop_flag) {
+                return;
+            }
+            packet = std::move(send_queue.front());
+            send_queue.pop_front();
+        }
+        write_all(packet);
+    }
+}
 
-    // Assuming the message is in the format "command:param1,param2,..."
-    size_t pos = message.find(':');
-    if (pos != std::string::npos) {
-        std::string command = message.substr(0, pos);
-        std::string params_str = message.substr(pos + 1);
-        std::vector<float> params;
-        size_t start = 0;
-        size_t end;
-        while ((end = params_str.find(',', start)) != std::string::npos) {
-            params.push_back(std::stof(params_str.substr(start, end - start)));
-            start = end + 1;
+bool SerialCommunication::write_all(const std::string &bytes) {
+    size_t written = 0;
+    while (written < bytes.size()) {
+        ssize_t n = write(serial_port, bytes.data() + written, bytes.size() - written);
+        if (n >= 0) {
+            written += n;
+            continue;
         }
-        if (start < params_str.length()) {
-            params.push_back(std::stof(params_str.substr(start)));
+        if (errno == EINTR) {
+            continue;
         }
-        if (command == "info") {
-            INVOKE_EVENT("InfoRequest");
-        } else if (command == "set_brightness") {
-            INVOKE_EVENT("set_brightness");
+        if (errno != EAGAIN) {
+            std::cerr << "Error writing to serial port: " << strerror(errno) << std::endl;
+            return false;
         }
-        else {
-            INVOKE_EVENT("command_received", command, params);
+
+        // Output buffer full: wait for room, or for stop()
+        pollfd fds[2] = {{serial_port, POLLOUT, 0}, {wake_fd, POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0 && errno != EINTR) {
+            std::cerr << "Error waiting on serial port: " << strerror(errno) << std::endl;
+            return false;
+        }
+        if (fds[1].revents) {
+            return false;
         }
-    } else {
-        std::cerr << "Invalid message format: " << message << std::endl;
     }
+    return true;
 }
 
-
-bool SerialCommunication::send_message(const std::string &message) {
-    std::lock_guard<std::mutex> lock(send_mutex);
-
+bool SerialCommunication::start() {
+    if (reader_thread.joinable()) {
+        return true;
+    }
+    // The constructor already opened the port; reopen only after a stop()
     if (serial_port < 0) {
-        std::cerr << "Serial port not opened." << std::endl;
-        return false;
+        openPort();
     }
-
-    int n = write(serial_port, message.c_str(), message.size());
-    if (n < 0) {
-        std::cerr << "Error writing to serial port: " << strerror(errno) << std::endl;
+    if (serial_port < 0) {
         return false;
-    } else {
-        std::cout << "Message sent: " << message << std::endl;
-        return true;;
     }
-}
-
-bool SerialCommunication::start() {
-    openPort();
     startWorker();
-    return true;
+    return wake_fd >= 0;
 }
 
 void SerialCommunication::stop() {
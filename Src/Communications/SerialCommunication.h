@@ -2,17 +2,22 @@
 #define SERIALCOMMUNICATION_H
 
 #include <string>
+#include <string_view>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <deque>
 #include <termios.h>
 #include "ICommunication.h"
+#include "BinaryProtocol.h"
+#include "SlipFraming.h"
 
 
-#include "../Modules/CommandManager.h"
-
-
+// Ground station link over a serial port. Messages travel in SLIP packets with a CRC, so line
+// noise and read boundaries never split or merge commands. A reader thread waits in epoll on
+// the port and an eventfd, which makes stop() immediate; a writer thread drains a bounded send
+// queue so send_message() never blocks the caller.
 class SerialCommunication : public ICommunication {
 public:
     enum class Result {
@@ -22,12 +27,12 @@ public:
         Unknown
     };
     // Constructor
-    SerialCommunication(const std::string &port, int baud_rate);
+    SerialCommunication(const std::string &port, int baud_rate, size_t send_queue_capacity = 64);
 
     // Destructor
     ~SerialCommunication();
 
-    // Send a message via the serial port
+    // Queue a message for the serial port. Returns false without blocking if the queue is full.
     bool send_message(const std::string &message) override;
 
     bool start() override;
@@ -43,20 +48,31 @@ private:
     // Asynchronous communication handling
     void startWorker();
     void stopWorker();
-    void workerFunction();
+    void readerFunction();
+    void writerFunction();
 
     // Message receiving and processing
-    std::string receiveMessage();
-    void processReceivedMessage(const std::string &message);
+    void processReceivedBytes(std::string_view bytes);
+    bool enqueue_packet(std::string packet);
+    bool write_all(const std::string &bytes);
 
     std::string port_name;
     int baud_rate;
     int serial_port;
+    int wake_fd = -1;   // eventfd, signalled once by stopWorker() to wake both threads
 
-    std::thread worker_thread;
+    std::thread reader_thread;
+    std::thread writer_thread;
     std::atomic<bool> stop_flag;
 
     std::mutex send_mutex;
+    std::condition_variable send_condition;
+    std::deque<std::string> send_queue;
+    size_t send_queue_capacity;
+    uint64_t send_dropped = 0;
+
+    Slip::Decoder decoder;
+    ProtocolSession session;
 
 };
 
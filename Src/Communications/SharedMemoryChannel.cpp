@@ -0,0 +1,249 @@
+#include "SharedMemoryChannel.h"
+#include <iostream>
+#include <cstring>
+#include <climits>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace {
+const uint32_t wrapMarker = UINT32_MAX;
+const uint32_t segmentMagic = 0x53484d31;  // "SHM1"
+const uint32_t segmentVersion = 1;
+
+size_t recordSize(size_t length) {
+    return (sizeof(uint32_t) + length + 3) & ~size_t(3);
+}
+
+// The futex word lives in a shared mapping, so the process-private futex ops cannot be used
+void futexWait(std::atomic<uint32_t>& word, uint32_t expected, int timeoutMs) {
+    timespec timeout{timeoutMs / 1000, (timeoutMs % 1000) * 1000000L};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected,
+            timeoutMs < 0 ? nullptr : &timeout, nullptr, 0);
+}
+
+void futexWake(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+std::string objectName(const std::string& name) {
+    return name.empty() || name[0] == '/' ? name : "/" + name;
+}
+}
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "ring positions are shared between processes");
+
+bool SharedMemoryRing::push(std::string_view message) {
+    if (message.size() > maxMessage(capacity)) {
+        return false;
+    }
+    size_t size = recordSize(message.size());
+    uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    size_t offset = tail & (capacity - 1);
+    size_t padding = capacity - offset < size ? capacity - offset : 0;
+    if (tail + padding + size - head > capacity) {
+        return false;
+    }
+    if (padding) {
+        std::memcpy(data + offset, &wrapMarker, sizeof(wrapMarker));
+        tail += padding;
+        offset = 0;
+    }
+    uint32_t length = static_cast<uint32_t>(message.size());
+    std::memcpy(data + offset, &length, sizeof(length));
+    std::memcpy(data + offset + sizeof(length), message.data(), message.size());
+
+    // Ordered before the consumerWaiting load: either the consumer sees the new tail before it
+    // sleeps, or this side sees it waiting and wakes it
+    header->tail.store(tail + size, std::memory_order_seq_cst);
+    if (header->consumerWaiting.load(std::memory_order_seq_cst)) {
+        wake();
+    }
+    return true;
+}
+
+bool SharedMemoryRing::pop(std::string& message) {
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    uint64_t tail = header->tail.load(std::memory_order_acquire);
+    // The positions and lengths come from a mapping the other process can write to, so nothing
+    // is trusted that would index past the data area
+    if (tail - head > capacity) {
+        return discardCorrupt(tail, "tail more than the capacity ahead of head");
+    }
+    while (head != tail) {
+        size_t offset = head & (capacity - 1);
+        if (capacity - offset < sizeof(uint32_t)) {
+            return discardCorrupt(tail, "record header past the end of the ring");
+        }
+        uint32_t length;
+        std::memcpy(&length, data + offset, sizeof(length));
+        if (length == wrapMarker) {
+            if (capacity - offset >= tail - head) {
+                return discardCorrupt(tail, "wrap marker at the tail");
+            }
+            head += capacity - offset;
+            continue;
+        }
+        if (length > maxMessage(capacity) || length > capacity - offset - sizeof(length)
+            || recordSize(length) > tail - head) {
+            return discardCorrupt(tail, "message length out of range");
+        }
+        message.assign(data + offset + sizeof(length), length);
+        header->head.store(head + recordSize(length), std::memory_order_release);
+        return true;
+    }
+    header->head.store(head, std::memory_order_release);
+    return false;
+}
+
+bool SharedMemoryRing::discardCorrupt(uint64_t tail, const char* reason) {
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    std::cerr << "Shared memory ring corrupted (" << reason << ") at head " << head << ", tail " << tail
+              << "; discarding everything queued" << std::endl;
+    header->head.store(tail, std::memory_order_release);
+    return false;
+}
+
+void SharedMemoryRing::wait(int timeoutMs) {
+    uint32_t signal = header->signal.load(std::memory_order_acquire);
+    header->consumerWaiting.store(1, std::memory_order_seq_cst);
+    if (header->head.load(std::memory_order_relaxed) == header->tail.load(std::memory_order_seq_cst)) {
+        // Returns at once if a wake bumped signal since it was read
+        futexWait(header->signal, signal, timeoutMs);
+    }
+    header->consumerWaiting.store(0, std::memory_order_relaxed);
+}
+
+void SharedMemoryRing::wake() {
+    header->signal.fetch_add(1, std::memory_order_release);
+    futexWake(header->signal);
+}
+
+void SharedMemoryRing::clear() {
+    header->head.store(header->tail.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+struct SharedMemoryChannel::Segment {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    std::atomic<uint32_t> clientAttached;
+    SharedMemoryRing::Header rings[2];      // To the service, to the client
+    // Followed by the two data areas, capacity bytes each
+
+    char* ringData(int ring) {
+        return reinterpret_cast<char*>(this + 1) + ring * capacity;
+    }
+};
+
+SharedMemoryChannel::~SharedMemoryChannel() {
+    close();
+}
+
+bool SharedMemoryChannel::create(const std::string& channelName, size_t requestedCapacity) {
+    close();
+    name = objectName(channelName);
+    side = Side::Service;
+    capacity = 4096;
+    while (capacity < requestedCapacity) {
+        capacity <<= 1;
+    }
+
+    // A segment left by a previous run may still be mapped by an old client; start a fresh one
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        std::cerr << "Error creating shared memory " << name << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    size_t bytes = sizeof(Segment) + 2 * capacity;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) < 0 || !map(fd, bytes)) {
+        std::cerr << "Error sizing shared memory " << name << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    ::close(fd);
+
+    // The object starts zeroed, which is the empty state of every field
+    new (segment) Segment{};
+    segment->capacity = capacity;
+    segment->version = segmentVersion;
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->magic = segmentMagic;
+    inbound = SharedMemoryRing(&segment->rings[0], segment->ringData(0), capacity);
+    outbound = SharedMemoryRing(&segment->rings[1], segment->ringData(1), capacity);
+    return true;
+}
+
+bool SharedMemoryChannel::open(const std::string& channelName) {
+    close();
+    name = objectName(channelName);
+    side = Side::Client;
+    int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    struct stat info{};
+    if (fd < 0 || fstat(fd, &info) < 0 || static_cast<size_t>(info.st_size) < sizeof(Segment)
+        || !map(fd, static_cast<size_t>(info.st_size))) {
+        std::cerr << "Error opening shared memory " << name << ": " << strerror(errno) << std::endl;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    ::close(fd);
+
+    uint64_t mappedCapacity = segment->capacity;
+    if (segment->magic != segmentMagic || segment->version != segmentVersion || mappedCapacity < 4096
+        || (mappedCapacity & (mappedCapacity - 1)) != 0 || mappedCapacity > mappedBytes
+        || sizeof(Segment) + 2 * mappedCapacity > mappedBytes) {
+        std::cerr << "Shared memory " << name << " is not a channel" << std::endl;
+        munmap(segment, mappedBytes);
+        segment = nullptr;
+        return false;
+    }
+    if (segment->clientAttached.exchange(1)) {
+        std::cerr << "Shared memory " << name << " already has a client" << std::endl;
+        munmap(segment, mappedBytes);
+        segment = nullptr;
+        return false;
+    }
+    capacity = segment->capacity;
+    inbound = SharedMemoryRing(&segment->rings[0], segment->ringData(0), capacity);
+    outbound = SharedMemoryRing(&segment->rings[1], segment->ringData(1), capacity);
+    // Whatever the service sent before anyone was listening is stale
+    outbound.clear();
+    return true;
+}
+
+void SharedMemoryChannel::close() {
+    if (!segment) {
+        return;
+    }
+    if (side == Side::Client) {
+        segment->clientAttached.store(0);
+    } else {
+        shm_unlink(name.c_str());
+    }
+    munmap(segment, mappedBytes);
+    segment = nullptr;
+}
+
+bool SharedMemoryChannel::clientAttached() const {
+    return segment && segment->clientAttached.load(std::memory_order_relaxed);
+}
+
+bool SharedMemoryChannel::map(int fd, size_t bytes) {
+    void* address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    segment = static_cast<Segment*>(address);
+    mappedBytes = bytes;
+    return true;
+}
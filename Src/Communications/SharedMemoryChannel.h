@@ -0,0 +1,95 @@
+#ifndef SHAREDMEMORYCHANNEL_H
+#define SHAREDMEMORYCHANNEL_H
+
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Single-producer single-consumer ring of length-prefixed messages inside a shared mapping.
+// Positions only grow; a message that would straddle the end is preceded by a wrap marker and
+// starts again at offset 0. The consumer sleeps on a futex word in the mapping and the producer
+// only makes the wake syscall when the consumer has said it is about to sleep, so a busy consumer
+// costs no syscalls at all. Neither side may be used from two threads at once.
+class SharedMemoryRing {
+public:
+    struct Header {
+        alignas(64) std::atomic<uint64_t> head;         // Consumer position
+        alignas(64) std::atomic<uint64_t> tail;         // Producer position
+        alignas(64) std::atomic<uint32_t> signal;       // Futex word, bumped on each wake
+        std::atomic<uint32_t> consumerWaiting;
+    };
+
+    SharedMemoryRing() = default;
+    SharedMemoryRing(Header* header, char* data, size_t capacity) : header(header), data(data), capacity(capacity) {}
+
+    // Producer side. False when the message does not fit in the free space.
+    bool push(std::string_view message);
+
+    // Consumer side. False when the ring is empty. A record that does not fit the ring means the
+    // mapping was corrupted: everything queued is discarded and logged, and false is returned.
+    bool pop(std::string& message);
+
+    // Consumer side. Returns once the ring is not empty, wake() is called or timeoutMs passes.
+    void wait(int timeoutMs);
+
+    // Wakes a consumer blocked in wait(), from any thread or process.
+    void wake();
+
+    // Consumer side. Discards everything queued.
+    void clear();
+
+    static size_t maxMessage(size_t capacity) { return capacity / 2 - sizeof(uint32_t); }
+
+private:
+    Header* header = nullptr;
+    char* data = nullptr;
+    size_t capacity = 0;    // Power of two
+
+    bool discardCorrupt(uint64_t tail, const char* reason);
+};
+
+// The mapping a companion process shares with SharedMemoryTransport: one ring each way in a POSIX
+// shared memory object (/dev/shm/<name>). The service creates it; the companion opens it and
+// marks itself attached while it holds the mapping.
+class SharedMemoryChannel {
+public:
+    enum class Side {
+        Service,
+        Client
+    };
+
+    SharedMemoryChannel() = default;
+    ~SharedMemoryChannel();
+    SharedMemoryChannel(const SharedMemoryChannel&) = delete;
+    SharedMemoryChannel& operator=(const SharedMemoryChannel&) = delete;
+
+    // capacity is per direction and rounded up to a power of two. The client takes the size from
+    // the mapping.
+    bool create(const std::string& name, size_t capacity);
+    bool open(const std::string& name);
+    void close();
+
+    // Messages from the companion to the service and from the service to the companion
+    SharedMemoryRing& toService() { return inbound; }
+    SharedMemoryRing& toClient() { return outbound; }
+
+    bool clientAttached() const;
+    size_t maxMessage() const { return SharedMemoryRing::maxMessage(capacity); }
+
+private:
+    struct Segment;
+
+    std::string name;
+    Side side = Side::Service;
+    Segment* segment = nullptr;
+    size_t mappedBytes = 0;
+    size_t capacity = 0;
+    SharedMemoryRing inbound;
+    SharedMemoryRing outbound;
+
+    bool map(int fd, size_t bytes);
+};
+
+#endif // SHAREDMEMORYCHANNEL_H
@@ -0,0 +1,69 @@
+#include "SharedMemoryTransport.h"
+#include <iostream>
+
+SharedMemoryTransport::SharedMemoryTransport(std::string name, size_t ringBytes)
+    : name(std::move(name)), ringBytes(ringBytes), running(false) {
+}
+
+SharedMemoryTransport::~SharedMemoryTransport() {
+    stop();
+}
+
+bool SharedMemoryTransport::start() {
+    if (!channel.create(name, ringBytes)) {
+        return false;
+    }
+    running = true;
+    std::cout << "Shared memory channel " << name << " ready, " << ringBytes << " bytes each way" << std::endl;
+    receiverThread = std::thread(&SharedMemoryTransport::receiveMessages, this);
+    return true;
+}
+
+void SharedMemoryTransport::stop() {
+    if (running) {
+        running = false;
+        channel.toService().wake();
+        if (receiverThread.joinable()) {
+            receiverThread.join();
+        }
+        channel.close();
+        std::cout << "Shared memory channel " << name << " closed." << std::endl;
+    }
+}
+
+void SharedMemoryTransport::receiveMessages() {
+    std::string message;
+    std::string reply;
+    while (running) {
+        // Bounded so a stop() that lands between the running check and the sleep is not missed
+        channel.toService().wait(100);
+        while (running && channel.toService().pop(message)) {
+            session.receive(message, reply, "SHM");
+            if (!reply.empty()) {
+                push(reply);
+                reply.clear();
+            }
+        }
+    }
+}
+
+bool SharedMemoryTransport::send_message(const std::string& message) {
+    if (!running || !channel.clientAttached()) {
+        std::cerr << "No client attached to " << name << std::endl;
+        return false;
+    }
+    return push(session.encodeOutbound(message));
+}
+
+bool SharedMemoryTransport::push(const std::string& bytes) {
+    bool pushed;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        pushed = channel.toClient().push(bytes);
+    }
+    if (!pushed && dropped++ % 100 == 0) {
+        std::cerr << "Shared memory client on " << name << " is not keeping up, " << dropped
+                  << " message(s) dropped so far" << std::endl;
+    }
+    return pushed;
+}
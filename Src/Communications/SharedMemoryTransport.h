@@ -0,0 +1,43 @@
+#ifndef SHAREDMEMORYTRANSPORT_H
+#define SHAREDMEMORYTRANSPORT_H
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+#include "ICommunication.h"
+#include "BinaryProtocol.h"
+#include "SharedMemoryChannel.h"
+
+// One companion process over a SharedMemoryChannel, for the lowest local latency: a message is a
+// copy into the ring, and a syscall only when the other side is asleep. The receive thread publishes
+// commands itself, as there is a single peer to serve. Outbound messages are dropped while no
+// companion is attached or when the ring is full.
+class SharedMemoryTransport : public ICommunication {
+public:
+    SharedMemoryTransport(std::string name, size_t ringBytes);
+    ~SharedMemoryTransport();
+
+    bool start() override;
+    void stop() override;
+    bool send_message(const std::string& message) override;
+
+    uint64_t getDroppedCount() const { return dropped; }
+
+private:
+    std::string name;
+    size_t ringBytes;
+    SharedMemoryChannel channel;
+    std::atomic<bool> running;
+    std::thread receiverThread;
+    ProtocolSession session;
+
+    std::mutex sendMutex;   // The ring takes one producer; replies and send_message share it
+    std::atomic<uint64_t> dropped{0};
+
+    void receiveMessages();
+    bool push(const std::string& bytes);
+};
+
+#endif // SHAREDMEMORYTRANSPORT_H
@@ -0,0 +1,45 @@
+#include "SlipFraming.h"
+#include "BinaryProtocol.h"
+
+namespace Slip {
+
+namespace {
+
+void appendEscaped(std::string& out, uint8_t byte) {
+    if (byte == End) {
+        out.push_back(static_cast<char>(Esc));
+        out.push_back(static_cast<char>(EscEnd));
+    } else if (byte == Esc) {
+        out.push_back(static_cast<char>(Esc));
+        out.push_back(static_cast<char>(EscEsc));
+    } else {
+        out.push_back(static_cast<char>(byte));
+    }
+}
+
+}
+
+void encodePacket(std::string& out, std::string_view payload) {
+    uint16_t crc = BinaryProtocol::crc16(reinterpret_cast<const uint8_t*>(payload.data()), payload.size());
+
+    out.reserve(out.size() + payload.size() + payload.size() / 32 + 2 * CrcSize + 2);
+    out.push_back(static_cast<char>(End));
+    for (char c : payload) {
+        appendEscaped(out, static_cast<uint8_t>(c));
+    }
+    appendEscaped(out, static_cast<uint8_t>(crc & 0xFF));
+    appendEscaped(out, static_cast<uint8_t>(crc >> 8));
+    out.push_back(static_cast<char>(End));
+}
+
+bool Decoder::checkPacket() const {
+    if (packet.size() < CrcSize) {
+        return false;
+    }
+    size_t size = packet.size() - CrcSize;
+    auto bytes = reinterpret_cast<const uint8_t*>(packet.data());
+    uint16_t received = static_cast<uint16_t>(bytes[size] | (bytes[size + 1] << 8));
+    return BinaryProtocol::crc16(bytes, size) == received;
+}
+
+}
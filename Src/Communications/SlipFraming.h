@@ -0,0 +1,95 @@
+#ifndef SLIPFRAMING_H
+#define SLIPFRAMING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// SLIP packets (RFC 1055) for byte links without message boundaries, such as the ground station
+// serial port. Each packet carries one protocol message, text or binary frames, followed by its
+// CRC-16/CCITT-FALSE in little-endian, so a packet damaged by line noise is dropped whole
+// instead of being parsed. Packets start and end with End, which also resynchronises the
+// receiver after noise.
+namespace Slip {
+
+constexpr uint8_t End = 0xC0;
+constexpr uint8_t Esc = 0xDB;
+constexpr uint8_t EscEnd = 0xDC;
+constexpr uint8_t EscEsc = 0xDD;
+constexpr size_t CrcSize = 2;
+
+// Appends the encoded packet to out.
+void encodePacket(std::string& out, std::string_view payload);
+
+class Decoder {
+public:
+    explicit Decoder(size_t maxPayload) : maxPayload(maxPayload) {
+        packet.reserve(maxPayload + CrcSize);
+    }
+
+    // Calls onPacket(std::string_view payload) for every complete packet with a valid CRC.
+    // Partial packets carry over to the next call.
+    template<typename OnPacket>
+    void feed(std::string_view data, OnPacket&& onPacket) {
+        for (char c : data) {
+            auto byte = static_cast<uint8_t>(c);
+            if (byte == End) {
+                if (!discarding && !packet.empty()) {
+                    if (checkPacket()) {
+                        onPacket(std::string_view(packet.data(), packet.size() - CrcSize));
+                    } else {
+                        ++dropped;
+                    }
+                }
+                packet.clear();
+                escaped = false;
+                discarding = false;
+                continue;
+            }
+            if (discarding) {
+                continue;
+            }
+            if (escaped) {
+                escaped = false;
+                if (byte == EscEnd) {
+                    byte = End;
+                } else if (byte == EscEsc) {
+                    byte = Esc;
+                } else {
+                    discard();
+                    continue;
+                }
+            } else if (byte == Esc) {
+                escaped = true;
+                continue;
+            }
+            if (packet.size() == maxPayload + CrcSize) {
+                discard();
+                continue;
+            }
+            packet.push_back(static_cast<char>(byte));
+        }
+    }
+
+    // Packets dropped for a bad CRC, a bad escape or exceeding maxPayload.
+    uint64_t droppedCount() const { return dropped; }
+
+private:
+    std::string packet;
+    size_t maxPayload;
+    bool escaped = false;
+    bool discarding = false;    // Skipping the rest of a broken packet up to the next End
+    uint64_t dropped = 0;
+
+    bool checkPacket() const;
+
+    void discard() {
+        discarding = true;
+        ++dropped;
+    }
+};
+
+}
+
+#endif // SLIPFRAMING_H
@@ -0,0 +1,55 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// Fixed-size receive buffer for one stream connection. Reads go straight into the free space at
+// the tail and complete messages are consumed from the head. The partial message left over is
+// moved back to the front only when the tail runs out of room, so the parser always sees
+// contiguous bytes and each byte is copied at most once more.
+class StreamBuffer {
+public:
+    explicit StreamBuffer(size_t capacity) : storage(capacity) {}
+
+    // Free space for the next read. Empty only when unconsumed bytes fill the whole buffer.
+    char* writePointer() {
+        compact();
+        return storage.data() + tail;
+    }
+
+    size_t writable() {
+        compact();
+        return storage.size() - tail;
+    }
+
+    void commit(size_t bytes) { tail += bytes; }
+
+    std::string_view data() const { return std::string_view(storage.data() + head, tail - head); }
+
+    void consume(size_t bytes) {
+        head += bytes;
+        if (head == tail) {
+            head = tail = 0;
+        }
+    }
+
+    bool full() const { return head == 0 && tail == storage.size(); }
+
+private:
+    std::vector<char> storage;
+    size_t head = 0;
+    size_t tail = 0;
+
+    void compact() {
+        if (tail == storage.size() && head > 0) {
+            std::memmove(storage.data(), storage.data() + head, tail - head);
+            tail -= head;
+            head = 0;
+        }
+    }
+};
+
+#endif // STREAMBUFFER_H
@@ -3,19 +3,29 @@
 #include <cstring>
 #include <unistd.h>
 #include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <algorithm>
 #include <opencv2/imgcodecs.hpp>
 
-#include "../../Events/EventManager.h"
+#include "CommandParser.h"
+#include "ReceiveTimestamp.h"
 
+namespace {
+// TCP may coalesce several commands into one read or split one across reads, so each connection
+// frames its bytes and only whole messages are queued; a partial one waits for the next read.
+const size_t receiveBufferSize = 16 * 1024;
+const size_t maxLineLength = 1024;
+const int maxEvents = 64;
+}
 
-TCPServer::TCPServer(int port) : port(port), serverSocket(-1), running(false) {
+TCPServer::TCPServer(int port)
+    : serverSocket(-1), epollFd(-1), wakeFd(-1), port(port), running(false), outboundConfig(OutboundQueue::loadConfig()) {
     std::memset(&serverAddr, 0, sizeof(serverAddr));
 }
 
 TCPServer::~TCPServer() {
     stop();
-    cleanupThreads();
 }
 
 void TCPServer::setupServerAddress() {
@@ -25,12 +35,20 @@ void TCPServer::setupServerAddress() {
 }
 
 bool TCPServer::start() {
-    serverSocket = socket(AF_INET, SOCK_STREAM, 0);
+    serverSocket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (serverSocket < 0) {
         std::cerr << "Error creating socket: " << strerror(errno) << std::endl;
         return false;
     }
 
+    int reuse = 1;
+    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    // Accepted sockets inherit the option
+    if (!ReceiveTimestamp::enable(serverSocket)) {
+        std::cerr << "No kernel receive timestamps on TCP: " << strerror(errno) << std::endl;
+    }
+
     setupServerAddress();
 
     if (bind(serverSocket, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
@@ -39,16 +57,34 @@ bool TCPServer::start() {
         return false;
     }
 
-    if (listen(serverSocket, 10) < 0) {
+    if (listen(serverSocket, SOMAXCONN) < 0) {
         std::cerr << "Error listening on socket: " << strerror(errno) << std::endl;
         close(serverSocket);
         return false;
     }
 
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd < 0 || wakeFd < 0) {
+        std::cerr << "Error creating epoll instance: " << strerror(errno) << std::endl;
+        for (int fd : {epollFd, wakeFd, serverSocket}) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = serverSocket;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, serverSocket, &event);
+    event.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
     running = true;
     std::cout << "Server started on port " << port << std::endl;
 
-    std::thread(&TCPServer::acceptConnections, this).detach();
+    reactorThread = std::thread(&TCPServer::runReactor, this);
     commandProcessorThread = std::thread(&TCPServer::processCommands, this);
 
     return true;
@@ -57,8 +93,27 @@ bool TCPServer::start() {
 void TCPServer::stop() {
     if (running) {
         running = false;
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {
+            std::cerr << "Error waking TCP reactor: " << strerror(errno) << std::endl;
+        }
+        if (reactorThread.joinable()) {
+            reactorThread.join();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(clientSocketsMutex);
+            for (auto& [clientSocket, connection] : connections) {
+                connection->closed = true;
+                close(clientSocket);
+            }
+            connections.clear();
+        }
         close(serverSocket);
+        close(epollFd);
+        close(wakeFd);
         std::cout << "Server stopped." << std::endl;
+
         queueCondition.notify_all();
         if (commandProcessorThread.joinable()) {
             commandProcessorThread.join();
@@ -66,129 +121,246 @@ void TCPServer::stop() {
     }
 }
 
+void TCPServer::runReactor() {
+    epoll_event events[maxEvents];
+    while (running) {
+        int ready = epoll_wait(epollFd, events, maxEvents, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error waiting for TCP events: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd) {
+                continue;
+            }
+            if (fd == serverSocket) {
+                acceptConnections();
+                continue;
+            }
+
+            std::shared_ptr<Connection> connection;
+            {
+                std::lock_guard<std::mutex> lock(clientSocketsMutex);
+                auto it = connections.find(fd);
+                if (it == connections.end()) {
+                    continue;
+                }
+                connection = it->second;
+                if (events[i].events & EPOLLOUT) {
+                    flushOutbound(*connection);
+                }
+            }
+            // Errors and hang-ups surface as a failed or empty recv
+            if ((events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && !readFromClient(connection)) {
+                closeConnection(connection);
+            }
+        }
+    }
+}
+
 void TCPServer::acceptConnections() {
     while (running) {
-        int clientSocket = accept(serverSocket, nullptr, nullptr);
+        sockaddr_in clientAddr{};
+        socklen_t clientAddrLen = sizeof(clientAddr);
+        int clientSocket = accept4(serverSocket, (struct sockaddr*)&clientAddr, &clientAddrLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
         if (clientSocket < 0) {
-            if (running) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // Typically EMFILE; the listening socket stays readable and is retried on the next event
                 std::cerr << "Error accepting connection: " << strerror(errno) << std::endl;
             }
-            continue;
+            return;
         }
 
-        std::cout << "Client connected." << std::endl;
+        char addr[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &clientAddr.sin_addr, addr, sizeof(addr));
+        auto connection = std::make_shared<Connection>(clientSocket, std::string(addr) + ":" + std::to_string(ntohs(clientAddr.sin_port)),
+                                                       receiveBufferSize, outboundConfig);
         {
             std::lock_guard<std::mutex> lock(clientSocketsMutex);
-            clientSockets.push_back(clientSocket);
+            connections[clientSocket] = connection;
         }
-        clientThreads.emplace_back(&TCPServer::handleClient, this, clientSocket);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = clientSocket;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, clientSocket, &event);
+        std::cout << "Client connected." << std::endl;
     }
 }
 
-void TCPServer::handleClient(int clientSocket) {
-    const int bufferSize = 1024;
-    char buffer[bufferSize];
-
-    while (running) {
-        int bytesReceived = recv(clientSocket, buffer, bufferSize - 1, 0);
-        if (bytesReceived < 0) {
-            std::cerr << "Error receiving data: " << strerror(errno) << std::endl;
-            break;
-        } else if (bytesReceived == 0) {
-            std::cout << "Client disconnected." << std::endl;
-            break;
+// Reads once per readiness event; the socket is level-triggered, so a busy client cannot
+// starve the others. Returns false when the connection should be closed.
+bool TCPServer::readFromClient(const std::shared_ptr<Connection>& connection) {
+    StreamBuffer& buffer = connection->buffer;
+    iovec vector{buffer.writePointer(), buffer.writable()};
+    char control[ReceiveTimestamp::ControlSize];
+    msghdr header{};
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+    ssize_t bytesReceived = recvmsg(connection->socket, &header, 0);
+    if (bytesReceived < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return true;
         }
+        std::cerr << "Error receiving data: " << strerror(errno) << std::endl;
+        return false;
+    } else if (bytesReceived == 0) {
+        std::cout << "Client disconnected." << std::endl;
+        return false;
+    }
+    timespec receivedRealtime;
+    clock_gettime(CLOCK_REALTIME, &receivedRealtime);
+    buffer.commit(bytesReceived);
 
-        buffer[bytesReceived] = '\0';
-
+    BinaryProtocol::StreamScan scan = BinaryProtocol::scanStream(buffer.data(), maxLineLength);
+    if (scan.complete > 0) {
         {
             std::lock_guard<std::mutex> lock(queueMutex);
-            commandQueue.push(buffer);
+            // For TCP the kernel reports the timestamp of the last segment read, the one that
+            // completed these messages
+            commandQueue.push({connection, std::string(buffer.data().substr(0, scan.complete)),
+                               CommandTrace::received(ReceiveTimestamp::find(header), receivedRealtime)});
         }
         queueCondition.notify_one();
+        buffer.consume(scan.complete);
+    }
+    if (scan.error != BinaryProtocol::FrameStatus::Ok) {
+        std::cerr << "Framing error from client: " << BinaryProtocol::frameStatusString(scan.error)
+                  << ", closing connection." << std::endl;
+        return false;
     }
+    return true;
+}
 
-    close(clientSocket);
-    {
-        std::lock_guard<std::mutex> lock(clientSocketsMutex);
-        clientSockets.erase(std::remove(clientSockets.begin(), clientSockets.end(), clientSocket), clientSockets.end());
+void TCPServer::closeConnection(const std::shared_ptr<Connection>& connection) {
+    // Closed under the lock so a sender never writes to a descriptor that was already reused
+    std::lock_guard<std::mutex> lock(clientSocketsMutex);
+    if (connection->closed) {
+        return;
     }
+    connection->closed = true;
+    connections.erase(connection->socket);
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->socket, nullptr);
+    close(connection->socket);
 }
+
 void TCPServer::processCommands() {
     while (running) {
         std::unique_lock<std::mutex> lock(queueMutex);
         queueCondition.wait(lock, [this] { return !commandQueue.empty() || !running; });
 
         while (!commandQueue.empty()) {
-            std::string message = commandQueue.front();
+            PendingMessages pending = std::move(commandQueue.front());
             commandQueue.pop();
             lock.unlock();
 
-                size_t pos = message.find(':');
-                if (pos != std::string::npos) {
-                    std::string command = message.substr(0, pos);
-                    std::string params_str = message.substr(pos + 1);
-                    std::vector<float> params;
-                    size_t start = 0;
-                    size_t end;
-                    while ((end = params_str.find(',', start)) != std::string::npos) {
-                        params.push_back(std::stof(params_str.substr(start, end - start)));
-                        start = end + 1;
-                    }
-                    if (start < params_str.length()) {
-                        params.push_back(std::stof(params_str.substr(start)));
-                    }
-
-                    if(command == "info"){
-                        INVOKE_EVENT("InfoRequest");
-
-                    }
-                    else if (command == "set_brightness") {
-                        INVOKE_EVENT("set_brightness");
-                    }
-                    else {
-                        INVOKE_EVENT("command_received", command, params);
-                    }
-                } else {
-                    std::cerr << "Invalid message format: " << message << std::endl;
-                }
+            std::string reply;
+            auto& connection = pending.connection;
+            CommandTrace::Scope trace(&pending.trace);
+            connection->session.receive(pending.bytes, reply, "TCP");
+            if (!reply.empty()) {
+                std::lock_guard<std::mutex> clientsLock(clientSocketsMutex);
+                sendToClient(*connection, std::move(reply));
             }
 
             lock.lock();
         }
     }
-
-void TCPServer::cleanupThreads() {
-    for (auto& thread : clientThreads) {
-        if (thread.joinable()) {
-            thread.join();
-        }
-    }
-    clientThreads.clear();
 }
 
 bool TCPServer::send_message(const std::string& message) {
     std::lock_guard<std::mutex> lock(clientSocketsMutex);
-    if (clientSockets.empty()) {
+    if (connections.empty()) {
         std::cerr << "No clients connected" << std::endl;
         return false;
     }
 
-    size_t totalBytesSent = 0;
-    size_t messageLength = message.size();
-    const char* messagePtr = message.c_str();
+    for (auto& [clientSocket, connection] : connections) {
+        sendToClient(*connection, connection->session.encodeOutbound(message));
+    }
 
-    for (int clientSocket : clientSockets) {
-        totalBytesSent = 0;
-        while (totalBytesSent < messageLength) {
-            ssize_t bytesSent = send(clientSocket, messagePtr + totalBytesSent, messageLength - totalBytesSent, 0);
-            if (bytesSent < 0) {
-                std::cerr << "Failed to send message to client. Error: " << strerror(errno) << std::endl;
-                break;
+    return true;
+}
+
+// Callers hold clientSocketsMutex. Queues the bytes and writes what the socket takes now; the
+// rest is written by the reactor on EPOLLOUT.
+bool TCPServer::sendToClient(Connection& connection, std::string bytes) {
+    if (connection.closed || connection.disconnecting) {
+        return false;
+    }
+
+    switch (connection.outbound.push(std::move(bytes))) {
+        case OutboundQueue::PushResult::Queued:
+            break;
+        case OutboundQueue::PushResult::Dropped: {
+            uint64_t dropped = connection.outbound.stats().dropped;
+            if (dropped % 100 == 1) {
+                std::cerr << "TCP client " << connection.peer << " is not keeping up, " << dropped
+                          << " message(s) dropped (" << OutboundQueue::policyString(outboundConfig.policy) << ")" << std::endl;
             }
-            totalBytesSent += bytesSent;
+            break;
         }
+        case OutboundQueue::PushResult::Overflow:
+            std::cerr << "TCP client " << connection.peer << " is not keeping up, disconnecting." << std::endl;
+            // The reactor sees the shutdown as a hang-up and closes the connection
+            connection.disconnecting = true;
+            shutdown(connection.socket, SHUT_RDWR);
+            return false;
     }
 
+    if (!connection.writeArmed) {
+        flushOutbound(connection);
+    }
     return true;
-}
\ No newline at end of file
+}
+
+// Callers hold clientSocketsMutex.
+void TCPServer::flushOutbound(Connection& connection) {
+    while (!connection.outbound.empty()) {
+        std::string_view bytes = connection.outbound.front();
+        ssize_t bytesSent = send(connection.socket, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+        if (bytesSent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // The reactor sees the same error on its next read and closes the connection
+                std::cerr << "Failed to send message to client. Error: " << strerror(errno) << std::endl;
+                return;
+            }
+            break;
+        }
+        connection.outbound.consume(bytesSent);
+    }
+    setWriteInterest(connection, !connection.outbound.empty());
+}
+
+std::vector<ClientQueueStats> TCPServer::getClientQueueStats() {
+    std::lock_guard<std::mutex> lock(clientSocketsMutex);
+    std::vector<ClientQueueStats> stats;
+    stats.reserve(connections.size());
+    for (auto& [clientSocket, connection] : connections) {
+        stats.push_back({connection->peer, connection->outbound.stats()});
+    }
+    return stats;
+}
+
+void TCPServer::setWriteInterest(Connection& connection, bool enabled) {
+    if (connection.writeArmed == enabled) {
+        return;
+    }
+    epoll_event event{};
+    event.events = enabled ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.fd = connection.socket;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.socket, &event);
+    connection.writeArmed = enabled;
+}
@@ -10,11 +10,21 @@
 #include <queue>
 #include <memory>
 #include <condition_variable>
+#include <unordered_map>
 #include <opencv2/core/mat.hpp>
 
 #include "../Modules/CommandManager.h"
 #include "ICommunication.h"
+#include "BinaryProtocol.h"
+#include "StreamBuffer.h"
+#include "OutboundQueue.h"
+#include "../../Events/CommandTrace.h"
 
+// Ground station and observer connections over TCP. One reactor thread owns the listening socket
+// and every client socket, all non-blocking, and handles accept, read and write through epoll;
+// complete messages go to a command processor thread. The thread count stays at two however many
+// clients connect or reconnect. Each client has a bounded outbound queue, so sending never waits
+// on a slow client.
 class TCPServer : public ICommunication {
 public:
     TCPServer(int port);
@@ -22,31 +32,63 @@ public:
 
     bool start() override;
     void stop() override;
-    void handleClient(int clientSocket);
     bool send_message(const std::string& message) override;
     void setCommandManager(std::shared_ptr<CommandManager> command);
 
     bool send_frame(const cv::Mat& frame);
 
+    std::vector<ClientQueueStats> getClientQueueStats();
+
 
 private:
+    struct Connection {
+        Connection(int socket, std::string peer, size_t bufferSize, const OutboundQueue::Config& outboundConfig)
+            : socket(socket), peer(std::move(peer)), buffer(bufferSize), outbound(outboundConfig) {}
+
+        int socket;
+        std::string peer;
+        StreamBuffer buffer;        // Reactor thread only
+        ProtocolSession session;
+
+        // Guarded by clientSocketsMutex
+        OutboundQueue outbound;
+        bool writeArmed = false;    // EPOLLOUT registered
+        bool closed = false;
+        bool disconnecting = false; // Overflowed under the disconnect policy; the reactor closes it
+    };
+
     int serverSocket;
-    std::vector<int> clientSockets;
+    int epollFd;
+    int wakeFd;
+    std::unordered_map<int, std::shared_ptr<Connection>> connections;
     int port;
     sockaddr_in serverAddr;
     std::atomic<bool> running;
-    std::vector<std::thread> clientThreads;
+    std::thread reactorThread;
     std::mutex clientSocketsMutex;
+    OutboundQueue::Config outboundConfig;
+
+    // Complete messages from one read; they share the read's receive timestamp
+    struct PendingMessages {
+        std::shared_ptr<Connection> connection;
+        std::string bytes;
+        CommandTrace trace;
+    };
 
-    std::queue<std::string> commandQueue;
+    std::queue<PendingMessages> commandQueue;
     std::mutex queueMutex;
     std::condition_variable queueCondition;
     std::thread commandProcessorThread;
 
     void setupServerAddress();
+    void runReactor();
     void acceptConnections();
-    void cleanupThreads();
+    bool readFromClient(const std::shared_ptr<Connection>& connection);
+    void flushOutbound(Connection& connection);
+    void closeConnection(const std::shared_ptr<Connection>& connection);
     void processCommands();
+    bool sendToClient(Connection& connection, std::string bytes);
+    void setWriteInterest(Connection& connection, bool enabled);
 };
 
 #endif // TCPSERVER_H
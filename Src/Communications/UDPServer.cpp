@@ -3,13 +3,30 @@
 #include <cstring>
 #include <unistd.h>
 #include <arpa/inet.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <array>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/core/mat.hpp>
 
-#include "../../Events/EventManager.h"
+#include "CommandParser.h"
+#include "ReceiveTimestamp.h"
+#include "../../Events/EventChannels.h"
+#include "../../inih/cpp/INIReader.h"
 
-UDPServer::UDPServer(int port) : port(port), serverSocket(-1), running(false) {
+namespace {
+// recvmmsg fills up to receiveBatchSize slots of the receive pool per call; larger datagrams are dropped
+constexpr size_t receiveBatchSize = 32;
+constexpr size_t datagramBufferSize = 2048;
+// Clients served by one sendmmsg
+constexpr size_t sendBatchSize = 64;
+}
+
+UDPServer::UDPServer(int port)
+    : port(port), serverSocket(-1), running(false), outboundConfig(OutboundQueue::loadConfig()) {
     std::memset(&serverAddr, 0, sizeof(serverAddr));
+    INIReader reader("../config.ini");
+    clientLease = std::chrono::seconds(reader.GetInteger("UDP", "ClientLeaseSeconds", 30));
 }
 
 UDPServer::~UDPServer() {
@@ -36,14 +53,15 @@ bool UDPServer::start() {
         close(serverSocket);
         return false;
     }
+    if (!ReceiveTimestamp::enable(serverSocket)) {
+        std::cerr << "No kernel receive timestamps on UDP: " << strerror(errno) << std::endl;
+    }
 
     running = true;
     std::cout << "UDP Server started on port " << port << std::endl;
-    SUBSCRIBE_TO_EVENT("send_ack", ([this]( const std::string & command) {
-        send_message("Ack: " + command);
-    }));
-    std::thread(&UDPServer::receiveMessages, this).detach();
+    receiverThread = std::thread(&UDPServer::receiveMessages, this);
     commandProcessorThread = std::thread(&UDPServer::processCommands, this);
+    senderThread = std::thread(&UDPServer::sendQueuedDatagrams, this);
 
     return true;
 }
@@ -51,7 +69,19 @@ bool UDPServer::start() {
 void UDPServer::stop() {
     if (running) {
         running = false;
+        // Wakes recvmmsg even though the socket is unconnected
+        shutdown(serverSocket, SHUT_RDWR);
+        if (receiverThread.joinable()) {
+            receiverThread.join();
+        }
         queueCondition.notify_all();
+        {
+            std::lock_guard<std::mutex> lock(clientAddressesMutex);
+        }
+        sendCondition.notify_all();
+        if (senderThread.joinable()) {
+            senderThread.join();
+        }
         close(serverSocket);
         std::cout << "Server stopped." << std::endl;
 
@@ -62,125 +92,279 @@ void UDPServer::stop() {
 }
 
 void UDPServer::receiveMessages() {
+    std::vector<char> pool(receiveBatchSize * datagramBufferSize);
+    std::array<mmsghdr, receiveBatchSize> headers;
+    std::array<iovec, receiveBatchSize> vectors;
+    std::array<sockaddr_in, receiveBatchSize> addresses;
+    std::array<std::array<char, ReceiveTimestamp::ControlSize>, receiveBatchSize> controls;
+    std::vector<Datagram> batch;
+
     while (running) {
-        sockaddr_in clientAddr;
-        socklen_t clientAddrLen = sizeof(clientAddr);
-        const int bufferSize = 1024;
-        char buffer[bufferSize];
-
-        int bytesReceived = recvfrom(serverSocket, buffer, bufferSize - 1, 0, (struct sockaddr*)&clientAddr, &clientAddrLen);
-        if (bytesReceived < 0) {
-            if (errno != EWOULDBLOCK && errno != EAGAIN) {
-                std::cerr << "Error receiving data: " << strerror(errno) << std::endl;
-            }
+        for (size_t i = 0; i < receiveBatchSize; ++i) {
+            vectors[i] = {pool.data() + i * datagramBufferSize, datagramBufferSize};
+            headers[i] = {};
+            headers[i].msg_hdr.msg_name = &addresses[i];
+            headers[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+            headers[i].msg_hdr.msg_iov = &vectors[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+            headers[i].msg_hdr.msg_control = controls[i].data();
+            headers[i].msg_hdr.msg_controllen = controls[i].size();
+        }
+
+        // Blocks for the first datagram, then takes whatever else is already waiting
+        int received = recvmmsg(serverSocket, headers.data(), receiveBatchSize, MSG_WAITFORONE, nullptr);
+        if (received <= 0) {
             if (!running) {
                 break; // Exit if not running
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Prevent tight loop on error
+            if (received < 0 && errno != EINTR) {
+                std::cerr << "Error receiving data: " << strerror(errno) << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Prevent tight loop on error
+            }
             continue;
         }
+        timespec receivedRealtime;
+        clock_gettime(CLOCK_REALTIME, &receivedRealtime);
+        receiveCalls.fetch_add(1, std::memory_order_relaxed);
+        datagramsReceived.fetch_add(received, std::memory_order_relaxed);
 
-        buffer[bytesReceived] = '\0';
+        for (int i = 0; i < received; ++i) {
+            if (headers[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                std::cerr << "Dropping datagram from " << clientAddrToString(addresses[i])
+                          << " larger than " << datagramBufferSize << " bytes" << std::endl;
+                continue;
+            }
+            batch.push_back({std::string(pool.data() + i * datagramBufferSize, headers[i].msg_len), addresses[i],
+                             CommandTrace::received(ReceiveTimestamp::find(headers[i].msg_hdr), receivedRealtime)});
+        }
+        if (batch.empty()) {
+            continue;
+        }
 
         {
             std::lock_guard<std::mutex> lock(queueMutex);
-            commandQueue.emplace(buffer, clientAddr);
+            if (commandQueue.empty()) {
+                commandQueue.swap(batch);
+            } else {
+                commandQueue.insert(commandQueue.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+            }
         }
+        batch.clear();
         queueCondition.notify_one();
-
-        addClientAddress(clientAddr);
     }
 }
 
 void UDPServer::processCommands() {
+    std::vector<Datagram> pending;
+    std::vector<std::shared_ptr<Client>> senders;
     while (running) {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        queueCondition.wait(lock, [this] { return !commandQueue.empty() || !running; });
-
-        while (!commandQueue.empty()) {
-            auto [message, clientAddr] = commandQueue.front();
-            commandQueue.pop();
-            lock.unlock();
-
-            size_t pos = message.find(':');
-            if (pos != std::string::npos) {
-                std::string command = message.substr(0, pos);
-                std::string params_str = message.substr(pos + 1);
-                std::vector<float> params;
-
-                size_t start = 0;
-                size_t end;
-                while ((end = params_str.find(',', start)) != std::string::npos) {
-                    try {
-                        params.push_back(std::stof(params_str.substr(start, end - start)));
-                    } catch (const std::exception& e) {
-                        std::cerr << "Error parsing parameter: " << e.what() << std::endl;
-                    }
-                    start = end + 1;
-                }
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return !commandQueue.empty() || !running; });
+            pending.swap(commandQueue);
+        }
 
-                if (start < params_str.length()) {
-                    try {
-                        params.push_back(std::stof(params_str.substr(start)));
-                    } catch (const std::exception& e) {
-                        std::cerr << "Error parsing parameter: " << e.what() << std::endl;
-                    }
-                }
+        // Look up (and renew) every sender of the batch under one lock
+        {
+            auto now = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> clientsLock(clientAddressesMutex);
+            for (const auto& datagram : pending) {
+                senders.push_back(addClientAddress(datagram.from, now));
+            }
+        }
 
-                if (command == "info") {
-                    INVOKE_EVENT("InfoRequest");
-                } else if (command == "set_brightness") {
-                    INVOKE_EVENT("set_brightness");
-                }
-                else {
-                     INVOKE_EVENT("command_received", command, params);
-                }
-            } else {
-                std::cerr << "Invalid message format: " << message << std::endl;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            Client& client = *senders[i];
+            std::string reply;
+            CommandTrace::Scope trace(&pending[i].trace);
+            client.session.receive(pending[i].bytes, reply, "UDP");
+            if (!reply.empty()) {
+                std::lock_guard<std::mutex> clientsLock(clientAddressesMutex);
+                queueForClient(client, std::move(reply));
             }
-            lock.lock();
         }
+        pending.clear();
+        senders.clear();
     }
 }
 
 bool UDPServer::send_message(const std::string& message) {
     std::lock_guard<std::mutex> lock(clientAddressesMutex);
+    expireClients(std::chrono::steady_clock::now());
     if (clientAddresses.empty()) {
         std::cerr << "No clients to send the message to" << std::endl;
         return false;
     }
 
-    for (const auto& clientAddrStr : clientAddresses) {
-        sockaddr_in clientAddr;
-        size_t colonPos = clientAddrStr.find(':');
-        if (colonPos == std::string::npos) {
-            std::cerr << "Invalid client address format: " << clientAddrStr << std::endl;
-            continue;
+    for (auto it = clientAddresses.begin(); it != clientAddresses.end();) {
+        Client& client = *it->second;
+        if (queueForClient(client, client.session.encodeOutbound(message)) == OutboundQueue::PushResult::Overflow) {
+            std::cerr << "UDP client " << client.name << " is not keeping up, dropping it." << std::endl;
+            it = clientAddresses.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return true;
+}
+
+// Callers hold clientAddressesMutex.
+OutboundQueue::PushResult UDPServer::queueForClient(Client& client, std::string bytes) {
+    OutboundQueue::PushResult result = client.outbound.push(std::move(bytes));
+    if (result == OutboundQueue::PushResult::Dropped) {
+        uint64_t dropped = client.outbound.stats().dropped;
+        if (dropped % 100 == 1) {
+            std::cerr << "UDP client " << client.name << " is not keeping up, " << dropped
+                      << " message(s) dropped (" << OutboundQueue::policyString(outboundConfig.policy) << ")" << std::endl;
         }
+    }
+    if (!sendPending) {
+        sendPending = true;
+        sendCondition.notify_one();
+    }
+    return result;
+}
 
-        std::string ip = clientAddrStr.substr(0, colonPos);
-        int port = std::stoi(clientAddrStr.substr(colonPos + 1));
+void UDPServer::sendQueuedDatagrams() {
+    sendHeaders.resize(sendBatchSize);
+    sendVectors.resize(sendBatchSize);
+    std::vector<Client*> batch;
+    batch.reserve(sendBatchSize);
 
-        clientAddr.sin_family = AF_INET;
-        clientAddr.sin_port = htons(port);
-        if (inet_pton(AF_INET, ip.c_str(), &clientAddr.sin_addr) <= 0) {
-            std::cerr << "Invalid IP address: " << ip << std::endl;
-            continue;
+    std::unique_lock<std::mutex> lock(clientAddressesMutex);
+    while (true) {
+        sendCondition.wait(lock, [this] { return !running || sendPending; });
+        if (!running) {
+            return;
+        }
+        sendPending = false;
+
+        // One datagram per client per pass, so a client with a deep queue cannot starve the rest.
+        // A broadcast to up to sendBatchSize clients goes out in one sendmmsg.
+        bool blocked = false;
+        bool more = true;
+        while (more && !blocked) {
+            more = false;
+            for (auto& [key, client] : clientAddresses) {
+                if (client->outbound.empty()) {
+                    continue;
+                }
+                batch.push_back(client.get());
+                if (batch.size() == sendBatchSize && !sendBatch(batch, more)) {
+                    blocked = true;
+                    break;
+                }
+            }
+            if (!blocked && !batch.empty() && !sendBatch(batch, more)) {
+                blocked = true;
+            }
         }
 
-        ssize_t bytesSent = sendto(serverSocket, message.c_str(), message.size(), 0,
-                                   (struct sockaddr*)&clientAddr, sizeof(clientAddr));
-        if (bytesSent < 0) {
-            std::cerr << "Failed to send message to client. Error: " << strerror(errno) << std::endl;
+        if (blocked) {
+            // Socket send buffer full: wait for room without holding the client table
+            lock.unlock();
+            pollfd pollFd{serverSocket, POLLOUT, 0};
+            poll(&pollFd, 1, 100);
+            lock.lock();
+            sendPending = true;
         }
     }
+}
+
+// Sends the front datagram of each client in batch and empties it, setting more if any of those
+// clients still has datagrams queued. Returns false if the socket send buffer filled up first;
+// the datagrams not sent stay queued. Called with clientAddressesMutex held.
+bool UDPServer::sendBatch(std::vector<Client*>& batch, bool& more) {
+    for (size_t i = 0; i < batch.size(); ++i) {
+        std::string_view datagram = batch[i]->outbound.front();
+        sendVectors[i] = {const_cast<char*>(datagram.data()), datagram.size()};
+        sendHeaders[i] = {};
+        sendHeaders[i].msg_hdr.msg_name = &batch[i]->address;
+        sendHeaders[i].msg_hdr.msg_namelen = sizeof(batch[i]->address);
+        sendHeaders[i].msg_hdr.msg_iov = &sendVectors[i];
+        sendHeaders[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t done = 0;
+    while (done < batch.size()) {
+        int sent = sendmmsg(serverSocket, sendHeaders.data() + done, batch.size() - done, MSG_DONTWAIT);
+        sendCalls.fetch_add(1, std::memory_order_relaxed);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                batch.clear();
+                return false;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            // Give up on the datagram that failed and carry on with the rest
+            std::cerr << "Failed to send message to client " << batch[done]->name << ". Error: " << strerror(errno) << std::endl;
+            batch[done]->outbound.consume(sendVectors[done].iov_len);
+            ++done;
+            continue;
+        }
+        datagramsSent.fetch_add(sent, std::memory_order_relaxed);
+        for (size_t i = done; i < done + sent; ++i) {
+            batch[i]->outbound.consume(sendVectors[i].iov_len);
+        }
+        done += sent;
+    }
+    for (Client* client : batch) {
+        more = more || !client->outbound.empty();
+    }
+    batch.clear();
     return true;
 }
 
-void UDPServer::addClientAddress(const sockaddr_in& clientAddr) {
-    std::string addrStr = clientAddrToString(clientAddr);
+UDPServer::TransferStats UDPServer::getTransferStats() const {
+    return {receiveCalls.load(std::memory_order_relaxed), datagramsReceived.load(std::memory_order_relaxed),
+            sendCalls.load(std::memory_order_relaxed), datagramsSent.load(std::memory_order_relaxed)};
+}
+
+std::vector<ClientQueueStats> UDPServer::getClientQueueStats() {
     std::lock_guard<std::mutex> lock(clientAddressesMutex);
-    clientAddresses.insert(addrStr); // unordered_set ensures no duplicates
+    std::vector<ClientQueueStats> stats;
+    stats.reserve(clientAddresses.size());
+    for (auto& [key, client] : clientAddresses) {
+        stats.push_back({client->name, client->outbound.stats()});
+    }
+    return stats;
+}
+
+// Callers hold clientAddressesMutex.
+std::shared_ptr<UDPServer::Client> UDPServer::addClientAddress(const sockaddr_in& clientAddr,
+                                                               std::chrono::steady_clock::time_point now) {
+    auto [it, added] = clientAddresses.try_emplace(clientKey(clientAddr));
+    if (added) {
+        it->second = std::make_shared<Client>(clientAddr, clientAddrToString(clientAddr), outboundConfig);
+    }
+    it->second->lastSeen = now;
+    if (added) {
+        // A ground station that reconnects from a new port leaves its old entry behind
+        expireClients(now);
+    }
+    return it->second;
+}
+
+// Callers hold clientAddressesMutex.
+void UDPServer::expireClients(std::chrono::steady_clock::time_point now) {
+    if (clientLease.count() <= 0) {
+        return;
+    }
+    for (auto it = clientAddresses.begin(); it != clientAddresses.end();) {
+        if (now - it->second->lastSeen > clientLease) {
+            std::cerr << "UDP client " << it->second->name << " silent for over " << clientLease.count()
+                      << " s, dropping it." << std::endl;
+            it = clientAddresses.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// IPv4 address and port packed into 48 bits, in host order
+uint64_t UDPServer::clientKey(const sockaddr_in& clientAddr) {
+    return (static_cast<uint64_t>(ntohl(clientAddr.sin_addr.s_addr)) << 16) | ntohs(clientAddr.sin_port);
 }
 
 std::string UDPServer::clientAddrToString(const sockaddr_in& clientAddr) {
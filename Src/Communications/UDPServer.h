@@ -2,19 +2,23 @@
 #define UDPSERVER_H
 
 #include <string>
+#include <cstdint>
+#include <chrono>
 #include <netinet/in.h>
+#include <sys/socket.h>
 #include <thread>
 #include <atomic>
 #include <vector>
 #include <mutex>
-#include <queue>
 #include <memory>
 #include <condition_variable>
-#include <unordered_set>
+#include <unordered_map>
 #include <opencv2/core/mat.hpp>
 
-#include "../Modules/CommandManager.h"
 #include "ICommunication.h"
+#include "BinaryProtocol.h"
+#include "OutboundQueue.h"
+#include "../../Events/CommandTrace.h"
 
 class UDPServer : public ICommunication{
 public:
@@ -27,24 +31,77 @@ public:
 
     bool send_frame(const cv::Mat &frame);
 
+    std::vector<ClientQueueStats> getClientQueueStats();
+
+    // Socket-level counters; datagrams per call shows how well recvmmsg/sendmmsg are batching
+    struct TransferStats {
+        uint64_t receiveCalls;
+        uint64_t datagramsReceived;
+        uint64_t sendCalls;
+        uint64_t datagramsSent;
+    };
+    TransferStats getTransferStats() const;
+
 private:
     int serverSocket;
     int port;
     sockaddr_in serverAddr;
     std::atomic<bool> running;
+    std::thread receiverThread;
     std::thread commandProcessorThread;
 
-    std::queue<std::pair<std::string, sockaddr_in>> commandQueue;
+    struct Datagram {
+        std::string bytes;
+        sockaddr_in from;
+        CommandTrace trace;
+    };
+
+    // Filled a whole recvmmsg batch at a time and swapped out whole by processCommands()
+    std::vector<Datagram> commandQueue;
     std::mutex queueMutex;
     std::condition_variable queueCondition;
 
-    std::unordered_set<std::string> clientAddresses;
+    struct Client {
+        Client(const sockaddr_in& address, std::string name, const OutboundQueue::Config& outboundConfig)
+            : address(address), name(std::move(name)), outbound(outboundConfig) {}
+
+        sockaddr_in address;        // Ready to hand to sendmmsg
+        std::string name;           // "ip:port", for log lines and stats only
+        ProtocolSession session{ProtocolSession::Framing::Datagram};
+        OutboundQueue outbound;     // Guarded by clientAddressesMutex
+        std::chrono::steady_clock::time_point lastSeen;     // Guarded by clientAddressesMutex
+    };
+
+    // Keyed by clientKey(). A client is dropped when its lease runs out without a datagram from
+    // it, or under the disconnect policy, and is added again when it next sends; shared_ptr keeps
+    // a dropped one valid for a thread still using it.
+    std::unordered_map<uint64_t, std::shared_ptr<Client>> clientAddresses;
     std::mutex clientAddressesMutex;
+    std::chrono::seconds clientLease;   // Zero keeps clients forever
+
+    // Datagrams are written by the sender thread from the per-client queues, so send_message()
+    // never waits on the socket.
+    OutboundQueue::Config outboundConfig;
+    std::condition_variable sendCondition;
+    bool sendPending = false;   // Guarded by clientAddressesMutex
+    std::thread senderThread;
+    std::vector<mmsghdr> sendHeaders;   // Sender thread only, reused for every sendmmsg
+    std::vector<iovec> sendVectors;
+
+    std::atomic<uint64_t> receiveCalls{0};
+    std::atomic<uint64_t> datagramsReceived{0};
+    std::atomic<uint64_t> sendCalls{0};
+    std::atomic<uint64_t> datagramsSent{0};
 
     void setupServerAddress();
     void receiveMessages();
     void processCommands();
-    void addClientAddress(const sockaddr_in& clientAddr);
+    void sendQueuedDatagrams();
+    bool sendBatch(std::vector<Client*>& batch, bool& more);
+    OutboundQueue::PushResult queueForClient(Client& client, std::string bytes);
+    std::shared_ptr<Client> addClientAddress(const sockaddr_in& clientAddr, std::chrono::steady_clock::time_point now);
+    void expireClients(std::chrono::steady_clock::time_point now);
+    static uint64_t clientKey(const sockaddr_in& clientAddr);
     std::string clientAddrToString(const sockaddr_in& clientAddr);
 };
 
@@ -0,0 +1,340 @@
+#include "UnixSocketServer.h"
+#include <iostream>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+namespace {
+const size_t maxMessageSize = 64 * 1024;
+// Messages read per readiness event, so a chatty companion cannot starve the others
+const int readBudget = 16;
+const int maxEvents = 64;
+}
+
+UnixSocketServer::UnixSocketServer(std::string path)
+    : path(std::move(path)), serverSocket(-1), epollFd(-1), wakeFd(-1), running(false),
+      outboundConfig(OutboundQueue::loadConfig()) {
+}
+
+UnixSocketServer::~UnixSocketServer() {
+    stop();
+}
+
+bool UnixSocketServer::start() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Invalid Unix socket path '" << path << "'" << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    serverSocket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (serverSocket < 0) {
+        std::cerr << "Error creating socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // A socket file left by a previous run would make bind fail
+    unlink(path.c_str());
+    if (bind(serverSocket, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        std::cerr << "Error binding socket " << path << ": " << strerror(errno) << std::endl;
+        close(serverSocket);
+        return false;
+    }
+
+    if (listen(serverSocket, SOMAXCONN) < 0) {
+        std::cerr << "Error listening on socket: " << strerror(errno) << std::endl;
+        close(serverSocket);
+        unlink(path.c_str());
+        return false;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd < 0 || wakeFd < 0) {
+        std::cerr << "Error creating epoll instance: " << strerror(errno) << std::endl;
+        for (int fd : {epollFd, wakeFd, serverSocket}) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        unlink(path.c_str());
+        return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = serverSocket;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, serverSocket, &event);
+    event.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    running = true;
+    std::cout << "Unix socket server started on " << path << std::endl;
+
+    reactorThread = std::thread(&UnixSocketServer::runReactor, this);
+    commandProcessorThread = std::thread(&UnixSocketServer::processCommands, this);
+
+    return true;
+}
+
+void UnixSocketServer::stop() {
+    if (running) {
+        running = false;
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {
+            std::cerr << "Error waking Unix socket reactor: " << strerror(errno) << std::endl;
+        }
+        if (reactorThread.joinable()) {
+            reactorThread.join();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            for (auto& [clientSocket, connection] : connections) {
+                connection->closed = true;
+                close(clientSocket);
+            }
+            connections.clear();
+        }
+        close(serverSocket);
+        close(epollFd);
+        close(wakeFd);
+        unlink(path.c_str());
+        std::cout << "Unix socket server stopped." << std::endl;
+
+        queueCondition.notify_all();
+        if (commandProcessorThread.joinable()) {
+            commandProcessorThread.join();
+        }
+    }
+}
+
+void UnixSocketServer::runReactor() {
+    epoll_event events[maxEvents];
+    while (running) {
+        int ready = epoll_wait(epollFd, events, maxEvents, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error waiting for Unix socket events: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd) {
+                continue;
+            }
+            if (fd == serverSocket) {
+                acceptConnections();
+                continue;
+            }
+
+            std::shared_ptr<Connection> connection;
+            {
+                std::lock_guard<std::mutex> lock(connectionsMutex);
+                auto it = connections.find(fd);
+                if (it == connections.end()) {
+                    continue;
+                }
+                connection = it->second;
+                if (events[i].events & EPOLLOUT) {
+                    flushOutbound(*connection);
+                }
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && !readFromClient(connection)) {
+                closeConnection(connection);
+            }
+        }
+    }
+}
+
+void UnixSocketServer::acceptConnections() {
+    while (running) {
+        int clientSocket = accept4(serverSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (clientSocket < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "Error accepting connection: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+
+        auto connection = std::make_shared<Connection>(clientSocket, path + "#" + std::to_string(++connectionCount),
+                                                       outboundConfig);
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            connections[clientSocket] = connection;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = clientSocket;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, clientSocket, &event);
+        std::cout << "Local client " << connection->peer << " connected." << std::endl;
+    }
+}
+
+// Returns false when the connection should be closed.
+bool UnixSocketServer::readFromClient(const std::shared_ptr<Connection>& connection) {
+    char buffer[maxMessageSize];
+    std::vector<std::string> messages;
+    bool open = true;
+    for (int i = 0; i < readBudget; ++i) {
+        // MSG_TRUNC reports the full length of a message that did not fit, which is then dropped
+        ssize_t bytesReceived = recv(connection->socket, buffer, sizeof(buffer), MSG_TRUNC);
+        if (bytesReceived < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "Error receiving data: " << strerror(errno) << std::endl;
+                open = false;
+            }
+            break;
+        } else if (bytesReceived == 0) {
+            std::cout << "Local client " << connection->peer << " disconnected." << std::endl;
+            open = false;
+            break;
+        } else if (static_cast<size_t>(bytesReceived) > sizeof(buffer)) {
+            std::cerr << "Dropped a " << bytesReceived << " byte message from " << connection->peer << std::endl;
+            continue;
+        }
+        messages.emplace_back(buffer, bytesReceived);
+    }
+
+    if (!messages.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (auto& message : messages) {
+                commandQueue.emplace(connection, std::move(message));
+            }
+        }
+        queueCondition.notify_one();
+    }
+    return open;
+}
+
+void UnixSocketServer::closeConnection(const std::shared_ptr<Connection>& connection) {
+    // Closed under the lock so a sender never writes to a descriptor that was already reused
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    if (connection->closed) {
+        return;
+    }
+    connection->closed = true;
+    connections.erase(connection->socket);
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->socket, nullptr);
+    close(connection->socket);
+}
+
+void UnixSocketServer::processCommands() {
+    while (running) {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueCondition.wait(lock, [this] { return !commandQueue.empty() || !running; });
+
+        while (!commandQueue.empty()) {
+            auto [connection, message] = std::move(commandQueue.front());
+            commandQueue.pop();
+            lock.unlock();
+
+            std::string reply;
+            connection->session.receive(message, reply, "Unix");
+            if (!reply.empty()) {
+                std::lock_guard<std::mutex> connectionsLock(connectionsMutex);
+                sendToClient(*connection, std::move(reply));
+            }
+
+            lock.lock();
+        }
+    }
+}
+
+bool UnixSocketServer::send_message(const std::string& message) {
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    if (connections.empty()) {
+        std::cerr << "No local clients connected" << std::endl;
+        return false;
+    }
+
+    for (auto& [clientSocket, connection] : connections) {
+        sendToClient(*connection, connection->session.encodeOutbound(message));
+    }
+
+    return true;
+}
+
+// Callers hold connectionsMutex. Queues the message and sends what the socket takes now; the rest
+// is sent by the reactor on EPOLLOUT.
+bool UnixSocketServer::sendToClient(Connection& connection, std::string bytes) {
+    if (connection.closed || connection.disconnecting) {
+        return false;
+    }
+
+    switch (connection.outbound.push(std::move(bytes))) {
+        case OutboundQueue::PushResult::Queued:
+            break;
+        case OutboundQueue::PushResult::Dropped: {
+            uint64_t dropped = connection.outbound.stats().dropped;
+            if (dropped % 100 == 1) {
+                std::cerr << "Local client " << connection.peer << " is not keeping up, " << dropped
+                          << " message(s) dropped (" << OutboundQueue::policyString(outboundConfig.policy) << ")" << std::endl;
+            }
+            break;
+        }
+        case OutboundQueue::PushResult::Overflow:
+            std::cerr << "Local client " << connection.peer << " is not keeping up, disconnecting." << std::endl;
+            connection.disconnecting = true;
+            shutdown(connection.socket, SHUT_RDWR);
+            return false;
+    }
+
+    if (!connection.writeArmed) {
+        flushOutbound(connection);
+    }
+    return true;
+}
+
+// Callers hold connectionsMutex. A seqpacket send takes the whole message or nothing.
+void UnixSocketServer::flushOutbound(Connection& connection) {
+    while (!connection.outbound.empty()) {
+        std::string_view bytes = connection.outbound.front();
+        ssize_t bytesSent = send(connection.socket, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+        if (bytesSent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // The reactor sees the same error on its next read and closes the connection
+                std::cerr << "Failed to send message to local client. Error: " << strerror(errno) << std::endl;
+                return;
+            }
+            break;
+        }
+        connection.outbound.consume(bytes.size());
+    }
+    setWriteInterest(connection, !connection.outbound.empty());
+}
+
+std::vector<ClientQueueStats> UnixSocketServer::getClientQueueStats() {
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    std::vector<ClientQueueStats> stats;
+    stats.reserve(connections.size());
+    for (auto& [clientSocket, connection] : connections) {
+        stats.push_back({connection->peer, connection->outbound.stats()});
+    }
+    return stats;
+}
+
+void UnixSocketServer::setWriteInterest(Connection& connection, bool enabled) {
+    if (connection.writeArmed == enabled) {
+        return;
+    }
+    epoll_event event{};
+    event.events = enabled ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.fd = connection.socket;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.socket, &event);
+    connection.writeArmed = enabled;
+}
@@ -0,0 +1,75 @@
+#ifndef UNIXSOCKETSERVER_H
+#define UNIXSOCKETSERVER_H
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <queue>
+#include <memory>
+#include <condition_variable>
+#include <unordered_map>
+
+#include "ICommunication.h"
+#include "BinaryProtocol.h"
+#include "OutboundQueue.h"
+
+// Companion processes on the same board (CV pipeline, logger) over a SOCK_SEQPACKET Unix socket
+// at a filesystem path. Like TCPServer, one epoll reactor thread owns every socket and a command
+// processor thread publishes the commands, but the socket keeps message boundaries, so each recv is
+// one whole message and nothing needs framing. Skips the IP stack that UDP on localhost pays for.
+class UnixSocketServer : public ICommunication {
+public:
+    explicit UnixSocketServer(std::string path);
+    ~UnixSocketServer();
+
+    bool start() override;
+    void stop() override;
+    bool send_message(const std::string& message) override;
+
+    std::vector<ClientQueueStats> getClientQueueStats();
+
+private:
+    struct Connection {
+        Connection(int socket, std::string peer, const OutboundQueue::Config& outboundConfig)
+            : socket(socket), peer(std::move(peer)), outbound(outboundConfig) {}
+
+        int socket;
+        std::string peer;
+        ProtocolSession session{ProtocolSession::Framing::Datagram};
+
+        // Guarded by connectionsMutex
+        OutboundQueue outbound;
+        bool writeArmed = false;    // EPOLLOUT registered
+        bool closed = false;
+        bool disconnecting = false; // Overflowed under the disconnect policy; the reactor closes it
+    };
+
+    std::string path;
+    int serverSocket;
+    int epollFd;
+    int wakeFd;
+    std::unordered_map<int, std::shared_ptr<Connection>> connections;
+    std::atomic<bool> running;
+    std::thread reactorThread;
+    std::mutex connectionsMutex;
+    OutboundQueue::Config outboundConfig;
+    uint64_t connectionCount = 0;   // Reactor thread only; names peers, which have no address
+
+    std::queue<std::pair<std::shared_ptr<Connection>, std::string>> commandQueue;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::thread commandProcessorThread;
+
+    void runReactor();
+    void acceptConnections();
+    bool readFromClient(const std::shared_ptr<Connection>& connection);
+    void flushOutbound(Connection& connection);
+    void closeConnection(const std::shared_ptr<Connection>& connection);
+    void processCommands();
+    bool sendToClient(Connection& connection, std::string bytes);
+    void setWriteInterest(Connection& connection, bool enabled);
+};
+
+#endif // UNIXSOCKETSERVER_H
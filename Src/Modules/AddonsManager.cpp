@@ -7,7 +7,7 @@ AddonsManager::AddonsManager() : running(false) {
 }
 
 AddonsManager::~AddonsManager() {
-    // Stop the background thread and clean up
+    // Stop the device scan and clean up
     stop();
     addon_ptrs.clear();
     libusb_exit(nullptr);
@@ -15,22 +15,30 @@ AddonsManager::~AddonsManager() {
 }
 
 void AddonsManager::start() {
+    if (running) {
+        return;
+    }
     running = true;
-    monitoring_thread = std::thread(&AddonsManager::monitor_addons, this);  // Start the background monitoring thread
+    scan_executor = std::make_unique<ThreadExecutor>();
+    // Check for new devices now and then every second; a scan still running skips the next one
+    monitor_timer = GetEventManager().timers().scheduleEvery(std::chrono::seconds(1), std::chrono::steady_clock::now(),
+                                                            [this]() {
+        if (!scan_queued.exchange(true)) {
+            scan_executor->post([this]() {
+                detect_usb_devices();
+                scan_queued = false;
+            });
+        }
+    });
 }
 
 void AddonsManager::stop() {
     running = false;
-    if (monitoring_thread.joinable()) {
-        monitoring_thread.join();
-    }
-}
-
-void AddonsManager::monitor_addons() {
-    while (running) {
-        detect_usb_devices();
-        std::this_thread::sleep_for(std::chrono::seconds(1));  // Check for new devices every second
+    if (monitor_timer) {
+        GetEventManager().timers().cancel(monitor_timer);
+        monitor_timer = 0;
     }
+    scan_executor.reset();  // Finishes a scan that is queued or running
 }
 
 void AddonsManager::detect_usb_devices() {
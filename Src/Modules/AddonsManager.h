@@ -3,10 +3,11 @@
 
 #include <memory>
 #include <vector>
-#include <thread>
 #include <atomic>
 #include <libusb.h>
 #include "../Addons/BaseAddon.h"
+#include "../../Events/EventManager.h"
+#include "../../Events/Executor.h"
 
 class AddonsManager {
 public:
@@ -24,11 +25,14 @@ public:
     void deactivate(int index);
 
 private:
-    void monitor_addons();
     void detect_usb_devices();
 
     bool running;
-    std::thread monitoring_thread;
+    TimerWheel::TimerId monitor_timer = 0;
+    // The timer only posts the scan here: enumeration, libusb_open and reading the command JSON
+    // block, and must not hold up the shared timer thread
+    std::unique_ptr<ThreadExecutor> scan_executor;
+    std::atomic<bool> scan_queued{false};
     std::vector<std::shared_ptr<BaseAddon>> addon_ptrs;
 };
 
@@ -1,8 +1,8 @@
 #include "CommandManager.h"
-#include "../../Events/EventManager.h"
+#include "../../Events/EventChannels.h"
+#include "../../Events/CommandTrace.h"
 #include <iostream>
 #include <chrono>
-#include <thread>
 #include <mavsdk/mavlink/common/mavlink.h>
 
 
@@ -30,20 +30,20 @@ CommandManager::~CommandManager() {
 bool CommandManager::IsViable() { return viable; }
 
 void CommandManager::initialize_command_handlers() {
-    command_map = {
-            {"takeoff", [this](const std::vector<float>&) { return takeoff(); }},
-            {"land", [this](const std::vector<float>&) { return land(); }},
-            {"return_to_launch", [this](const std::vector<float>&) { return return_to_launch(); }},
-            {"hold", [this](const std::vector<float>&) { return hold(); }},
-            {"stop_manual_control", [this](const std::vector<float>&) { return stop_manual_control(); }},
-            {"set_flight_mode", [this](const std::vector<float>& params) {
+    const std::pair<CommandId, CommandHandler> handlers[] = {
+            {CommandId::Takeoff, [this](const std::vector<double>&) { return takeoff(); }},
+            {CommandId::Land, [this](const std::vector<double>&) { return land(); }},
+            {CommandId::ReturnToLaunch, [this](const std::vector<double>&) { return return_to_launch(); }},
+            {CommandId::Hold, [this](const std::vector<double>&) { return hold(); }},
+            {CommandId::StopManualControl, [this](const std::vector<double>&) { return stop_manual_control(); }},
+            {CommandId::SetFlightMode, [this](const std::vector<double>& params) {
                 if (params.size() == 2) {
                     return set_flight_mode(static_cast<uint8_t>(params[0]), static_cast<uint32_t>(params[1]));
                 }
                 return Result::Failure;
             }},
-            {"start_manual_control", [this](const std::vector<float>&) { return start_manual_control(); }},
-            {"set_manual_control", [this](const std::vector<float>& params) {
+            {CommandId::StartManualControl, [this](const std::vector<double>&) { return start_manual_control(); }},
+            {CommandId::SetManualControl, [this](const std::vector<double>& params) {
                 if (params.size() == 4) {
                     std::vector<uint16_t> args = {
                         static_cast<uint16_t>(params[0]),
@@ -55,32 +55,41 @@ void CommandManager::initialize_command_handlers() {
                 }
                 return Result::Failure;
             }},
-            {"arm", [this](const std::vector<float>&) { return arm(); }},
-            {"disarm", [this](const std::vector<float>&) { return disarm(); }},
-             {"tap_to_fly", [this](const std::vector<float>&) { return tap_to_fly(); }},
-             {"fly_to", [this](const std::vector<float>& params) { return fly_to(params[0],params[1],params[2]); }}
+            {CommandId::Arm, [this](const std::vector<double>&) { return arm(); }},
+            {CommandId::Disarm, [this](const std::vector<double>&) { return disarm(); }},
+             {CommandId::TapToFly, [this](const std::vector<double>&) { return tap_to_fly(); }},
+             {CommandId::FlyTo, [this](const std::vector<double>& params) {
+                 if (params.size() == 3) {
+                     return fly_to(params[0], params[1], static_cast<float>(params[2]));
+                 }
+                 return Result::Failure;
+             }}
             };
+    for (const auto& [id, handler] : handlers) {
+        command_handlers[static_cast<size_t>(id)] = handler;
+    }
 }
 
-bool CommandManager::is_command_valid(const std::string& command) const {
-    return command_map.find(command) != command_map.end();
+bool CommandManager::is_command_valid(CommandId command) const {
+    auto index = static_cast<size_t>(command);
+    return index < command_handlers.size() && command_handlers[index];
 }
 
 CommandManager::Result CommandManager::takeoff() {
-    INVOKE_EVENT("send_ack",std::string("takeoff"));
+    GetEventChannel<SendAckEvent>().invoke("takeoff");
     action->set_takeoff_altitude(20);
     return execute_action([this]() { return action->takeoff(); }, "Takeoff");
 }
 
 CommandManager::Result CommandManager::land() {
 
-    INVOKE_EVENT("send_ack",std::string("land"));
+    GetEventChannel<SendAckEvent>().invoke("land");
     return execute_action([this]() { return action->land(); }, "Landing");
 }
 
 CommandManager::Result CommandManager::return_to_launch() {
 
-    INVOKE_EVENT("send_ack",std::string("RTL"));
+    GetEventChannel<SendAckEvent>().invoke("RTL");
     return execute_action([this]() { return action->return_to_launch(); }, "Return to launch");
 }
 
@@ -89,35 +98,29 @@ CommandManager::Result CommandManager::hold() {
 }
 
 CommandManager::Result CommandManager::set_flight_mode(uint8_t base_mode, uint32_t custom_mode) {
-    INVOKE_EVENT("send_ack",std::string("FLight Mode"));
+    GetEventChannel<SendAckEvent>().invoke("FLight Mode");
 
     return send_mavlink_command(base_mode, custom_mode);
 }
 
 CommandManager::Result CommandManager::disarm() {
-    INVOKE_EVENT("send_ack",std::string("Disarm"));
+    GetEventChannel<SendAckEvent>().invoke("Disarm");
     return execute_action([this]() { return action->disarm(); }, "Disarm");
 }
 
-CommandManager::Result CommandManager::manual_control_loop() {
-    if (!viable) {
-        std::cerr << "System not viable for manual control loop" << std::endl;
-        return Result::ConnectionError;
+void CommandManager::send_manual_control() {
+    std::vector<uint16_t> channels;
+    {
+        std::lock_guard<std::mutex> lock(manual_control_mutex);
+        channels = manual_channels;
     }
 
-    const std::chrono::milliseconds interval(100);  // 0.1 seconds interval
-
-    while (manual_continue_loop) {
-        Result result = send_rc_override(manual_channels);
-        if (result != Result::Success) {
-            std::cerr << "Failed to send RC override in manual control loop" << std::endl;
-            return result;
-        }
-        std::this_thread::sleep_for(interval);
+    Result result = send_rc_override(channels);
+    if (result != Result::Success) {
+        std::cerr << "Failed to send RC override in manual control loop" << std::endl;
+        // Running on the timer thread, so this does not wait for itself
+        GetEventManager().timers().cancel(manual_control_timer);
     }
-
-    return Result::Success;
-
 }
 
 CommandManager::Result CommandManager::start_manual_control() {
@@ -126,32 +129,39 @@ CommandManager::Result CommandManager::start_manual_control() {
         return Result::ConnectionError;
     }
 
-    if (manual_control_thread.joinable()) {
+    if (manual_control_timer) {
         stop_manual_control();
     }
 
-    auto result = action->arm();
+    mavsdk::Action::Result result;
+    {
+        CommandTrace::MavsdkCall call;
+        result = action->arm();
+    }
     if(result != mavsdk::Action::Result::Success) {
         std::cerr << "failed arm" << std::endl;
         return Result::Failure;
     }
 
-    manual_continue_loop = true;
     set_flight_mode(1,5);
 
-        manual_control_thread = std::thread([this]() {
-            manual_control_loop();
-        });
+    // RC overrides go out every 100 ms on absolute deadlines, so a slow send does not stretch the period
+    manual_control_timer = GetEventManager().timers().scheduleEvery(std::chrono::milliseconds(100),
+                                                                   std::chrono::steady_clock::now(),
+                                                                   [this]() { send_manual_control(); });
     return Result::Success;
 }
 
 CommandManager::Result CommandManager::stop_manual_control() {
-    manual_continue_loop = false;
-
-    if (manual_control_thread.joinable()) {
-        manual_control_thread.join();
+    if (manual_control_timer) {
+        GetEventManager().timers().cancel(manual_control_timer);
+        manual_control_timer = 0;
+    }
+    mavsdk::Action::Result result;
+    {
+        CommandTrace::MavsdkCall call;
+        result = action->return_to_launch();
     }
-    auto result = action->return_to_launch();
     if (result != mavsdk::Action::Result::Success) {
         std::cerr << "Return to launch failed: " << result << std::endl;
         return Result::CommandFailed;
@@ -173,26 +183,26 @@ CommandManager::Result CommandManager::update_manual_control(const std::vector<u
 }
 
 CommandManager::Result CommandManager::arm() {
-    INVOKE_EVENT("send_ack",std::string ("Arm"));
+    GetEventChannel<SendAckEvent>().invoke("Arm");
     return execute_action([this]() { return action->arm(); }, "Arm");
 }
 
-CommandManager::Result CommandManager::handle_command(const std::string& command, const std::vector<float>& parameters) {
-    auto it = command_map.find(command);
-    if (it != command_map.end()) {
+CommandManager::Result CommandManager::handle_command(CommandId command, const std::vector<double>& parameters) {
+    if (is_command_valid(command)) {
         if (viable) {
-            return it->second(parameters);
+            return command_handlers[static_cast<size_t>(command)](parameters);
         } else {
-            std::cerr << "System not viable for command: " << command << std::endl;
+            std::cerr << "System not viable for command: " << commandName(command) << std::endl;
             return Result::Failure;
         }
     } else {
-        std::cerr << "Unknown command: " << command << std::endl;
+        std::cerr << "Unknown command: " << commandName(command) << std::endl;
         return Result::Unknown;
     }
 }
 
 CommandManager::Result CommandManager::send_mavlink_command(uint8_t base_mode, uint32_t custom_mode) {
+    CommandTrace::MavsdkCall call;
     auto result = mavlink_passthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
         mavlink_message_t message;
         mavlink_msg_set_mode_pack_chan(
@@ -220,7 +230,11 @@ CommandManager::Result CommandManager::execute_action(std::function<mavsdk::Acti
         return Result::ConnectionError;
     }
 
-    auto result = action_func();
+    mavsdk::Action::Result result;
+    {
+        CommandTrace::MavsdkCall call;
+        result = action_func();
+    }
     if (result != mavsdk::Action::Result::Success) {
         std::cerr << action_name << " failed: " << result << std::endl;
         return Result::CommandFailed;
@@ -231,6 +245,7 @@ CommandManager::Result CommandManager::execute_action(std::function<mavsdk::Acti
 }
 
 CommandManager::Result CommandManager::send_rc_override(const std::vector<uint16_t>& channels) {
+    CommandTrace::MavsdkCall call;
     auto result = mavlink_passthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
         mavlink_message_t message;
 
@@ -285,15 +300,19 @@ CommandManager::Result CommandManager::send_rc_override(const std::vector<uint16
 
 CommandManager::Result CommandManager::tap_to_fly() {
 
-    INVOKE_EVENT("send_ack",std::string ("tap_to_fly"));
+    GetEventChannel<SendAckEvent>().invoke("tap_to_fly");
 
     return set_flight_mode(1,4);
 }
 
-CommandManager::Result CommandManager::fly_to(float lat, float lon, float alt) {
-    INVOKE_EVENT("send_ack",std::string ("fly_to"));
+CommandManager::Result CommandManager::fly_to(double lat, double lon, float alt) {
+    GetEventChannel<SendAckEvent>().invoke("fly_to");
 
-    mavsdk::Action::Result actionResult= action->goto_location((double)lat,(double)lon,alt,0);
+    mavsdk::Action::Result actionResult;
+    {
+        CommandTrace::MavsdkCall call;
+        actionResult = action->goto_location(lat,lon,alt,0);
+    }
 
     if(actionResult == mavsdk::Action::Result::Success)
       return CommandManager::Result::Success;
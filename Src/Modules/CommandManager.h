@@ -11,9 +11,10 @@
 #include <vector>
 #include <string>
 #include <functional>
-#include <map>
+#include <array>
 #include <mutex>
-#include <thread>
+#include "../../Events/EventManager.h"
+#include "../../Events/CommandIds.h"
 
 class CommandManager {
 public:
@@ -38,18 +39,17 @@ public:
     Result set_flight_mode(uint8_t base_mode, uint32_t custom_mode);
     Result arm();
     Result disarm();
-    Result manual_control_loop();
     Result start_manual_control();
     Result stop_manual_control();
     Result update_manual_control(const std::vector<uint16_t>& channels);
     Result tap_to_fly();
-    CommandManager::Result fly_to(float lat, float lon, float alt);
+    CommandManager::Result fly_to(double lat, double lon, float alt);
 
     Result send_rc_override(const std::vector<uint16_t>& channels);
 
-    Result handle_command(const std::string& command, const std::vector<float>& parameters);
+    Result handle_command(CommandId command, const std::vector<double>& parameters);
     bool IsViable();
-    bool is_command_valid(const std::string& command) const;
+    bool is_command_valid(CommandId command) const;
 
 private:
     std::shared_ptr<mavsdk::Action> action;
@@ -57,19 +57,19 @@ private:
     std::shared_ptr<mavsdk::MavlinkPassthrough> mavlink_passthrough;
     std::shared_ptr<mavsdk::System> system;
 
-    std::atomic<bool> manual_continue_loop;
-    std::thread manual_control_thread;
+    std::atomic<TimerWheel::TimerId> manual_control_timer{0};
     std::mutex manual_control_mutex;
     std::vector<uint16_t> manual_channels = {1500, 1500, 1500, 1500}; // Replace with actual channel values
 
     bool viable;
 
     Result send_mavlink_command(uint8_t base_mode, uint32_t custom_mode);
+    void send_manual_control();
     // Helper types for command handlers
-    using CommandHandler = std::function<Result(const std::vector<float>&)>;
+    using CommandHandler = std::function<Result(const std::vector<double>&)>;
 
-    // Command handler map
-    std::map<std::string, CommandHandler> command_map;
+    // Handlers indexed by CommandId; empty for commands this manager does not execute
+    std::array<CommandHandler, CommandCount> command_handlers;
 
     // Initialize command handlers
     void initialize_command_handlers();
@@ -0,0 +1,184 @@
+#include "CommandScheduler.h"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include "../../inih/cpp/INIReader.h"
+
+namespace {
+std::bitset<CommandCount> parseCommandList(const std::string& list) {
+    std::bitset<CommandCount> commands;
+    std::istringstream stream(list);
+    std::string command;
+    while (std::getline(stream, command, ',')) {
+        command.erase(0, command.find_first_not_of(" \t"));
+        command.erase(command.find_last_not_of(" \t") + 1);
+        if (command.empty()) {
+            continue;
+        }
+        CommandId id = commandIdFromName(command);
+        if (id == CommandId::Unknown) {
+            std::cerr << "Ignoring unknown command '" << command << "' in [Scheduler]" << std::endl;
+            continue;
+        }
+        commands.set(static_cast<size_t>(id));
+    }
+    return commands;
+}
+}
+
+CommandScheduler::CommandScheduler(CommandHandler handler) : handler(std::move(handler)) {
+    loadConfig();
+}
+
+CommandScheduler::~CommandScheduler() {
+    stop();
+}
+
+void CommandScheduler::loadConfig() {
+    INIReader reader("../config.ini");
+    if (reader.ParseError() < 0) {
+        std::cout << "Can't load 'config.ini', using default scheduler lanes\n";
+    }
+
+    expressCommands = parseCommandList(
+            reader.GetString("Scheduler", "ExpressCommands", "disarm,land,return_to_launch,hold"));
+    coalescedCommands = parseCommandList(
+            reader.GetString("Scheduler", "CoalescedCommands", "set_manual_control"));
+    express.latencyBudget = std::chrono::milliseconds(reader.GetInteger("Scheduler", "ExpressLatencyBudgetMs", 20));
+    bulk.latencyBudget = std::chrono::milliseconds(reader.GetInteger("Scheduler", "BulkLatencyBudgetMs", 1000));
+}
+
+void CommandScheduler::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return;
+    }
+    running = true;
+    express.worker = std::thread(&CommandScheduler::runExpress, this);
+    bulk.worker = std::thread(&CommandScheduler::runBulk, this);
+}
+
+void CommandScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    condition.notify_all();
+    if (express.worker.joinable()) {
+        express.worker.join();
+    }
+    if (bulk.worker.joinable()) {
+        bulk.worker.join();
+    }
+}
+
+CommandScheduler::Lane CommandScheduler::classify(CommandId command) const {
+    return expressCommands.test(static_cast<size_t>(command)) ? Lane::Express : Lane::Bulk;
+}
+
+void CommandScheduler::submit(CommandId command, const std::vector<double>& parameters, uint32_t client) {
+    auto now = std::chrono::steady_clock::now();
+    CommandTrace trace;
+    if (CommandTrace::current()) {
+        trace = *CommandTrace::current();
+        trace.submittedAt = now;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (classify(command) == Lane::Express) {
+            express.queue.push_back({command, parameters, client, now, trace});
+            express.stats.queued.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            // A newer value from the same client replaces one that is still waiting, keeping its
+            // place in the queue.
+            if (coalescedCommands.test(static_cast<size_t>(command))) {
+                auto it = std::find_if(bulk.queue.begin(), bulk.queue.end(),
+                                       [command, client](const PendingCommand& pending) {
+                                           return pending.command == command && pending.client == client;
+                                       });
+                if (it != bulk.queue.end()) {
+                    it->parameters = parameters;
+                    it->trace = trace;
+                    bulk.stats.coalesced.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            bulk.queue.push_back({command, parameters, client, now, trace});
+            bulk.stats.queued.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    condition.notify_all();
+}
+
+void CommandScheduler::runExpress() {
+    while (true) {
+        PendingCommand pending;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return !running || !express.queue.empty(); });
+            if (!running) {
+                return;
+            }
+            pending = std::move(express.queue.front());
+            express.queue.pop_front();
+            expressRunning = true;
+        }
+
+        execute(express, "express", pending);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            expressRunning = false;
+        }
+        condition.notify_all();
+    }
+}
+
+void CommandScheduler::runBulk() {
+    while (true) {
+        PendingCommand pending;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] {
+                return !running || (!bulk.queue.empty() && express.queue.empty() && !expressRunning);
+            });
+            if (!running) {
+                return;
+            }
+            pending = std::move(bulk.queue.front());
+            bulk.queue.pop_front();
+        }
+
+        execute(bulk, "bulk", pending);
+    }
+}
+
+void CommandScheduler::execute(LaneState& lane, const char* laneName, PendingCommand& pending) {
+    lane.stats.recordDispatch(pending.queuedAt);
+    auto waited = std::chrono::steady_clock::now() - pending.queuedAt;
+    if (waited > lane.latencyBudget) {
+        lane.budgetMisses.fetch_add(1, std::memory_order_relaxed);
+        std::cerr << "Command " << commandName(pending.command) << " waited "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(waited).count()
+                  << " ms in the " << laneName << " lane (budget " << lane.latencyBudget.count() << " ms)" << std::endl;
+    }
+
+    pending.trace.startedAt = std::chrono::steady_clock::now();
+    {
+        CommandTrace::Scope scope(&pending.trace);
+        handler(pending.command, pending.parameters);
+    }
+    GetCommandLatency().record(pending.trace);
+}
+
+CommandScheduler::LaneStats CommandScheduler::getLaneStats(Lane lane) const {
+    const LaneState& state = lane == Lane::Express ? express : bulk;
+    return LaneStats{
+        state.stats.snapshot(),
+        state.budgetMisses.load(std::memory_order_relaxed),
+        static_cast<int>(state.latencyBudget.count())
+    };
+}
@@ -0,0 +1,87 @@
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <bitset>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include "../../Events/EventManager.h"
+#include "../../Events/CommandIds.h"
+#include "../../Events/CommandTrace.h"
+
+// Priority-aware ingress for ground station commands. Safety-critical commands (disarm, land,
+// RTL, hold by default) go on an express lane with its own worker, so they never wait behind a
+// blocking MAVSDK call or a burst of bulk traffic. The bulk lane does not start new work while
+// express commands are pending or running. Both lanes are configured in the [Scheduler]
+// section of config.ini.
+class CommandScheduler {
+public:
+    using CommandHandler = std::function<void(CommandId, const std::vector<double>&)>;
+
+    enum class Lane {
+        Express,
+        Bulk
+    };
+
+    struct LaneStats {
+        EventDispatchStats::Snapshot dispatch;
+        uint64_t budgetMisses;
+        int latencyBudgetMs;
+    };
+
+    explicit CommandScheduler(CommandHandler handler);
+    ~CommandScheduler();
+
+    void start();
+    void stop();
+
+    // Never blocks on command execution; safe to call from receive threads and event callbacks.
+    // Takes over the calling thread's current CommandTrace, if any.
+    // client is the command_received sender; coalesced commands only replace ones from the same client.
+    void submit(CommandId command, const std::vector<double>& parameters, uint32_t client = 0);
+
+    Lane classify(CommandId command) const;
+    LaneStats getLaneStats(Lane lane) const;
+
+private:
+    struct PendingCommand {
+        CommandId command = CommandId::Unknown;
+        std::vector<double> parameters;
+        uint32_t client = 0;
+        std::chrono::steady_clock::time_point queuedAt;
+        CommandTrace trace;
+    };
+
+    struct LaneState {
+        std::deque<PendingCommand> queue;
+        EventDispatchStats stats;
+        std::atomic<uint64_t> budgetMisses{0};
+        std::chrono::milliseconds latencyBudget{0};
+        std::thread worker;
+    };
+
+    CommandHandler handler;
+    std::bitset<CommandCount> expressCommands;
+    std::bitset<CommandCount> coalescedCommands;
+
+    LaneState express;
+    LaneState bulk;
+    bool expressRunning = false;
+
+    mutable std::mutex mutex;
+    std::condition_variable condition;
+    bool running = false;
+
+    void loadConfig();
+    void runExpress();
+    void runBulk();
+    void execute(LaneState& lane, const char* laneName, PendingCommand& pending);
+};
+
+#endif // COMMANDSCHEDULER_H
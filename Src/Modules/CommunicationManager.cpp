@@ -1,100 +1,565 @@
 #include "CommunicationManager.h"
+#include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <cstdlib>
 #include "TelemetryManager.h"
 #include "../Communications/UDPServer.h"
 #include "../Communications/SerialCommunication.h"
 #include "../Communications/TCPServer.h"
+#include "../Communications/UnixSocketServer.h"
+#include "../Communications/SharedMemoryTransport.h"
+#include "../../Events/EventChannels.h"
+#ifdef HAVE_IO_URING
+#include "../Communications/IoUring.h"
+#include "../Communications/IoUringTCPServer.h"
+#include "../Communications/IoUringUDPServer.h"
+#endif
+
+namespace {
+// TCP or UDP server on the backend [Connection] IoBackend names. io_uring falls back to the epoll
+// servers when the build or the running kernel lacks it.
+std::shared_ptr<ICommunication> make_network_server(CommunicationType communication_type, int port, const INIReader& reader) {
+    std::string backend = reader.GetString("Connection", "IoBackend", "epoll");
+    if (backend == "io_uring") {
+#ifdef HAVE_IO_URING
+        if (IoUring::supported()) {
+            if (communication_type == ECT_TCP) {
+                return std::make_shared<IoUringTCPServer>(port);
+            }
+            return std::make_shared<IoUringUDPServer>(port);
+        }
+        std::cerr << "Falling back to epoll" << std::endl;
+#else
+        std::cerr << "Built without io_uring, falling back to epoll" << std::endl;
+#endif
+    } else if (backend != "epoll") {
+        std::cerr << "Unknown IoBackend '" << backend << "', using epoll" << std::endl;
+    }
+
+    if (communication_type == ECT_TCP) {
+        return std::make_shared<TCPServer>(port);
+    }
+    return std::make_shared<UDPServer>(port);
+}
+
+// path names the socket file of a Unix link or the shared memory object of a shm link
+std::shared_ptr<ICommunication> make_transport(CommunicationType communication_type, int port, const INIReader& reader,
+                                               const std::string& path = "") {
+    switch (communication_type) {
+        case ECT_TCP:
+        case ECT_UDP:
+            return make_network_server(communication_type, port, reader);
+        case ECT_SERIAL:
+            return std::make_shared<SerialCommunication>(
+                reader.GetString("Connection", "GroundStationSerialPort", "UNKNOWN"),
+                reader.GetInteger("Connection", "GroundStationBaudRate", 0),
+                reader.GetInteger("Connection", "GroundStationSendQueue", 64));
+        case ECT_UNIX:
+        case ECT_SHARED_MEMORY:
+            if (path.empty()) {
+                throw std::invalid_argument("Local links need a path or name");
+            }
+            if (communication_type == ECT_UNIX) {
+                return std::make_shared<UnixSocketServer>(path);
+            }
+            return std::make_shared<SharedMemoryTransport>(path, reader.GetInteger("Links", "ShmRingBytes", 262144));
+        default:
+            throw std::invalid_argument("Unsupported communication type");
+    }
+}
+
+// Bytes per second a link is shaped to when its Transports entry names no rate. 8N1 serial moves a
+// byte per ten baud, less 5% for SLIP framing; network links are not shaped.
+double default_rate(CommunicationType communication_type, const INIReader& reader) {
+    if (communication_type == ECT_SERIAL) {
+        return reader.GetInteger("Connection", "GroundStationBaudRate", 0) / 10.0 * 0.95;
+    }
+    return 0;
+}
+
+std::string link_name(CommunicationType communication_type, int port, const std::string& path = "") {
+    switch (communication_type) {
+        case ECT_TCP:
+            return "tcp:" + std::to_string(port);
+        case ECT_UDP:
+            return "udp:" + std::to_string(port);
+        case ECT_UNIX:
+            return "unix:" + path;
+        case ECT_SHARED_MEMORY:
+            return "shm:" + path;
+        default:
+            return "serial";
+    }
+}
+}
+
+CommunicationManager::CommunicationManager() : CommunicationManager(INIReader("../config.ini")) {
+}
+
+CommunicationManager::CommunicationManager(const INIReader& reader) {
+    if (reader.ParseError() < 0) {
+        std::cout << "Can't load 'config.ini'\n";
+    }
+    loadConfig(reader);
+
+    std::istringstream stream(reader.GetString("Links", "Transports", "udp:8080"));
+    std::string entry;
+    while (std::getline(stream, entry, ',')) {
+        entry.erase(0, entry.find_first_not_of(" \t"));
+        entry.erase(entry.find_last_not_of(" \t") + 1);
+        if (entry.empty()) {
+            continue;
+        }
+        double rate = -1;
+        std::string target = entry;
+        if (entry.find('@') != std::string::npos) {
+            rate = std::atof(entry.c_str() + entry.find('@') + 1);
+            target = entry.substr(0, entry.find('@'));
+        }
+        std::string type = target.substr(0, target.find(':'));
+        std::string address = target.find(':') == std::string::npos ? "" : target.substr(target.find(':') + 1);
+        int port = std::atoi(address.c_str());
+        if (type == "serial") {
+            add_communication(reader, ECT_SERIAL, 0, rate);
+        } else if ((type == "udp" || type == "tcp") && port > 0) {
+            add_communication(reader, type == "udp" ? ECT_UDP : ECT_TCP, port, rate);
+        } else if ((type == "unix" || type == "shm") && !address.empty()) {
+            add_communication(reader, type == "unix" ? ECT_UNIX : ECT_SHARED_MEMORY, 0, rate, address);
+        } else {
+            std::cerr << "Ignoring unknown link '" << entry << "' in [Links]" << std::endl;
+        }
+    }
+}
 
 CommunicationManager::CommunicationManager(CommunicationType communication_type, int port) {
     INIReader reader("../config.ini");
     if (reader.ParseError() < 0) {
         std::cout << "Can't load 'config.ini'\n";
     }
+    loadConfig(reader);
 
     // Add communication type to the vector during construction
-    add_communication(communication_type, port);
+    add_communication(reader, communication_type, port);
 }
 
 CommunicationManager::~CommunicationManager() {
-    for (auto& communication : communication_ptrs) {
-        communication->stop();
+    stop();
+}
+
+void CommunicationManager::loadConfig(const INIReader& reader) {
+    int64_t queueMessages = reader.GetInteger("Links", "QueueMessages", 256);
+    if (queueMessages < 1) {
+        std::cerr << "Invalid [Links] QueueMessages " << queueMessages << ", using 1" << std::endl;
+        queueMessages = 1;
+    }
+    linkQueueMessages = static_cast<size_t>(queueMessages);
+    probeInterval = std::chrono::milliseconds(reader.GetInteger("Links", "ProbeIntervalMs", 0));
+    failoverTimeout = std::chrono::milliseconds(reader.GetInteger("Links", "FailoverMs", 1000));
+    burst = std::chrono::milliseconds(reader.GetInteger("Links", "BurstMs", 100));
+
+    int64_t quantum = reader.GetInteger("Links", "QuantumBytes", 512);
+    std::istringstream weights(reader.GetString("Links", "ClassWeights", "8,3,1"));
+    std::string weight;
+    for (size_t index = 0; index < TrafficClasses && std::getline(weights, weight, ','); ++index) {
+        classQuantum[index] = std::max<int64_t>(1, std::atoll(weight.c_str()) * quantum);
     }
 }
 
-void CommunicationManager::add_communication(CommunicationType communication_type, int port) {
-    std::shared_ptr<ICommunication> communication_ptr;
+void CommunicationManager::add_communication(const INIReader& reader, CommunicationType communication_type, int port,
+                                             double rateBytes, const std::string& path) {
+    add_link(link_name(communication_type, port, path), make_transport(communication_type, port, reader, path),
+             rateBytes < 0 ? default_rate(communication_type, reader) : rateBytes);
+}
 
-    INIReader reader("../config.ini");
+void CommunicationManager::add_link(const std::string& name, std::shared_ptr<ICommunication> transport,
+                                    double rateBytes) {
+    auto link = std::make_unique<Link>();
+    link->name = name;
+    link->transport = std::move(transport);
+    setRate(*link, rateBytes);
+    links.push_back(std::move(link));
+}
 
-    switch (communication_type) {
-        case ECT_TCP:
-            communication_ptr = std::make_shared<TCPServer>(port);
-            break;
-        case ECT_UDP:
-            communication_ptr = std::make_shared<UDPServer>(port);
-            break;
-        case ECT_SERIAL:
-            communication_ptr = std::make_shared<SerialCommunication>(
-                reader.GetString("Connection", "GroundStationSerialPort", "UNKNOWN"),
-                reader.GetInteger("Connection", "GroundStationBaudRate", 0));
-            break;
-        default:
-            throw std::invalid_argument("Unsupported communication type");
-    }
+// Caller holds link.mutex or owns the link alone. The bucket holds BurstMs of traffic and starts full.
+void CommunicationManager::setRate(Link& link, double rateBytes) {
+    link.rateBytes = rateBytes;
+    link.burstBytes = rateBytes * std::chrono::duration<double>(burst).count();
+    link.tokens = link.burstBytes;
+    link.refilledAt = std::chrono::steady_clock::now();
+}
 
-    communication_ptrs.push_back(communication_ptr);
+void CommunicationManager::send_message_all(const std::string &message, Traffic traffic) {
+    // One copy shared by every link
+    auto shared = std::make_shared<const std::string>(message);
+    for (auto& link : links) {
+        enqueue(*link, shared, traffic);
+    }
 }
 
-void CommunicationManager::send_message_all(const std::string &message) {
-    for (auto& communication : communication_ptrs) {
-        communication->send_message(message);
+void CommunicationManager::route_message(const std::string &message, Traffic traffic) {
+    if (traffic == Traffic::Control) {
+        send_message_all(message, traffic);
+        return;
+    }
+    int active = activeLink.load(std::memory_order_relaxed);
+    if (active < static_cast<int>(links.size())) {
+        enqueue(*links[active], std::make_shared<const std::string>(message), traffic);
     }
 }
 
-void CommunicationManager::send_message_by_index(int index,const std::string &message) {
-    if (index < 0 || index >= communication_ptrs.size()) {
+void CommunicationManager::send_message_by_index(int index,const std::string &message, Traffic traffic) {
+    if (index < 0 || index >= links.size()) {
         throw std::out_of_range("Invalid communication index");
     }
-    communication_ptrs[index]->send_message(message);
+    enqueue(*links[index], std::make_shared<const std::string>(message), traffic);
+}
+
+void CommunicationManager::enqueue(Link& link, const std::shared_ptr<const std::string>& message, Traffic traffic) {
+    size_t trafficClass = static_cast<size_t>(traffic);
+    {
+        std::lock_guard<std::mutex> lock(link.mutex);
+        auto& queue = link.queues[trafficClass];
+        if (queue.size() >= linkQueueMessages && !queue.empty()) {
+            // Keep the newest; telemetry that waited a full queue is stale anyway
+            link.classes[trafficClass].droppedBytes += queue.front().message->size();
+            queue.pop_front();
+            if (link.dropped++ % 100 == 0) {
+                std::cerr << "Link " << link.name << " is not keeping up, " << link.dropped
+                          << " message(s) dropped so far" << std::endl;
+            }
+        }
+        queue.push_back({message, std::chrono::steady_clock::now()});
+    }
+    link.ready.notify_one();
+}
+
+// Deficit round robin over the class queues; caller holds link.mutex and one queue is not empty.
+// A class gets its quantum once per turn and keeps sending while its deficit covers the head message.
+size_t CommunicationManager::nextClass(Link& link) {
+    while (true) {
+        size_t trafficClass = link.turn;
+        auto& queue = link.queues[trafficClass];
+        if (queue.empty()) {
+            link.deficit[trafficClass] = 0;
+        } else if (link.deficit[trafficClass] >= static_cast<int64_t>(queue.front().message->size())) {
+            return trafficClass;
+        } else if (!link.turnCredited) {
+            link.deficit[trafficClass] += classQuantum[trafficClass];
+            link.turnCredited = true;
+            continue;
+        }
+        link.turn = (link.turn + 1) % TrafficClasses;
+        link.turnCredited = false;
+    }
+}
+
+void CommunicationManager::runLink(Link& link) {
+    auto pending = [&link] {
+        for (auto& queue : link.queues) {
+            if (!queue.empty()) {
+                return true;
+            }
+        }
+        return false;
+    };
+    bool shaped = false;
+    std::unique_lock<std::mutex> lock(link.mutex);
+    while (true) {
+        link.ready.wait(lock, [&] { return pending() || !link.running; });
+        if (!link.running) {
+            break;
+        }
+
+        // Messages go out while the bucket is not in debt, so one larger than the burst still passes
+        if (link.rateBytes > 0) {
+            auto now = std::chrono::steady_clock::now();
+            double elapsed = std::chrono::duration<double>(now - link.refilledAt).count();
+            link.tokens = std::min(link.burstBytes, link.tokens + elapsed * link.rateBytes);
+            link.refilledAt = now;
+            if (link.tokens < 0) {
+                shaped = true;
+                link.ready.wait_for(lock, std::chrono::duration<double>(-link.tokens / link.rateBytes));
+                continue;
+            }
+        }
+
+        size_t trafficClass = nextClass(link);
+        Queued item = std::move(link.queues[trafficClass].front());
+        link.queues[trafficClass].pop_front();
+        size_t size = item.message->size();
+        link.deficit[trafficClass] -= static_cast<int64_t>(size);
+        std::shared_ptr<ICommunication> transport = link.transport;
+        lock.unlock();
+
+        bool sent = transport->send_message(*item.message);
+        link.latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - item.queuedAt).count()));
+
+        lock.lock();
+        if (sent) {
+            auto& counters = link.classes[trafficClass];
+            ++link.sent;
+            link.bytes += size;
+            ++counters.sent;
+            counters.bytes += size;
+            if (shaped) {
+                counters.shapedBytes += size;
+            }
+            link.tokens -= static_cast<double>(size);
+        } else {
+            ++link.failed;
+        }
+        shaped = false;
+    }
 }
 
 void CommunicationManager::start() {
-    for (auto& communication : communication_ptrs) {
-        communication->start();
+    if (running) {
+        return;
+    }
+    running = true;
+    auto now = std::chrono::steady_clock::now();
+    for (auto& link : links) {
+        link->transport->start();
+        std::lock_guard<std::mutex> lock(link->mutex);
+        link->running = true;
+        link->lastPong = now;
+        link->sender = std::thread(&CommunicationManager::runLink, this, std::ref(*link));
+    }
+
+    ackSubscription = GetEventChannel<SendAckEvent>().subscribe([this](const std::string& command) {
+        route_message("Ack: " + command, Traffic::Control);
+    });
+    if (probeInterval.count() > 0) {
+        pongSubscription = GetEventChannel<LinkPongEvent>().subscribe([this](uint32_t link, uint32_t sequence) {
+            onPong(link, sequence);
+        });
+        probeTimer = GetEventManager().timers().scheduleEvery(probeInterval, [this]() {
+            probeLinks();
+        });
     }
 }
 
 void CommunicationManager::stop() {
-    for (auto& communication : communication_ptrs) {
-        communication->stop();
+    if (running) {
+        running = false;
+        if (probeTimer) {
+            GetEventManager().timers().cancel(probeTimer);
+            probeTimer = 0;
+        }
+        pongSubscription.unsubscribe();
+        ackSubscription.unsubscribe();
+        for (auto& link : links) {
+            {
+                std::lock_guard<std::mutex> lock(link->mutex);
+                link->running = false;
+            }
+            link->ready.notify_one();
+            if (link->sender.joinable()) {
+                link->sender.join();
+            }
+        }
+    }
+    for (auto& link : links) {
+        link->transport->stop();
     }
 }
 
-void CommunicationManager::replace_communication_type(int index, CommunicationType new_communication, int port) {
-    if (index < 0 || index >= communication_ptrs.size()) {
+void CommunicationManager::replace_communication_type(int index, CommunicationType new_communication, int port,
+                                                      const std::string& path) {
+    if (index < 0 || index >= links.size()) {
         throw std::out_of_range("Invalid communication index");
     }
+    Link& link = *links[index];
 
-    communication_ptrs[index]->stop();
+    INIReader reader("../config.ini");
+    // Throws before the link is touched when a local link has no path
+    std::shared_ptr<ICommunication> new_communication_ptr = make_transport(new_communication, port, reader, path);
 
-    std::shared_ptr<ICommunication> new_communication_ptr;
+    std::shared_ptr<ICommunication> old_communication_ptr;
+    {
+        std::lock_guard<std::mutex> lock(link.mutex);
+        old_communication_ptr = link.transport;
+        link.transport = new_communication_ptr;
+        link.name = link_name(new_communication, port, path);
+        setRate(link, default_rate(new_communication, reader));
+    }
+    old_communication_ptr->stop();
+    // Queued messages go out on the new transport
+    if (running) {
+        new_communication_ptr->start();
+    }
+}
 
-    INIReader reader("../config.ini");
-    switch (new_communication) {
-        case ECT_TCP:
-            new_communication_ptr = std::make_shared<TCPServer>(port);
-            break;
-        case ECT_UDP:
-            new_communication_ptr = std::make_shared<UDPServer>(port);
-            break;
-        case ECT_SERIAL:
-            new_communication_ptr = std::make_shared<SerialCommunication>(
-                reader.GetString("Connection", "GroundStationSerialPort", "UNKNOWN"),
-                reader.GetInteger("Connection", "GroundStationBaudRate", 0));
-            break;
-        default:
-            throw std::invalid_argument("Unsupported communication type");
+void CommunicationManager::probeLinks() {
+    auto now = std::chrono::steady_clock::now();
+    for (size_t index = 0; index < links.size(); ++index) {
+        Link& link = *links[index];
+        uint32_t sequence;
+        {
+            std::lock_guard<std::mutex> lock(link.mutex);
+            sequence = link.probeSequence++;
+            size_t slot = sequence % ProbeWindow;
+            link.probeSentAt[slot] = now;
+            link.probeAnswered[slot] = false;
+            ++link.probes;
+
+            if (link.up && now - link.lastPong > failoverTimeout) {
+                link.up = false;
+                std::cerr << "Link " << link.name << " silent for "
+                          << std::chrono::duration_cast<std::chrono::milliseconds>(now - link.lastPong).count()
+                          << " ms, marking it down" << std::endl;
+            }
+        }
+        // Probes ride the control class, so the RTT is what an ack sees behind the shaper
+        enqueue(link, std::make_shared<const std::string>("ping:" + std::to_string(index) + "," + std::to_string(sequence)),
+                Traffic::Control);
     }
+    selectActiveLink(now);
+}
 
-    communication_ptrs[index] = new_communication_ptr;
+void CommunicationManager::onPong(uint32_t index, uint32_t sequence) {
+    if (index >= links.size()) {
+        return;
+    }
+    Link& link = *links[index];
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(link.mutex);
+    size_t slot = sequence % ProbeWindow;
+    // Stale, duplicated (UDP broadcasts reach every client) or never sent
+    if (sequence >= link.probeSequence || link.probeSequence - sequence > ProbeWindow || link.probeAnswered[slot]) {
+        return;
+    }
+    link.probeAnswered[slot] = true;
+    ++link.pongs;
+    double rttUs = std::chrono::duration<double, std::micro>(now - link.probeSentAt[slot]).count();
+    link.rttUs = link.rttUs == 0 ? rttUs : link.rttUs * 0.875 + rttUs * 0.125;
+    link.lastPong = now;
+    if (!link.up) {
+        link.up = true;
+        std::cerr << "Link " << link.name << " is back" << std::endl;
+    }
+}
+
+// Caller holds link.mutex
+double CommunicationManager::probeLoss(const Link& link, std::chrono::steady_clock::time_point now) const {
+    size_t used = std::min<size_t>(link.probeSequence, ProbeWindow);
+    size_t resolved = 0;
+    size_t lost = 0;
+    for (size_t slot = 0; slot < used; ++slot) {
+        if (link.probeAnswered[slot]) {
+            ++resolved;
+        } else if (now - link.probeSentAt[slot] > failoverTimeout) {
+            ++resolved;
+            ++lost;
+        }
+    }
+    return resolved ? static_cast<double>(lost) / resolved : 0;
+}
+
+// Runs on the timer thread after each probe round. Bulk traffic leaves a live link only for one
+// that scores 20% better, so two similar links do not flap.
+void CommunicationManager::selectActiveLink(std::chrono::steady_clock::time_point now) {
+    int current = activeLink.load(std::memory_order_relaxed);
+    int best = -1;
+    double bestScore = 0;
+    double currentScore = 0;
+    bool currentUp = false;
+    std::chrono::steady_clock::time_point currentLastPong;
+    for (size_t index = 0; index < links.size(); ++index) {
+        Link& link = *links[index];
+        std::lock_guard<std::mutex> lock(link.mutex);
+        // Lossy links pay for the retries their traffic will need; unmeasured links rank last
+        double loss = probeLoss(link, now);
+        double score = link.rttUs > 0 ? link.rttUs * (1 + 4 * loss) : 1e12;
+        if (static_cast<int>(index) == current) {
+            currentUp = link.up;
+            currentScore = score;
+            currentLastPong = link.lastPong;
+        }
+        if (link.up && (best < 0 || score < bestScore)) {
+            best = static_cast<int>(index);
+            bestScore = score;
+        }
+    }
+
+    if (best < 0 || best == current || (currentUp && bestScore >= currentScore * 0.8)) {
+        return;
+    }
+    activeLink.store(best, std::memory_order_relaxed);
+    if (!currentUp) {
+        ++failovers;
+        std::cerr << "Bulk traffic failed over from " << links[current]->name << " to " << links[best]->name << ", "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(now - currentLastPong).count()
+                  << " ms after its last pong" << std::endl;
+    } else {
+        std::cerr << "Bulk traffic moved from " << links[current]->name << " to " << links[best]->name << std::endl;
+    }
+}
+
+std::vector<CommunicationManager::LinkStats> CommunicationManager::getLinkStats() const {
+    std::vector<LinkStats> stats;
+    stats.reserve(links.size());
+    int active = activeLink.load(std::memory_order_relaxed);
+    auto now = std::chrono::steady_clock::now();
+    for (size_t index = 0; index < links.size(); ++index) {
+        Link& link = *links[index];
+        std::lock_guard<std::mutex> lock(link.mutex);
+        double loss = probeLoss(link, now);
+        std::array<ClassStats, TrafficClasses> classes;
+        size_t depth = 0;
+        for (size_t trafficClass = 0; trafficClass < TrafficClasses; ++trafficClass) {
+            auto& counters = link.classes[trafficClass];
+            classes[trafficClass] = {link.queues[trafficClass].size(), counters.sent, counters.bytes,
+                                     counters.shapedBytes, counters.droppedBytes};
+            depth += link.queues[trafficClass].size();
+        }
+        stats.push_back({link.name, depth, link.sent, link.bytes, link.dropped, link.failed,
+                         link.latency.summarize(), link.up, static_cast<int>(index) == active, link.rttUs / 1000,
+                         loss, link.probes, link.pongs, static_cast<uint64_t>(link.rateBytes), classes});
+    }
+    return stats;
+}
+
+void CommunicationManager::dumpLinkStats(std::ostream& out) {
+    std::lock_guard<std::mutex> dumpLock(dumpMutex);
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - lastDump).count();
+    lastDump = now;
+
+    std::vector<LinkStats> all = getLinkStats();
+    for (size_t index = 0; index < links.size(); ++index) {
+        uint64_t sentSinceDump;
+        {
+            std::lock_guard<std::mutex> lock(links[index]->mutex);
+            sentSinceDump = links[index]->sent - links[index]->sentAtLastDump;
+            links[index]->sentAtLastDump = links[index]->sent;
+        }
+        auto& stats = all[index];
+        auto& time = stats.latency;
+        out << "[links] " << stats.link << (stats.active ? " (active)" : "") << (stats.up ? " up" : " down")
+            << " rtt=" << stats.rttMs << "ms loss=" << static_cast<int>(stats.loss * 100) << "%"
+            << " queue=" << stats.depth << " sent=" << stats.sent
+            << " rate=" << static_cast<uint64_t>(seconds > 0 ? sentSinceDump / seconds : 0) << "/s bytes=" << stats.bytes
+            << " dropped=" << stats.dropped << " failed=" << stats.failed
+            << " p50=" << time.p50Ns / 1000 << "us p99=" << time.p99Ns / 1000
+            << "us max=" << time.maxNs / 1000 << "us\n";
+        static const char* classNames[TrafficClasses] = {"control", "telemetry", "bulk"};
+        out << "[links] " << stats.link;
+        if (stats.rateBytes > 0) {
+            out << " shaped to " << stats.rateBytes << " B/s";
+        } else {
+            out << " unshaped";
+        }
+        for (size_t trafficClass = 0; trafficClass < TrafficClasses; ++trafficClass) {
+            auto& counters = stats.classes[trafficClass];
+            out << " " << classNames[trafficClass] << "=" << counters.sent << "/" << counters.bytes
+                << "B queue=" << counters.depth << " shaped=" << counters.shapedBytes
+                << "B dropped=" << counters.droppedBytes << "B";
+        }
+        out << "\n";
+    }
+    out << "[links] failovers=" << failovers.load() << "\n";
+    out.flush();
 }
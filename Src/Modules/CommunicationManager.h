@@ -6,30 +6,194 @@
 #include "../../Events/EventManager.h"
 #include "CommandManager.h"
 #include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <ostream>
+#include <array>
+#include <bitset>
+#include <atomic>
 
 enum CommunicationType {
     ECT_TCP,
     ECT_UDP,
-    ECT_SERIAL
+    ECT_SERIAL,
+    ECT_UNIX,           // SOCK_SEQPACKET socket for companion processes, from [Links] only
+    ECT_SHARED_MEMORY   // Shared memory ring for one companion process, from [Links] only
 };
 
+// Ground station links, any mix of serial, UDP and TCP at once. Sending never touches a transport
+// on the caller's thread: each message is queued once per link and a sender thread per link hands
+// it to the transport, so a slow serial radio only backs up its own bounded queue. Links and the
+// queue size come from the [Links] section of config.ini.
+//
+// Link probing is off unless ProbeIntervalMs is above 0. Telemetry and bulk traffic then stay on
+// the first link in Transports and never fail over, and no ground station sees a ping it does not
+// understand. Control traffic, acks included, goes out on every link either way.
+//
+// A ground station that enables probing takes on this contract. Every ProbeIntervalMs each link
+// sends "ping:<link>,<sequence>", two decimal integers, as control traffic; binary peers get it in
+// a Text frame. The ground station answers every ping with "pong:<link>,<sequence>", echoing both
+// numbers unchanged, on the link the ping arrived on and well inside FailoverMs. The pong may be
+// text or a binary command frame. Pongs give each link a smoothed RTT and its loss over the last
+// ProbeWindow probes. A pong on another link would measure the wrong path, and a pong later than
+// FailoverMs counts as lost. A link without a pong for FailoverMs is down, and bulk traffic fails
+// over to the best live link within FailoverMs plus one probe interval. A ground station that
+// never answers therefore sees every link marked down.
+//
+// Each link queues its traffic classes separately. The sender drains them by deficit round robin,
+// ClassWeights times QuantumBytes per round, through a token bucket filled at the link's rate: the
+// "@bytes_per_second" suffix of its Transports entry, or for serial a bit under the baud rate. The
+// backlog then waits here, where an ack can still pass a long telemetry reply, instead of in the
+// transport's own queue.
 class CommunicationManager {
 public:
+    enum class Traffic {
+        Control,    // Acks and probes, duplicated on every link
+        Telemetry,  // Only on the best live link
+        Bulk        // Diagnostics and everything else, only on the best live link
+    };
+    static constexpr size_t TrafficClasses = 3;
+
+    struct ClassStats {
+        size_t depth;
+        uint64_t sent;
+        uint64_t bytes;
+        uint64_t shapedBytes;   // Sent after waiting for the token bucket
+        uint64_t droppedBytes;  // Discarded because the class queue was full
+    };
+
+    struct LinkStats {
+        std::string link;
+        size_t depth;
+        uint64_t sent;
+        uint64_t bytes;
+        uint64_t dropped;   // Discarded because the link queue was full
+        uint64_t failed;    // Refused by the transport
+        LatencyHistogram::Summary latency;  // Queued to handed to the transport
+        bool up;
+        bool active;        // Carries bulk traffic
+        double rttMs;       // Smoothed probe round trip, 0 until the first pong
+        double loss;        // Share of the recent probes that went FailoverMs without a pong
+        uint64_t probes;
+        uint64_t pongs;
+        uint64_t rateBytes;     // Token bucket rate, 0 when unshaped
+        std::array<ClassStats, TrafficClasses> classes;
+    };
+
+    // One link per entry of [Links] Transports, e.g. "serial,udp:8080@1000000,tcp:8081",
+    // "unix:/run/base/cv.sock" or "shm:base_logger"
+    CommunicationManager();
+    // The same from a configuration other than ../config.ini
+    explicit CommunicationManager(const INIReader& config);
     CommunicationManager(CommunicationType communication, int port);
     ~CommunicationManager();
 
-    void send_message_all(const std::string &message);
-    void send_message_by_index(int index,const std::string &message);
+    void send_message_all(const std::string &message, Traffic traffic = Traffic::Bulk);
+    void route_message(const std::string &message, Traffic traffic);
+    void send_message_by_index(int index,const std::string &message, Traffic traffic = Traffic::Bulk);
     void start();
 
     void stop();
 
-    void replace_communication_type(int index, CommunicationType new_communication, int port);
+    // Adds a link over a transport built elsewhere, before start(). A rate of 0 leaves it unshaped.
+    void add_link(const std::string& name, std::shared_ptr<ICommunication> transport, double rateBytes = 0);
+
+    // Swaps the transport of a link in place, keeping its queues. ECT_UNIX and ECT_SHARED_MEMORY
+    // need the socket path or shared memory name, and throw std::invalid_argument without one.
+    void replace_communication_type(int index, CommunicationType new_communication, int port,
+                                    const std::string& path = "");
+
+    std::vector<LinkStats> getLinkStats() const;
+    uint64_t getFailoverCount() const { return failovers; }
+    // One line per link, with the send rate since the previous dump
+    void dumpLinkStats(std::ostream& out);
 
 private:
-    std::vector<std::shared_ptr<ICommunication>> communication_ptrs;
+    static constexpr size_t ProbeWindow = 32;
+
+    struct Queued {
+        std::shared_ptr<const std::string> message;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    struct ClassCounters {
+        uint64_t sent = 0;
+        uint64_t bytes = 0;
+        uint64_t shapedBytes = 0;
+        uint64_t droppedBytes = 0;
+    };
+
+    struct Link {
+        std::string name;
+        std::shared_ptr<ICommunication> transport;
+
+        mutable std::mutex mutex;
+        std::condition_variable ready;
+        std::array<std::deque<Queued>, TrafficClasses> queues;
+        bool running = false;
+        std::thread sender;
+
+        // Guarded by mutex
+        uint64_t sent = 0;
+        uint64_t bytes = 0;
+        uint64_t dropped = 0;
+        uint64_t failed = 0;
+        uint64_t sentAtLastDump = 0;
+        std::array<ClassCounters, TrafficClasses> classes;
+
+        // Token bucket and deficit round robin, guarded by mutex
+        double rateBytes = 0;
+        double burstBytes = 0;
+        double tokens = 0;
+        std::chrono::steady_clock::time_point refilledAt;
+        size_t turn = 0;
+        bool turnCredited = false;
+        std::array<int64_t, TrafficClasses> deficit{};
+
+        // Probe state, guarded by mutex. Probe n holds slot n % ProbeWindow; it counts as lost once it
+        // has gone FailoverMs without a pong.
+        uint32_t probeSequence = 0;
+        std::array<std::chrono::steady_clock::time_point, ProbeWindow> probeSentAt;
+        std::bitset<ProbeWindow> probeAnswered;
+        uint64_t probes = 0;
+        uint64_t pongs = 0;
+        double rttUs = 0;
+        std::chrono::steady_clock::time_point lastPong;
+        bool up = true;
+
+        LatencyHistogram latency;   // Recorded by the sender without the lock
+    };
+
+    std::vector<std::unique_ptr<Link>> links;
+    size_t linkQueueMessages = 256;
+    std::array<int64_t, TrafficClasses> classQuantum{8 * 512, 3 * 512, 512};
+    std::chrono::milliseconds burst{100};
+    bool running = false;
+
+    std::chrono::milliseconds probeInterval{0};
+    std::chrono::milliseconds failoverTimeout{1000};
+    TimerWheel::TimerId probeTimer = 0;
+    std::atomic<int> activeLink{0};
+    std::atomic<uint64_t> failovers{0};
+    EventSubscription pongSubscription;
+    EventSubscription ackSubscription;
+    std::chrono::steady_clock::time_point lastDump = std::chrono::steady_clock::now();
+    std::mutex dumpMutex;
 
-    void add_communication(CommunicationType communication, int port);
+    void loadConfig(const INIReader& reader);
+    void add_communication(const INIReader& reader, CommunicationType communication, int port, double rateBytes = -1,
+                           const std::string& path = "");
+    void setRate(Link& link, double rateBytes);
+    void enqueue(Link& link, const std::shared_ptr<const std::string>& message, Traffic traffic);
+    void runLink(Link& link);
+    size_t nextClass(Link& link);
+    void probeLinks();
+    void onPong(uint32_t link, uint32_t sequence);
+    void selectActiveLink(std::chrono::steady_clock::time_point now);
+    double probeLoss(const Link& link, std::chrono::steady_clock::time_point now) const;
 };
 
 #endif //COMMUNICATIONMANAGER_H
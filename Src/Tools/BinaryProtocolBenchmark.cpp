@@ -0,0 +1,126 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include "../Communications/BinaryProtocol.h"
+
+// Bytes on the wire and CPU time per message for the binary protocol against the text protocol,
+// over the same mix of ground station commands as command_parser_benchmark. Encoding is what a
+// ground station pays per message, decoding what the receive thread pays.
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+using BinaryProtocol::Field;
+using BinaryProtocol::FieldType;
+
+struct Message {
+    CommandId id;
+    std::vector<Field> fields;
+};
+
+// The text form a ground station sends: shortest %g that survives the trip
+std::string encodeText(const Message& message) {
+    std::string text(commandName(message.id));
+    text.push_back(':');
+    char number[32];
+    for (size_t i = 0; i < message.fields.size(); ++i) {
+        int precision = message.fields[i].type == FieldType::Float64 ? 10 : 7;
+        int length = std::snprintf(number, sizeof(number), "%.*g", precision, message.fields[i].value);
+        if (i > 0) {
+            text.push_back(',');
+        }
+        text.append(number, length);
+    }
+    text.push_back('\n');
+    return text;
+}
+
+template <typename Function>
+void report(const char* name, size_t messages, Function&& function) {
+    auto start = Clock::now();
+    size_t checksum = function();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << name << ": " << seconds * 1e9 / messages << " ns/message, "
+              << static_cast<uint64_t>(messages / seconds) << " messages/s (checksum " << checksum << ")" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t rounds = argc > 1 ? std::stoul(argv[1]) : 500000;
+    const std::vector<Message> mix = {
+        {CommandId::FlyTo, {{FieldType::Float64, 47.397742}, {FieldType::Float64, 8.545594}, {FieldType::Float32, 30.5}}},
+        {CommandId::SetManualControl, {{FieldType::UInt16, 1500}, {FieldType::UInt16, 1500}, {FieldType::UInt16, 1000}, {FieldType::UInt16, 1500}}},
+        {CommandId::SetManualControl, {{FieldType::UInt16, 1490}, {FieldType::UInt16, 1512}, {FieldType::UInt16, 1100}, {FieldType::UInt16, 1500}}},
+        {CommandId::Hold, {}},
+        {CommandId::SetFlightMode, {{FieldType::Int32, 1}, {FieldType::Int32, 4}}},
+        {CommandId::Land, {}},
+    };
+    size_t messages = rounds * mix.size();
+
+    std::string text;
+    std::string binary;
+    for (const auto& message : mix) {
+        text += encodeText(message);
+        BinaryProtocol::encodeCommand(binary, message.id, message.fields.data(), message.fields.size());
+    }
+    std::cout << "text: " << double(text.size()) / mix.size() << " bytes/message" << std::endl;
+    std::cout << "binary: " << double(binary.size()) / mix.size() << " bytes/message" << std::endl;
+
+    report("text encode", messages, [&]() {
+        size_t checksum = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            for (const auto& message : mix) {
+                checksum += encodeText(message).size();
+            }
+        }
+        return checksum;
+    });
+
+    report("binary encode", messages, [&]() {
+        std::string out;
+        size_t checksum = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            for (const auto& message : mix) {
+                out.clear();
+                BinaryProtocol::encodeCommand(out, message.id, message.fields.data(), message.fields.size());
+                checksum += out.size();
+            }
+        }
+        return checksum;
+    });
+
+    report("text decode", messages, [&]() {
+        ParsedCommand commands[8];
+        size_t checksum = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            BatchParseResult result = parseCommandBatch(text, commands, std::size(commands));
+            for (size_t i = 0; i < result.parsed; ++i) {
+                checksum += commands[i].parameterCount + static_cast<size_t>(commands[i].id);
+            }
+        }
+        return checksum;
+    });
+
+    // CRC check and field decoding, as ProtocolSession does per frame
+    report("binary decode", messages, [&]() {
+        BinaryProtocol::Frame frame;
+        ParsedCommand command;
+        size_t checksum = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            std::string_view buffer = binary;
+            while (!buffer.empty()) {
+                BinaryProtocol::DecodeResult result = BinaryProtocol::decodeFrame(buffer, frame);
+                BinaryProtocol::decodeCommand(frame, command);
+                checksum += command.parameterCount + static_cast<size_t>(command.id);
+                buffer.remove_prefix(result.consumed);
+            }
+        }
+        return checksum;
+    });
+    return 0;
+}
@@ -0,0 +1,271 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../../Events/EventChannels.h"
+#include "../Communications/BinaryProtocol.h"
+#include "TestCheck.h"
+
+// Encoder and decoder of the binary protocol, then ProtocolSession on the receive paths that
+// matter in the field: corrupted frames, frames split across reads, frames between text lines and
+// frames cut short by the end of a datagram.
+
+namespace {
+
+struct Received {
+    CommandId command;
+    std::vector<double> parameters;
+    uint32_t client;
+};
+
+std::vector<Received> received;
+
+// What TCPServer does with each read: keep the bytes, hand the session the whole messages
+// scanStream finds and keep the rest for the next read
+void receiveStream(ProtocolSession& session, std::string& buffer, std::string_view data, std::string& reply) {
+    buffer.append(data.data(), data.size());
+    BinaryProtocol::StreamScan scan = BinaryProtocol::scanStream(buffer, 256);
+    CHECK(scan.error == BinaryProtocol::FrameStatus::Ok);
+    if (scan.complete > 0) {
+        session.receive(std::string_view(buffer).substr(0, scan.complete), reply, "test");
+        buffer.erase(0, scan.complete);
+    }
+}
+
+std::string flyToFrame(double latitude, double longitude, double altitude) {
+    const BinaryProtocol::Field fields[] = {
+        {BinaryProtocol::FieldType::Float64, latitude},
+        {BinaryProtocol::FieldType::Float64, longitude},
+        {BinaryProtocol::FieldType::Float32, altitude},
+    };
+    std::string frame;
+    BinaryProtocol::encodeCommand(frame, CommandId::FlyTo, fields, std::size(fields));
+    return frame;
+}
+
+void testEncodeDecode() {
+    using namespace BinaryProtocol;
+
+    const Field fields[] = {
+        {FieldType::Float64, 47.397742},
+        {FieldType::Float32, 30.5},
+        {FieldType::Int32, -12},
+        {FieldType::UInt16, 1500},
+    };
+    std::string bytes;
+    CHECK(encodeCommand(bytes, "fly_to", fields, std::size(fields)));
+    CHECK(static_cast<uint8_t>(bytes[0]) == Magic);
+
+    Frame frame;
+    DecodeResult result = decodeFrame(bytes, frame);
+    CHECK(result.status == FrameStatus::Ok);
+    CHECK(result.consumed == bytes.size());
+    CHECK(frame.id == MessageId::Command);
+
+    ParsedCommand command;
+    CHECK(decodeCommand(frame, command));
+    CHECK(command.id == CommandId::FlyTo);
+    CHECK(command.name == "fly_to");
+    CHECK(command.parameterCount == 4);
+    CHECK(command.parameters[0] == 47.397742);
+    CHECK(command.parameters[1] == 30.5);
+    CHECK(command.parameters[2] == -12);
+    CHECK(command.parameters[3] == 1500);
+
+    bytes = flyToFrame(47.397742, 8.545594, 30);
+    result = decodeFrame(bytes, frame);
+    CHECK(result.status == FrameStatus::Ok);
+    CHECK(frame.id == MessageId::CommandById);
+    CHECK(decodeCommand(frame, command));
+    CHECK(command.id == CommandId::FlyTo);
+    CHECK(command.name == "fly_to");
+    CHECK(command.parameters[1] == 8.545594);
+
+    // Every proper prefix is incomplete and asks for nothing to be dropped
+    for (size_t length = 0; length < bytes.size(); ++length) {
+        result = decodeFrame(std::string_view(bytes).substr(0, length), frame);
+        CHECK(result.status == FrameStatus::Incomplete);
+        CHECK(result.consumed == 0);
+    }
+
+    CHECK(!encodeCommand(bytes, CommandId::Unknown, nullptr, 0));
+    CHECK(!encodeFrame(bytes, MessageId::Text, std::string(MaxPayload + 1, 'x')));
+}
+
+void testCrcMismatch() {
+    using namespace BinaryProtocol;
+
+    std::string bytes = flyToFrame(47.397742, 8.545594, 30);
+    Frame frame;
+    // Any single corrupted byte after the magic is caught; the decoder resynchronises on the next byte
+    for (size_t i = 1; i < bytes.size(); ++i) {
+        std::string corrupted = bytes;
+        corrupted[i] ^= 0x10;
+        DecodeResult result = decodeFrame(corrupted, frame);
+        if (i == 3 || i == 4) {
+            // A corrupted length reads as a longer frame, or one over the limit
+            CHECK(result.status == FrameStatus::Incomplete || result.status == FrameStatus::TooLarge ||
+                  result.status == FrameStatus::BadCrc);
+        } else {
+            CHECK(result.status == FrameStatus::BadCrc);
+            CHECK(result.consumed == 1);
+        }
+    }
+
+    // The session drops the bad frame and still reads the good one behind it
+    std::string corrupted = bytes;
+    corrupted[HeaderSize + 3] ^= 0x01;
+    received.clear();
+    ProtocolSession session;
+    std::string reply;
+    session.receive(corrupted + flyToFrame(1, 2, 3), reply, "test");
+    CHECK(received.size() == 1);
+    CHECK(!received.empty() && received[0].parameters == std::vector<double>({1, 2, 3}));
+}
+
+void testSplitFrame() {
+    std::string bytes = flyToFrame(47.397742, 8.545594, 30) + flyToFrame(1, 2, 3);
+
+    // One byte per read, as a slow serial link or a TCP segment boundary can deliver it
+    received.clear();
+    ProtocolSession session;
+    std::string reply;
+    for (char byte : bytes) {
+        session.receive(std::string_view(&byte, 1), reply, "test");
+    }
+    CHECK(received.size() == 2);
+    CHECK(received.size() == 2 && received[0].parameters[0] == 47.397742 && received[1].parameters[2] == 3);
+    CHECK(received.size() == 2 && received[0].client == session.clientId());
+
+    // Every split point of the pair
+    for (size_t split = 1; split < bytes.size(); ++split) {
+        received.clear();
+        ProtocolSession splitSession;
+        splitSession.receive(std::string_view(bytes).substr(0, split), reply, "test");
+        splitSession.receive(std::string_view(bytes).substr(split), reply, "test");
+        CHECK(received.size() == 2);
+    }
+    CHECK(reply.empty());
+}
+
+void testFrameInsideText() {
+    std::string frame = flyToFrame(47.397742, 8.545594, 30);
+
+    // Text before the first frame is still a text peer's; after it the peer is binary and bare
+    // text between frames is skipped
+    received.clear();
+    ProtocolSession session;
+    std::string reply;
+    session.receive("hold:\nland:\n" + frame + "arm:\n" + frame, reply, "test");
+    CHECK(received.size() == 4);
+    if (received.size() == 4) {
+        CHECK(received[0].command == CommandId::Hold);
+        CHECK(received[1].command == CommandId::Land);
+        CHECK(received[2].command == CommandId::FlyTo);
+        CHECK(received[3].command == CommandId::FlyTo);
+    }
+    CHECK(session.isBinary());
+
+    // The text line and the frame split across reads of a stream
+    std::string bytes = "takeoff:10\n" + frame;
+    for (size_t split = 1; split < bytes.size(); ++split) {
+        received.clear();
+        ProtocolSession splitSession;
+        std::string buffer;
+        receiveStream(splitSession, buffer, std::string_view(bytes).substr(0, split), reply);
+        receiveStream(splitSession, buffer, std::string_view(bytes).substr(split), reply);
+        CHECK(buffer.empty());
+        CHECK(received.size() == 2);
+        CHECK(received.size() == 2 && received[0].command == CommandId::Takeoff && received[1].command == CommandId::FlyTo);
+    }
+
+    // Text frames carry text protocol messages once binary
+    std::string text;
+    BinaryProtocol::encodeFrame(text, BinaryProtocol::MessageId::Text, "land:\n");
+    received.clear();
+    session.receive(text, reply, "test");
+    CHECK(received.size() == 1 && received[0].command == CommandId::Land);
+}
+
+void testDatagrams() {
+    using Framing = ProtocolSession::Framing;
+    std::string frame = flyToFrame(47.397742, 8.545594, 30);
+    std::string reply;
+
+    // A datagram that ends inside a frame is dropped from there on, and the next datagram does not
+    // complete it even when its bytes would
+    for (size_t split = 1; split < frame.size(); ++split) {
+        received.clear();
+        ProtocolSession session(Framing::Datagram);
+        session.receive(std::string_view(frame).substr(0, split), reply, "test");
+        session.receive(std::string_view(frame).substr(split), reply, "test");
+        CHECK(received.empty());
+
+        // Whole frames in later datagrams are unaffected
+        session.receive(frame, reply, "test");
+        CHECK(received.size() == 1);
+    }
+
+    // A truncated frame after whole messages in the same datagram costs only itself
+    received.clear();
+    ProtocolSession session(Framing::Datagram);
+    session.receive("hold:\n" + frame + frame.substr(0, 9), reply, "test");
+    CHECK(received.size() == 2);
+    CHECK(received.size() == 2 && received[0].command == CommandId::Hold && received[1].command == CommandId::FlyTo);
+    session.receive(frame.substr(9) + frame, reply, "test");
+    CHECK(received.size() == 3);
+
+    // A datagram holding a header alone
+    received.clear();
+    session.receive(frame.substr(0, BinaryProtocol::HeaderSize), reply, "test");
+    session.receive(frame, reply, "test");
+    CHECK(received.size() == 1);
+
+    // The stream session reassembles the same split, which is what went wrong for datagrams
+    received.clear();
+    ProtocolSession stream(Framing::Stream);
+    stream.receive(frame.substr(0, 9), reply, "test");
+    stream.receive(frame.substr(9), reply, "test");
+    CHECK(received.size() == 1);
+}
+
+void testHello() {
+    using namespace BinaryProtocol;
+
+    std::string hello;
+    encodeHello(hello);
+    ProtocolSession session;
+    CHECK(!session.isBinary());
+    std::string reply;
+    session.receive(hello, reply, "test");
+    CHECK(session.isBinary());
+
+    Frame frame;
+    CHECK(decodeFrame(reply, frame).status == FrameStatus::Ok);
+    CHECK(frame.id == MessageId::Hello);
+    CHECK(frame.payload.size() == 2 && frame.payload[0] == Version && frame.payload[1] == Version);
+
+    // Outgoing messages are framed for the binary peer and split at MaxPayload
+    std::string outbound = session.encodeOutbound(std::string(MaxPayload + 10, 'x'));
+    DecodeResult first = decodeFrame(outbound, frame);
+    CHECK(first.status == FrameStatus::Ok && frame.payload.size() == MaxPayload);
+    CHECK(decodeFrame(std::string_view(outbound).substr(first.consumed), frame).status == FrameStatus::Ok);
+    CHECK(frame.payload.size() == 10);
+}
+
+}
+
+int main() {
+    auto subscription = GetEventChannel<CommandReceivedEvent>().subscribe(
+            [](CommandId command, const std::vector<double>& parameters, uint32_t client) {
+                received.push_back({command, parameters, client});
+            });
+
+    testEncodeDecode();
+    testCrcMismatch();
+    testSplitFrame();
+    testFrameInsideText();
+    testDatagrams();
+    testHello();
+    return testResult();
+}
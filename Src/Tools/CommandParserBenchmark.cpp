@@ -0,0 +1,107 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
+#include "../Communications/CommandParser.h"
+
+// Nanoseconds per message for the shared text parser against the substr/stof code it replaced
+// in UDPServer, TCPServer and SerialCommunication, over a mix of typical ground station commands.
+// Also parses the same mix as newline-separated batches, as TCP and serial reads deliver them.
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// The removed transport parser, minus the event dispatch and error logging
+size_t legacyParse(const std::string& message, std::string& command, std::vector<float>& params) {
+    params.clear();
+    size_t pos = message.find(':');
+    if (pos == std::string::npos) {
+        return 0;
+    }
+    command = message.substr(0, pos);
+    std::string params_str = message.substr(pos + 1);
+    size_t start = 0;
+    size_t end;
+    while ((end = params_str.find(',', start)) != std::string::npos) {
+        try {
+            params.push_back(std::stof(params_str.substr(start, end - start)));
+        } catch (const std::exception&) {
+        }
+        start = end + 1;
+    }
+    if (start < params_str.length()) {
+        try {
+            params.push_back(std::stof(params_str.substr(start)));
+        } catch (const std::exception&) {
+        }
+    }
+    return params.size();
+}
+
+template <typename Function>
+void report(const char* name, size_t messages, Function&& function) {
+    auto start = Clock::now();
+    size_t checksum = function();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << name << ": " << seconds * 1e9 / messages << " ns/message, "
+              << static_cast<uint64_t>(messages / seconds) << " messages/s (checksum " << checksum << ")" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t rounds = argc > 1 ? std::stoul(argv[1]) : 500000;
+    const std::vector<std::string> mix = {
+        "fly_to:47.397742,8.545594,30.5",
+        "set_manual_control:1500,1500,1000,1500",
+        "set_manual_control:1490,1512,1100,1500",
+        "hold:",
+        "set_flight_mode:1,4",
+        "land:",
+    };
+    std::string batch;
+    for (const auto& message : mix) {
+        batch += message + "\n";
+    }
+    size_t messages = rounds * mix.size();
+
+    report("substr/stof", messages, [&]() {
+        std::string command;
+        std::vector<float> params;
+        size_t checksum = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            for (const auto& message : mix) {
+                checksum += legacyParse(message, command, params) + command.size();
+            }
+        }
+        return checksum;
+    });
+
+    report("parseCommand", messages, [&]() {
+        ParsedCommand command;
+        size_t checksum = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            for (const auto& message : mix) {
+                parseCommand(message, command);
+                checksum += command.parameterCount + command.name.size();
+            }
+        }
+        return checksum;
+    });
+
+    report("parseCommandBatch", messages, [&]() {
+        ParsedCommand commands[8];
+        size_t checksum = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            BatchParseResult result = parseCommandBatch(batch, commands, std::size(commands));
+            for (size_t i = 0; i < result.parsed; ++i) {
+                checksum += commands[i].parameterCount + commands[i].name.size();
+            }
+        }
+        return checksum;
+    });
+    return 0;
+}
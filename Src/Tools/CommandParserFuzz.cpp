@@ -0,0 +1,241 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include "../Communications/CommandParser.h"
+#include "TestCheck.h"
+
+// Fuzz target for the text command parser. Built with COMMAND_PARSER_LIBFUZZER it is a libFuzzer
+// entry point (clang -fsanitize=fuzzer); otherwise main() checks a table of malformed numbers and
+// from_chars edge cases, then runs the same invariants over generated inputs from a fixed seed.
+// Invariants: no crash, accepted commands are known with finite parameters and survive a
+// format/parse round trip, and batch parsing agrees with parsing each line on its own.
+
+namespace {
+
+void fail(const char* what, std::string_view input) {
+    std::cerr << "Invariant failed: " << what << " for input \"";
+    for (char c : input) {
+        if (c >= 0x20 && c < 0x7f) {
+            std::cerr << c;
+        } else {
+            char escaped[5];
+            std::snprintf(escaped, sizeof(escaped), "\\x%02x", static_cast<unsigned char>(c));
+            std::cerr << escaped;
+        }
+    }
+    std::cerr << "\"" << std::endl;
+    std::abort();
+}
+
+bool blank(std::string_view line) {
+    return line.find_first_not_of(std::string_view(" \t\r\n\0", 5)) == std::string_view::npos;
+}
+
+bool sameCommand(const ParsedCommand& a, const ParsedCommand& b) {
+    if (a.id != b.id || a.parameterCount != b.parameterCount) {
+        return false;
+    }
+    for (size_t i = 0; i < a.parameterCount; ++i) {
+        if (a.parameters[i] != b.parameters[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void checkSingle(std::string_view input, const ParsedCommand& command, const ParseResult& result) {
+    if (!result) {
+        if (result.position > input.size()) {
+            fail("error position past the end", input);
+        }
+        return;
+    }
+    if (command.id == CommandId::Unknown || command.name.empty()) {
+        fail("accepted an unknown command", input);
+    }
+    if (command.name.data() < input.data() || command.name.data() + command.name.size() > input.data() + input.size()) {
+        fail("name does not point into the input", input);
+    }
+    if (command.parameterCount > ParsedCommand::MaxParameters) {
+        fail("parameter count over the limit", input);
+    }
+
+    // Shortest exact form of every parameter must parse back to the same values
+    std::string formatted(commandName(command.id));
+    formatted += ':';
+    for (size_t i = 0; i < command.parameterCount; ++i) {
+        if (!std::isfinite(command.parameters[i])) {
+            fail("accepted a non-finite parameter", input);
+        }
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.17g", command.parameters[i]);
+        formatted += (i ? "," : "");
+        formatted += number;
+    }
+    ParsedCommand again;
+    if (!parseCommand(formatted, again) || !sameCommand(command, again)) {
+        fail("round trip changed the command", input);
+    }
+}
+
+// Returns the number of messages the batch parser accepted
+size_t checkInput(std::string_view input) {
+    ParsedCommand command;
+    checkSingle(input, command, parseCommand(input, command));
+
+    // Small capacity so the buffer takes several calls
+    ParsedCommand batch[3];
+    size_t lines = 0;
+    size_t accepted = 0;
+    size_t rejected = 0;
+    std::string_view rest = input;
+    size_t lineStart = 0;
+    while (lineStart < input.size()) {
+        size_t newline = input.find('\n', lineStart);
+        std::string_view line = input.substr(lineStart, newline == std::string_view::npos ? std::string_view::npos : newline - lineStart);
+        lines += blank(line) ? 0 : 1;
+        lineStart = newline == std::string_view::npos ? input.size() : newline + 1;
+    }
+    while (!rest.empty()) {
+        BatchParseResult result = parseCommandBatch(rest, batch, std::size(batch));
+        if (result.consumed == 0 || result.consumed > rest.size() || result.parsed > std::size(batch)) {
+            fail("batch made no progress or overran", input);
+        }
+        for (size_t i = 0; i < result.parsed; ++i) {
+            checkSingle(input, batch[i], ParseResult());
+        }
+        accepted += result.parsed;
+        rejected += result.failed;
+        rest.remove_prefix(result.consumed);
+    }
+    if (accepted + rejected != lines) {
+        fail("batch lost or invented messages", input);
+    }
+    return accepted;
+}
+
+std::string_view expectOk(std::string_view input, size_t count) {
+    ParsedCommand command;
+    ParseResult result = parseCommand(input, command);
+    if (!result || command.parameterCount != count) {
+        std::cerr << "Expected \"" << input << "\" to parse with " << count << " parameter(s), got "
+                  << parseErrorString(result.error) << " with " << command.parameterCount << std::endl;
+        ++testFailures();
+    }
+    return input;
+}
+
+void expectError(std::string_view input, ParseError error) {
+    ParsedCommand command;
+    ParseResult result = parseCommand(input, command);
+    if (result.error != error) {
+        std::cerr << "Expected \"" << input << "\" to fail with " << parseErrorString(error) << ", got "
+                  << parseErrorString(result.error) << std::endl;
+        ++testFailures();
+    }
+}
+
+double firstParameter(std::string_view input) {
+    ParsedCommand command;
+    return parseCommand(input, command) && command.parameterCount ? command.parameters[0] : NAN;
+}
+
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    checkInput(std::string_view(reinterpret_cast<const char*>(data), size));
+    return 0;
+}
+
+#ifndef COMMAND_PARSER_LIBFUZZER
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    expectOk("fly_to:47.397742,8.545594,30", 3);
+    expectOk("  fly_to : 1 , 2 \r\n", 2);
+    expectOk("fly_to:1,", 1);
+    expectOk("hold:", 0);
+    expectOk("fly_to:+1", 1);
+    expectOk("fly_to:.5", 1);
+    expectOk("fly_to:5.", 1);
+    expectOk("fly_to:-.5e1", 1);
+    expectOk("fly_to:1e308", 1);
+    expectOk("fly_to:4.9e-324", 1);
+    expectOk("fly_to:3.14159265358979323846264338327950288419716939937510", 1);
+    expectOk("set_manual_control:1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16", 16);
+    CHECK(std::signbit(firstParameter("fly_to:-0")) && firstParameter("fly_to:-0") == 0.0);
+    CHECK(firstParameter("fly_to:-.5e1") == -5.0);
+    CHECK(firstParameter("fly_to:47.397742") == 47.397742);
+
+    expectError("fly_to", ParseError::MissingSeparator);
+    expectError(":1", ParseError::EmptyCommand);
+    expectError("fly:1", ParseError::UnknownCommand);
+    expectError("fly_to:1,,2", ParseError::EmptyParameter);
+    expectError("fly_to:,", ParseError::EmptyParameter);
+    expectError("set_manual_control:1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17", ParseError::TooManyParameters);
+    // Out of range either way, non-finite, partial and foreign number formats
+    for (std::string_view bad : {"1e309", "-1e309", "1e-400", "2e-324", "nan", "-nan", "inf", "-inf", "infinity",
+                                 "0x10", "1e", "1e+", "1.2.3", "1 2", "--1", "+-1", "++1", "+", "-", ".", "e5",
+                                 "1,5e", "1f", "1_000", "١"}) {
+        expectError("fly_to:" + std::string(bad), ParseError::InvalidParameter);
+    }
+    expectError("fly_to:1" + std::string(400, '0'), ParseError::InvalidParameter);
+    expectError("fly_to:0." + std::string(400, '0') + "1", ParseError::InvalidParameter);
+
+    // Generated inputs. Half are well-formed messages, possibly several lines, with a few bytes
+    // then changed; the rest are fragments that reach every parser branch, plus random bytes.
+    const std::vector<std::string> names = {"fly_to", "hold", "land", "set_manual_control", "pong", "takeof", ""};
+    const std::vector<std::string> numbers = {
+        "1", "-1", "+1", "+-1", "0.5", ".5", "5.", "-0", "47.397742", "1e308", "1e309", "1e-400", "4.9e-324",
+        "2e-324", "nan", "inf", "0x1p3", "1e", "12345678901234567890", std::string(64, '9'), "", " 7 ",
+    };
+    const std::vector<std::string> fragments = {
+        "fly_to", "hold", ":", ",", ",,", " ", "\t", "\r\n", "\n", std::string(1, '\0'), "1", "-1", "1e309",
+        "nan", "\xa5", "\xff",
+    };
+    std::mt19937_64 random(20261017);
+    std::string input;
+    size_t parsed = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        input.clear();
+        if (random() % 2) {
+            size_t lines = 1 + random() % 3;
+            for (size_t line = 0; line < lines; ++line) {
+                input += names[random() % names.size()];
+                input += ':';
+                size_t count = random() % (ParsedCommand::MaxParameters + 2);
+                for (size_t p = 0; p < count; ++p) {
+                    input += (p ? "," : "");
+                    input += numbers[random() % numbers.size()];
+                }
+                input += '\n';
+            }
+            for (size_t mutations = random() % 4; mutations > 0 && !input.empty(); --mutations) {
+                size_t at = random() % input.size();
+                if (random() % 2) {
+                    input[at] = static_cast<char>(random() % 256);
+                } else {
+                    input.insert(at, fragments[random() % fragments.size()]);
+                }
+            }
+        } else {
+            for (size_t pieces = random() % 12; pieces > 0; --pieces) {
+                if (random() % 8 == 0) {
+                    input += static_cast<char>(random() % 256);
+                } else {
+                    input += fragments[random() % fragments.size()];
+                }
+            }
+        }
+        parsed += checkInput(input);
+    }
+    std::cout << "Checked " << iterations << " generated inputs, " << parsed << " messages in them parsed" << std::endl;
+    return testResult();
+}
+#endif
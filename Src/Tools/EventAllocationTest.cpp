@@ -0,0 +1,113 @@
+#include <iostream>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "../../Events/EventChannels.h"
+#include "../Communications/CommandParser.h"
+#include "TestCheck.h"
+
+// Counts heap allocations around synchronous event dispatch. After a warm-up invoke, publishing a
+// command to N subscribers, parse included, must not allocate, and neither must copying or moving
+// a Delegate whose capture fills the inline storage.
+
+namespace {
+std::atomic<bool> counting{false};
+std::atomic<uint64_t> allocations{0};
+
+void* allocate(size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+// Allocations made by fn, which runs with the counter armed
+template <typename Function>
+uint64_t allocationsDuring(Function&& fn) {
+    allocations = 0;
+    counting = true;
+    fn();
+    counting = false;
+    return allocations.load();
+}
+
+const int subscriberCount = 8;
+const int rounds = 10000;
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+
+int main() {
+    CREATE_EVENT("command_received", CommandId command, const std::vector<double> & parameters, uint32_t client);
+
+    // Captures as large as the inline storage allows: six pointers
+    std::array<double, subscriberCount> sums{};
+    uint64_t calls = 0;
+    int a = 0, b = 0, c = 0, d = 0;
+    std::vector<EventSubscription> subscriptions;
+    for (int i = 0; i < subscriberCount; ++i) {
+        double* sum = &sums[i];
+        subscriptions.push_back(GetEventChannel<CommandReceivedEvent>().subscribe(
+                [sum, &calls, &a, &b, &c, &d](CommandId, const std::vector<double>& parameters, uint32_t) {
+                    for (double parameter : parameters) {
+                        *sum += parameter;
+                    }
+                    ++calls;
+                    (void)a, (void)b, (void)c, (void)d;
+                }));
+    }
+
+    std::vector<double> parameters{47.397742, 8.545594, 30.0};
+    GetEventChannel<CommandReceivedEvent>().invoke(CommandId::FlyTo, parameters, 1u);
+    CHECK(allocationsDuring([&]() {
+        for (int i = 0; i < rounds; ++i) {
+            GetEventChannel<CommandReceivedEvent>().invoke(CommandId::FlyTo, parameters, 1u);
+        }
+    }) == 0);
+    CHECK(calls == uint64_t(subscriberCount) * (rounds + 1));
+
+    // The receive path: parse the text message, then publish it to every subscriber
+    const std::string_view message = "fly_to:47.397742,8.545594,30\n";
+    publishCommands(message, "test");
+    calls = 0;
+    CHECK(allocationsDuring([&]() {
+        for (int i = 0; i < rounds; ++i) {
+            publishCommands(message, "test");
+        }
+    }) == 0);
+    CHECK(calls == uint64_t(subscriberCount) * rounds);
+
+    using Callback = CommandReceivedEvent::EventType::EventCallback;
+    CHECK(allocationsDuring([&]() {
+        Callback original = [sum = &sums[0], &calls, &a, &b, &c, &d](const CommandId&, const std::vector<double>&, const uint32_t&) {
+            ++*sum;
+            ++calls;
+            (void)a, (void)b, (void)c, (void)d;
+        };
+        Callback copy = original;
+        Callback moved = std::move(copy);
+        moved(CommandId::Hold, parameters, 1u);
+    }) == 0);
+
+    std::cout << "Dispatched " << rounds << " commands to " << subscriberCount << " subscribers twice" << std::endl;
+    subscriptions.clear();
+    return testResult();
+}
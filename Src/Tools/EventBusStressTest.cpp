@@ -0,0 +1,99 @@
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include "../../Events/EventManager.h"
+#include "TestCheck.h"
+
+// Invokes one event from several threads while others subscribe and unsubscribe as fast as they
+// can, and while a callback subscribes from inside invoke. A permanent subscriber must see every
+// invoke, and no callback may run once its unsubscribe() has returned. Run it under TSan or ASan
+// to check the snapshot reclamation as well.
+
+namespace {
+const int invokerThreads = 4;
+const int churnThreads = 4;
+const int invokesPerThread = 200000;
+const int subscriptionsPerThread = 2000;
+
+struct ChurnState {
+    std::atomic<bool> unsubscribed{false};
+    std::atomic<uint64_t> calls{0};
+};
+}
+
+int main() {
+    Event<int> event("stress");
+    std::atomic<uint64_t> permanentCalls{0};
+    std::atomic<uint64_t> lateCalls{0};
+    std::atomic<uint64_t> churnCalls{0};
+    std::atomic<uint64_t> nestedSubscriptions{0};
+
+    auto permanent = event.subscribe([&permanentCalls](const int&) {
+        permanentCalls.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    // Subscribing and unsubscribing from inside a callback must neither deadlock nor free the
+    // snapshot the calling invoke is still walking
+    auto nested = event.subscribe([&event, &nestedSubscriptions](const int& value) {
+        if (value % 5000 == 0) {
+            auto inner = event.subscribe([](const int&) {});
+            inner.unsubscribe();
+            nestedSubscriptions.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    std::vector<std::thread> churners;
+    for (int t = 0; t < churnThreads; ++t) {
+        churners.emplace_back([&]() {
+            for (int i = 0; i < subscriptionsPerThread; ++i) {
+                auto state = std::make_shared<ChurnState>();
+                auto subscription = event.subscribe([state, &lateCalls](const int&) {
+                    if (state->unsubscribed.load()) {
+                        lateCalls.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    state->calls.fetch_add(1, std::memory_order_relaxed);
+                });
+                std::this_thread::yield();
+                subscription.unsubscribe();
+                state->unsubscribed.store(true);
+                churnCalls.fetch_add(state->calls.load(), std::memory_order_relaxed);
+            }
+        });
+    }
+
+    std::vector<std::thread> invokers;
+    for (int t = 0; t < invokerThreads; ++t) {
+        invokers.emplace_back([&event]() {
+            for (int i = 1; i <= invokesPerThread; ++i) {
+                event.invoke(i);
+            }
+        });
+    }
+
+    for (auto& thread : invokers) {
+        thread.join();
+    }
+    for (auto& thread : churners) {
+        thread.join();
+    }
+
+    uint64_t expected = uint64_t(invokerThreads) * invokesPerThread;
+    std::cout << expected << " invokes, " << churnThreads * subscriptionsPerThread << " subscriptions churned, "
+              << churnCalls.load() << " churned callbacks run, " << nestedSubscriptions.load()
+              << " subscriptions made from inside a callback" << std::endl;
+    CHECK(permanentCalls.load() == expected);
+    CHECK(lateCalls.load() == 0);
+    CHECK(nestedSubscriptions.load() == uint64_t(invokerThreads) * (invokesPerThread / 5000));
+
+    // Only the two long-lived subscribers are left
+    CHECK(event.subscriberCount() == 2);
+    permanent.unsubscribe();
+    nested.unsubscribe();
+    CHECK(event.subscriberCount() == 0);
+    event.invoke(0);
+    CHECK(permanentCalls.load() == expected);
+
+    return testResult();
+}
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <string>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include "../../Events/EventManager.h"
+#include "../Modules/CommandScheduler.h"
+
+// Replays an event journal recorded by base into the command pipeline without a vehicle or
+// ground station attached. Commands go through the CommandScheduler as in flight, but the
+// handler only counts them, so lane latencies reflect the pipeline and not MAVSDK.
+
+void usage(const std::string& bin_name) {
+    std::cerr << "Usage : " << bin_name << " <journal> [--fast]\n"
+              << "Replays at the recorded pace unless --fast is given.\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3 || (argc == 3 && std::string(argv[2]) != "--fast")) {
+        usage(argv[0]);
+        return 1;
+    }
+    auto speed = argc == 3 ? EventManager::ReplaySpeed::AsFastAsPossible : EventManager::ReplaySpeed::RealTime;
+
+    CREATE_EVENT("send_ack", const std::string & command);
+    CREATE_EVENT("InfoRequest");
+    CREATE_EVENT("set_brightness");
+    CREATE_EVENT("command_received", CommandId command, const std::vector<double> & parameters, uint32_t client);
+
+    std::mutex counts_mutex;
+    std::map<std::string_view, size_t> command_counts;
+    auto command_scheduler = std::make_shared<CommandScheduler>([&](CommandId command, const std::vector<double>&) {
+        std::lock_guard<std::mutex> lock(counts_mutex);
+        ++command_counts[commandName(command)];
+    });
+    command_scheduler->start();
+
+    SUBSCRIBE_TO_EVENT("command_received", [command_scheduler](CommandId command, const std::vector<double>& parameters, uint32_t client) {
+        command_scheduler->submit(command, parameters, client);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    size_t replayed = GetEventManager().replayJournal(argv[1], speed);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    // Let both lanes drain before reading their stats.
+    while (command_scheduler->getLaneStats(CommandScheduler::Lane::Express).dispatch.queueDepth > 0 ||
+           command_scheduler->getLaneStats(CommandScheduler::Lane::Bulk).dispatch.queueDepth > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    command_scheduler->stop();
+
+    std::cout << "Replayed " << replayed << " events in " << elapsed.count() << " ms\n";
+    for (auto& [command, count] : command_counts) {
+        std::cout << "  " << command << ": " << count << "\n";
+    }
+    const char* lane_names[] = {"express", "bulk"};
+    for (auto lane : {CommandScheduler::Lane::Express, CommandScheduler::Lane::Bulk}) {
+        auto stats = command_scheduler->getLaneStats(lane);
+        std::cout << "[scheduler] " << lane_names[static_cast<int>(lane)] << " dispatched=" << stats.dispatch.dispatched
+                  << " coalesced=" << stats.dispatch.coalesced << " avg_wait=" << stats.dispatch.averageLatencyUs
+                  << "us max_wait=" << stats.dispatch.maxLatencyUs << "us budget_misses=" << stats.budgetMisses << "\n";
+    }
+    GetEventManager().dumpMetrics(std::cout);
+    return 0;
+}
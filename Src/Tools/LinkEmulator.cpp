@@ -0,0 +1,149 @@
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <queue>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+
+// Lossy, delayed UDP link between a ground station and a UDPServer, for exercising the
+// CommunicationManager probes and failover on one machine. The ground station sends to
+// listen_port; datagrams go on to the server at target_port on loopback and replies come back to
+// the last ground station address. Loss and delay apply in both directions and can be changed
+// while running by typing "loss <percent>", "delay <ms>", "down" or "up" on stdin. Probing is off
+// by default, so set ProbeIntervalMs in [Links] and have the ground station answer the pings.
+
+using Clock = std::chrono::steady_clock;
+
+void usage(const std::string& bin_name) {
+    std::cerr << "Usage : " << bin_name << " <listen_port> <target_port> [loss_percent] [delay_ms]\n";
+}
+
+struct Pending {
+    Clock::time_point due;
+    int fd;
+    sockaddr_in to;
+    std::string payload;
+
+    bool operator>(const Pending& other) const { return due > other.due; }
+};
+
+int openSocket(int port) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        std::cerr << "Error creating socket: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "Error binding port " << port << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3 || argc > 5) {
+        usage(argv[0]);
+        return 1;
+    }
+    int listenPort = std::atoi(argv[1]);
+    int targetPort = std::atoi(argv[2]);
+    std::atomic<int> lossPercent{argc > 3 ? std::atoi(argv[3]) : 0};
+    std::atomic<int> delayMs{argc > 4 ? std::atoi(argv[4]) : 0};
+    std::atomic<bool> down{false};
+
+    int groundFd = openSocket(listenPort);
+    int serverFd = openSocket(0);
+    if (groundFd < 0 || serverFd < 0) {
+        return 1;
+    }
+    sockaddr_in server{};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(targetPort);
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::thread control([&]() {
+        std::string command;
+        int value;
+        while (std::cin >> command) {
+            if (command == "loss" && std::cin >> value) {
+                lossPercent = value;
+            } else if (command == "delay" && std::cin >> value) {
+                delayMs = value;
+            } else if (command == "down") {
+                down = true;
+            } else if (command == "up") {
+                down = false;
+            } else {
+                std::cerr << "Unknown command: " << command << std::endl;
+                continue;
+            }
+            std::cerr << "link " << listenPort << ": loss=" << lossPercent << "% delay=" << delayMs
+                      << "ms " << (down ? "down" : "up") << std::endl;
+        }
+    });
+    control.detach();
+
+    std::mt19937 random(std::random_device{}());
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> pending;
+    sockaddr_in ground{};
+    bool haveGround = false;
+    std::vector<char> buffer(65536);
+
+    pollfd fds[2] = {{groundFd, POLLIN, 0}, {serverFd, POLLIN, 0}};
+    while (true) {
+        int timeout = -1;
+        if (!pending.empty()) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(pending.top().due - Clock::now()).count();
+            timeout = static_cast<int>(std::max<int64_t>(wait, 0));
+        }
+        if (poll(fds, 2, timeout) < 0 && errno != EINTR) {
+            std::cerr << "poll failed: " << strerror(errno) << std::endl;
+            return 1;
+        }
+
+        for (int i = 0; i < 2; ++i) {
+            if (!(fds[i].revents & POLLIN)) {
+                continue;
+            }
+            sockaddr_in from{};
+            socklen_t fromLength = sizeof(from);
+            ssize_t received = recvfrom(fds[i].fd, buffer.data(), buffer.size(), 0, reinterpret_cast<sockaddr*>(&from), &fromLength);
+            if (received < 0) {
+                continue;
+            }
+            if (i == 0) {
+                ground = from;
+                haveGround = true;
+            } else if (!haveGround) {
+                continue;
+            }
+            if (down || percent(random) < lossPercent) {
+                continue;
+            }
+            pending.push({Clock::now() + std::chrono::milliseconds(delayMs), i == 0 ? serverFd : groundFd,
+                          i == 0 ? server : ground, std::string(buffer.data(), received)});
+        }
+
+        auto now = Clock::now();
+        while (!pending.empty() && pending.top().due <= now) {
+            const Pending& next = pending.top();
+            sendto(next.fd, next.payload.data(), next.payload.size(), 0,
+                   reinterpret_cast<const sockaddr*>(&next.to), sizeof(next.to));
+            pending.pop();
+        }
+    }
+}
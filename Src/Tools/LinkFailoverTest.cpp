@@ -0,0 +1,283 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <csignal>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include "../Modules/CommunicationManager.h"
+#include "TestCheck.h"
+
+// CommunicationManager with probing on and two UDP links, each behind a link_emulator, and a
+// ground station that answers every ping. Delay on one link moves bulk traffic to the other while
+// its smoothed RTT climbs towards the new round trip; a link only 10% better does not take bulk
+// back; loss shows up in the link's loss figure; and blacking out the active link fails bulk
+// traffic over within FailoverMs plus one probe interval.
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+const int ProbeIntervalMs = 50;
+const int FailoverMs = 300;
+
+void usage(const std::string& bin_name) {
+    std::cerr << "Usage : " << bin_name << " <link_emulator> [first_port]\n"
+              << "Uses four ports from first_port, 9892 by default.\n";
+}
+
+bool waitFor(const std::function<bool()>& done, std::chrono::milliseconds timeout) {
+    auto deadline = Clock::now() + timeout;
+    while (!done()) {
+        if (Clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// A link_emulator child driven through its stdin; it dies with the test
+class Emulator {
+public:
+    Emulator(const std::string& binary, int listenPort, int targetPort) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            return;
+        }
+        pid = fork();
+        if (pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            dup2(fds[0], STDIN_FILENO);
+            close(fds[0]);
+            close(fds[1]);
+            std::string listen = std::to_string(listenPort);
+            std::string target = std::to_string(targetPort);
+            execl(binary.c_str(), binary.c_str(), listen.c_str(), target.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        close(fds[0]);
+        control = fds[1];
+    }
+    Emulator(const Emulator&) = delete;
+    Emulator& operator=(const Emulator&) = delete;
+
+    ~Emulator() {
+        if (pid > 0) {
+            kill(pid, SIGTERM);
+            waitpid(pid, nullptr, 0);
+        }
+        if (control >= 0) {
+            close(control);
+        }
+    }
+
+    bool running() const { return pid > 0 && waitpid(pid, nullptr, WNOHANG) == 0; }
+
+    void command(const std::string& line) {
+        std::string text = line + "\n";
+        CHECK(write(control, text.data(), text.size()) == static_cast<ssize_t>(text.size()));
+    }
+
+private:
+    pid_t pid = -1;
+    int control = -1;
+};
+
+// One socket per link, each talking to that link's emulator. Answers every ping on the link it
+// arrived on and notes when bulk traffic first reaches each link.
+class GroundStation {
+public:
+    explicit GroundStation(const int emulatorPorts[2]) {
+        for (int link = 0; link < 2; ++link) {
+            fds[link] = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+            sockaddr_in local{};
+            local.sin_family = AF_INET;
+            local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            bind(fds[link], reinterpret_cast<sockaddr*>(&local), sizeof(local));
+            emulators[link].sin_family = AF_INET;
+            emulators[link].sin_port = htons(emulatorPorts[link]);
+            emulators[link].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        }
+        thread = std::thread(&GroundStation::run, this);
+    }
+
+    ~GroundStation() {
+        running = false;
+        thread.join();
+        for (int fd : fds) {
+            close(fd);
+        }
+    }
+
+    bool pinged(int link) const { return pings[link].load() > 0; }
+    // Steady clock nanoseconds of the first bulk message on the link, 0 before it
+    int64_t firstBulkNs(int link) const { return firstBulk[link].load(); }
+
+private:
+    int fds[2];
+    sockaddr_in emulators[2]{};
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> pings[2]{};
+    std::atomic<int64_t> firstBulk[2]{};
+    std::thread thread;
+
+    void send(int link, const std::string& message) {
+        sendto(fds[link], message.data(), message.size(), 0, reinterpret_cast<const sockaddr*>(&emulators[link]),
+               sizeof(emulators[link]));
+    }
+
+    void run() {
+        pollfd polled[2] = {{fds[0], POLLIN, 0}, {fds[1], POLLIN, 0}};
+        auto lastHello = Clock::time_point();
+        char buffer[2048];
+        while (running) {
+            // UDPServer only sends to clients it has heard from, and the emulators may still be
+            // starting, so say something harmless on each link until its pings arrive
+            if (Clock::now() - lastHello > std::chrono::milliseconds(100)) {
+                lastHello = Clock::now();
+                for (int link = 0; link < 2; ++link) {
+                    if (!pinged(link)) {
+                        send(link, "hold:\n");
+                    }
+                }
+            }
+            if (poll(polled, 2, 20) <= 0) {
+                continue;
+            }
+            for (int link = 0; link < 2; ++link) {
+                if (!(polled[link].revents & POLLIN)) {
+                    continue;
+                }
+                ssize_t n = recv(fds[link], buffer, sizeof(buffer), 0);
+                if (n <= 0) {
+                    continue;
+                }
+                std::string message(buffer, n);
+                if (message.compare(0, 5, "ping:") == 0) {
+                    ++pings[link];
+                    send(link, "pong:" + message.substr(5) + "\n");
+                } else if (message.compare(0, 5, "bulk:") == 0 && firstBulk[link].load() == 0) {
+                    firstBulk[link] = Clock::now().time_since_epoch().count();
+                }
+            }
+        }
+    }
+};
+
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::string emulatorBinary = argv[1];
+    int firstPort = argc > 2 ? std::stoi(argv[2]) : 9892;
+    const int serverPorts[2] = {firstPort, firstPort + 1};
+    const int emulatorPorts[2] = {firstPort + 2, firstPort + 3};
+
+    // CommunicationManager reads INI files only
+    std::string configPath = "/tmp/link_failover_test_" + std::to_string(getpid()) + ".ini";
+    std::ofstream(configPath) << "[Links]\nTransports=udp:" << serverPorts[0] << ",udp:" << serverPorts[1]
+                              << "\nProbeIntervalMs=" << ProbeIntervalMs << "\nFailoverMs=" << FailoverMs << "\n";
+    CommunicationManager manager{INIReader(configPath)};
+    std::remove(configPath.c_str());
+    CHECK(manager.getLinkStats().size() == 2);
+
+    Emulator emulators[2] = {{emulatorBinary, emulatorPorts[0], serverPorts[0]},
+                             {emulatorBinary, emulatorPorts[1], serverPorts[1]}};
+    manager.start();
+    GroundStation ground(emulatorPorts);
+    CHECK(waitFor([&]() { return ground.pinged(0) && ground.pinged(1); }, std::chrono::milliseconds(3000)));
+    CHECK(emulators[0].running() && emulators[1].running());
+    if (testFailures() > 0) {
+        std::cerr << "The ground station never got pings through " << emulatorBinary << std::endl;
+        manager.stop();
+        return testResult();
+    }
+    auto link = [&manager](int index) { return manager.getLinkStats()[index]; };
+    CHECK(link(0).active);
+
+    // 40 ms each way on the active link: bulk moves to the other one within a few pongs, long
+    // before the smoothed RTT settles near the 80 ms round trip
+    auto start = Clock::now();
+    emulators[0].command("delay 40");
+    CHECK(waitFor([&]() { return link(1).active; }, std::chrono::milliseconds(3000)));
+    std::cout << "Bulk moved off the delayed link after " << millisecondsSince(start) << " ms, its RTT at "
+              << link(0).rttMs << " ms" << std::endl;
+    CHECK(link(0).rttMs < 60);
+    CHECK(waitFor([&]() { return link(0).rttMs >= 70; }, std::chrono::milliseconds(3000)));
+    CHECK(link(0).rttMs < 100);
+    CHECK(link(1).rttMs < 20);
+    CHECK(manager.getFailoverCount() == 0);
+
+    // The active link slows to a 90 ms round trip, leaving the other about 10% better: inside
+    // the 20% hysteresis, so bulk stays put while the RTT climbs
+    emulators[1].command("delay 45");
+    bool moved = false;
+    CHECK(waitFor([&]() {
+        moved = moved || !link(1).active;
+        return link(1).rttMs >= 80;
+    }, std::chrono::milliseconds(4000)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10 * ProbeIntervalMs));
+    CHECK(!moved && link(1).active);
+    std::cout << "Round trips with 40 and 45 ms delays: " << link(0).rttMs << " and " << link(1).rttMs << " ms"
+              << std::endl;
+
+    // At half the other's round trip the first link wins bulk back
+    emulators[0].command("delay 20");
+    CHECK(waitFor([&]() { return link(0).active; }, std::chrono::milliseconds(3000)));
+    CHECK(manager.getFailoverCount() == 0);
+
+    // 20% loss each way on the idle link loses about 36% of its probes; the other loses none
+    emulators[1].command("loss 20");
+    std::this_thread::sleep_for(std::chrono::milliseconds(40 * ProbeIntervalMs + FailoverMs));
+    CommunicationManager::LinkStats lossy = link(1);
+    std::cout << "Probe loss with 20% loss each way: " << lossy.loss * 100 << "% (" << lossy.pongs << " pongs to "
+              << lossy.probes << " probes)" << std::endl;
+    CHECK(lossy.loss > 0.1 && lossy.loss < 0.7);
+    CHECK(lossy.pongs < lossy.probes);
+    CHECK(link(0).loss == 0);
+    CHECK(link(0).active);
+    emulators[1].command("loss 0");
+    CHECK(waitFor([&]() { return link(1).up; }, std::chrono::milliseconds(2000)));
+
+    // Black out the active link under a stream of bulk traffic. A pong already on its way can
+    // still land up to one round trip later, and the new link adds its own delay on the way out.
+    uint64_t failovers = manager.getFailoverCount();
+    start = Clock::now();
+    emulators[0].command("down");
+    size_t sent = 0;
+    waitFor([&]() {
+        manager.route_message("bulk:" + std::to_string(sent++), CommunicationManager::Traffic::Bulk);
+        std::this_thread::sleep_for(std::chrono::milliseconds(4));
+        return ground.firstBulkNs(1) != 0;
+    }, std::chrono::milliseconds(3000));
+    CHECK(ground.firstBulkNs(1) != 0);
+    double movedMs = std::chrono::duration<double, std::milli>(
+            Clock::duration(ground.firstBulkNs(1)) - start.time_since_epoch()).count();
+    double budgetMs = FailoverMs + ProbeIntervalMs + 2 * 20 + 45 + 100;
+    std::cout << "Bulk traffic reached the other link " << movedMs << " ms after the blackout, budget "
+              << budgetMs << " ms" << std::endl;
+    CHECK(movedMs > FailoverMs - ProbeIntervalMs);
+    CHECK(movedMs < budgetMs);
+    CHECK(manager.getFailoverCount() == failovers + 1);
+    CHECK(!link(0).up && !link(0).active);
+    CHECK(link(1).active);
+
+    manager.stop();
+    return testResult();
+}
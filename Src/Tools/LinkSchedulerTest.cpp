@@ -0,0 +1,202 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cmath>
+#include <unistd.h>
+#include "../Modules/CommunicationManager.h"
+#include "TestCheck.h"
+
+// The per-link sender of CommunicationManager against a transport that only records what it is
+// handed: the three class queues filled up front, drained by deficit round robin in the ratio of
+// ClassWeights, and through a token bucket at a known rate that lets BurstMs of traffic pass at
+// once and holds the rest to the rate. Also a quantum smaller than the messages, which must still
+// be credited turn after turn until it covers one.
+
+using Clock = std::chrono::steady_clock;
+using Traffic = CommunicationManager::Traffic;
+
+namespace {
+
+class RecordingTransport : public ICommunication {
+public:
+    struct Sent {
+        Traffic traffic;
+        size_t size;
+        Clock::time_point at;
+    };
+
+    bool start() override { return true; }
+    void stop() override {}
+    bool send_message(const std::string& message) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        sent.push_back({static_cast<Traffic>(message[0] - '0'), message.size(), Clock::now()});
+        return true;
+    }
+
+    std::vector<Sent> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sent;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<Sent> sent;
+};
+
+// CommunicationManager reads INI files only; this one lives for the scope of the test
+struct Config {
+    std::string path = "/tmp/link_scheduler_test_" + std::to_string(getpid()) + ".ini";
+
+    explicit Config(const std::string& links) {
+        std::ofstream(path) << "[Links]\nTransports=\nQueueMessages=1000\n" << links;
+    }
+    ~Config() { std::remove(path.c_str()); }
+};
+
+bool waitFor(const std::function<bool()>& done, std::chrono::seconds timeout) {
+    auto deadline = Clock::now() + timeout;
+    while (!done()) {
+        if (Clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Messages carry their class in the first byte so the transport can tell them apart
+void fill(CommunicationManager& manager, size_t perClass, size_t size) {
+    for (size_t i = 0; i < perClass; ++i) {
+        for (size_t trafficClass = 0; trafficClass < CommunicationManager::TrafficClasses; ++trafficClass) {
+            manager.send_message_by_index(0, std::string(size, static_cast<char>('0' + trafficClass)),
+                                          static_cast<Traffic>(trafficClass));
+        }
+    }
+}
+
+uint64_t totalBytes(const CommunicationManager::LinkStats& stats) {
+    uint64_t bytes = 0;
+    for (const auto& counters : stats.classes) {
+        bytes += counters.bytes;
+    }
+    return bytes;
+}
+
+void testShaping() {
+    const double rate = 200000;
+    const double burst = rate * 0.1;
+    const size_t size = 200;
+    const size_t perClass = 300;
+    const int64_t quantum[] = {8 * 512, 3 * 512, 512};
+
+    Config config("BurstMs=100\nQuantumBytes=512\nClassWeights=8,3,1\n");
+    CommunicationManager manager{INIReader(config.path)};
+    auto transport = std::make_shared<RecordingTransport>();
+    manager.add_link("recorder", transport, rate);
+    fill(manager, perClass, size);
+    CHECK(manager.getLinkStats()[0].depth == 3 * perClass);
+
+    auto start = Clock::now();
+    manager.start();
+
+    // Halfway to the point where control runs dry, every class is still backlogged and each has
+    // had its weight's share of the bytes, give or take one quantum and the message that overran it
+    CommunicationManager::LinkStats stats;
+    CHECK(waitFor([&]() {
+        stats = manager.getLinkStats()[0];
+        return totalBytes(stats) >= 45000;
+    }, std::chrono::seconds(5)));
+    uint64_t sampled = totalBytes(stats);
+    std::cout << "After " << sampled << " bytes: control=" << stats.classes[0].bytes
+              << " telemetry=" << stats.classes[1].bytes << " bulk=" << stats.classes[2].bytes << std::endl;
+    for (size_t trafficClass = 0; trafficClass < CommunicationManager::TrafficClasses; ++trafficClass) {
+        CHECK(stats.classes[trafficClass].depth > 0);
+        double share = sampled * quantum[trafficClass] / 6144.0;
+        CHECK(std::abs(static_cast<double>(stats.classes[trafficClass].bytes) - share) <= quantum[trafficClass] + size);
+    }
+
+    CHECK(waitFor([&]() { return manager.getLinkStats()[0].depth == 0; }, std::chrono::seconds(10)));
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    manager.stop();
+
+    stats = manager.getLinkStats()[0];
+    uint64_t total = 3 * perClass * size;
+    uint64_t shaped = 0;
+    for (const auto& counters : stats.classes) {
+        CHECK(counters.sent == perClass);
+        CHECK(counters.bytes == perClass * size);
+        CHECK(counters.shapedBytes <= counters.bytes);
+        CHECK(counters.droppedBytes == 0);
+        shaped += counters.shapedBytes;
+    }
+    CHECK(stats.sent == 3 * perClass);
+    CHECK(stats.rateBytes == static_cast<uint64_t>(rate));
+
+    // The full bucket goes out unshaped, and after that nearly every message waited for tokens;
+    // one goes out unshaped only when the sender overslept its wait by more than a message
+    std::cout << total << " bytes in " << seconds * 1000 << " ms at " << static_cast<uint64_t>(rate)
+              << " B/s, " << shaped << " bytes shaped" << std::endl;
+    CHECK(shaped <= total - burst);
+    CHECK(shaped >= total - 3 * burst);
+
+    // No stretch of the run beats the bucket: its burst, the refill over the stretch and the one
+    // message it may go into debt for, with room for the sender's clock read and hand-off. The run
+    // as a whole keeps up with the rate.
+    std::vector<RecordingTransport::Sent> sent = transport->snapshot();
+    CHECK(sent.size() == 3 * perClass);
+    size_t overruns = 0;
+    for (size_t first = 0; first < sent.size(); ++first) {
+        double bytes = 0;
+        for (size_t last = first; last < sent.size(); ++last) {
+            bytes += sent[last].size;
+            double elapsed = std::chrono::duration<double>(sent[last].at - sent[first].at).count();
+            overruns += bytes > burst + rate * (elapsed + 0.01) + size;
+        }
+    }
+    CHECK(overruns == 0);
+    CHECK(seconds < (total - burst) / rate * 1.5 + 0.2);
+}
+
+void testSmallQuantum() {
+    // Every quantum is below the message size: control needs more than one turn per message, bulk ten
+    const size_t size = 1000;
+    Config config("QuantumBytes=100\nClassWeights=8,3,1\n");
+    CommunicationManager manager{INIReader(config.path)};
+    auto transport = std::make_shared<RecordingTransport>();
+    manager.add_link("recorder", transport);
+    fill(manager, 300, size);
+    manager.start();
+    CHECK(waitFor([&]() { return manager.getLinkStats()[0].depth == 0; }, std::chrono::seconds(10)));
+    manager.stop();
+
+    CHECK(manager.getLinkStats()[0].sent == 900);
+    CHECK(manager.getLinkStats()[0].classes[2].shapedBytes == 0);
+
+    // The first 240 messages leave while every class is backlogged, in the ratio 8:3:1
+    std::vector<RecordingTransport::Sent> sent = transport->snapshot();
+    CHECK(sent.size() == 900);
+    size_t counts[CommunicationManager::TrafficClasses] = {};
+    for (size_t i = 0; i < 240 && i < sent.size(); ++i) {
+        ++counts[static_cast<size_t>(sent[i].traffic)];
+    }
+    std::cout << "First 240 messages: control=" << counts[0] << " telemetry=" << counts[1] << " bulk=" << counts[2]
+              << std::endl;
+    CHECK(counts[0] >= 158 && counts[0] <= 162);
+    CHECK(counts[1] >= 58 && counts[1] <= 62);
+    CHECK(counts[2] >= 18 && counts[2] <= 22);
+}
+
+}
+
+int main() {
+    testShaping();
+    testSmallQuantum();
+    return testResult();
+}
@@ -0,0 +1,212 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <pty.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+#include "../../Events/EventChannels.h"
+#include "../Communications/SerialCommunication.h"
+#include "../Communications/SlipFraming.h"
+#include "TestCheck.h"
+
+// SLIP framing on its own, then SerialCommunication on a pseudo-terminal standing in for the
+// radio: packets with escaped bytes, packets split across reads, replies written back to the
+// port, and stop() returning at once while the reader is parked in epoll with nothing to read.
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+std::mutex receivedMutex;
+std::condition_variable receivedCondition;
+std::vector<std::vector<double>> received;
+
+bool waitForCommands(size_t count) {
+    std::unique_lock<std::mutex> lock(receivedMutex);
+    return receivedCondition.wait_for(lock, std::chrono::seconds(2), [count] { return received.size() >= count; });
+}
+
+void clearReceived() {
+    std::lock_guard<std::mutex> lock(receivedMutex);
+    received.clear();
+}
+
+std::string slipPacket(std::string_view payload) {
+    std::string packet;
+    Slip::encodePacket(packet, payload);
+    return packet;
+}
+
+// Once binary, the session reads text messages only from Text frames
+std::string textFrame(std::string_view message) {
+    std::string frame;
+    BinaryProtocol::encodeFrame(frame, BinaryProtocol::MessageId::Text, message);
+    return frame;
+}
+
+bool writeAll(int fd, std::string_view bytes) {
+    while (!bytes.empty()) {
+        ssize_t n = write(fd, bytes.data(), bytes.size());
+        if (n < 0) {
+            return false;
+        }
+        bytes.remove_prefix(n);
+    }
+    return true;
+}
+
+void testSlipEscaping() {
+    // Every byte value, End and Esc included, runs of them, and an empty payload
+    std::string payload;
+    for (int i = 0; i < 256; ++i) {
+        payload.push_back(static_cast<char>(i));
+    }
+    payload += std::string(3, static_cast<char>(Slip::End)) + std::string(3, static_cast<char>(Slip::Esc));
+
+    std::string encoded = slipPacket(payload) + slipPacket("");
+    // End appears only as a delimiter
+    size_t ends = 0;
+    for (char c : encoded) {
+        ends += static_cast<uint8_t>(c) == Slip::End;
+    }
+    CHECK(ends == 4);
+
+    std::vector<std::string> packets;
+    Slip::Decoder decoder(1024);
+    decoder.feed(encoded, [&](std::string_view packet) { packets.emplace_back(packet); });
+    CHECK(packets.size() == 2);
+    CHECK(packets.size() == 2 && packets[0] == payload && packets[1].empty());
+    CHECK(decoder.droppedCount() == 0);
+
+    // Split after every byte, including between Esc and the byte it escapes
+    for (size_t split = 1; split < encoded.size(); ++split) {
+        packets.clear();
+        Slip::Decoder splitDecoder(1024);
+        auto collect = [&](std::string_view packet) { packets.emplace_back(packet); };
+        splitDecoder.feed(std::string_view(encoded).substr(0, split), collect);
+        splitDecoder.feed(std::string_view(encoded).substr(split), collect);
+        CHECK(packets.size() == 2 && packets[0] == payload);
+    }
+
+    // A flipped bit fails the CRC, a bad escape and an oversized packet are dropped, and the
+    // decoder picks up again at the next End
+    std::string corrupted = slipPacket("land:\n");
+    corrupted[2] ^= 0x01;
+    std::string badEscape = std::string(1, static_cast<char>(Slip::End)) + "ab" + static_cast<char>(Slip::Esc) + "x" +
+                            static_cast<char>(Slip::End);
+    packets.clear();
+    Slip::Decoder noisyDecoder(16);
+    noisyDecoder.feed(corrupted + badEscape + slipPacket(std::string(17, 'x')) + slipPacket("hold:\n"),
+                      [&](std::string_view packet) { packets.emplace_back(packet); });
+    CHECK(packets.size() == 1 && packets[0] == "hold:\n");
+    CHECK(noisyDecoder.droppedCount() == 3);
+}
+
+void testSerialPort() {
+    int master = -1;
+    int slave = -1;
+    char name[128];
+    termios raw{};
+    cfmakeraw(&raw);
+    if (openpty(&master, &slave, name, &raw, nullptr) != 0) {
+        std::cerr << "openpty failed, skipping the serial port checks" << std::endl;
+        ++testFailures();
+        return;
+    }
+
+    {
+        SerialCommunication serial(name, 115200);
+        CHECK(serial.start());
+
+        // A binary fly_to whose latitude is -2.0: its bytes include End and the frame needs escaping
+        const BinaryProtocol::Field fields[] = {
+            {BinaryProtocol::FieldType::Float64, -2.0},
+            {BinaryProtocol::FieldType::Float64, 8.545594},
+            {BinaryProtocol::FieldType::Float32, 30},
+        };
+        std::string frame;
+        BinaryProtocol::encodeCommand(frame, CommandId::FlyTo, fields, std::size(fields));
+        CHECK(frame.find(static_cast<char>(Slip::End)) != std::string::npos);
+
+        clearReceived();
+        CHECK(writeAll(master, slipPacket(frame)));
+        CHECK(waitForCommands(1));
+
+        // One packet over three reads, split inside an escape sequence
+        std::string packet = slipPacket(frame);
+        size_t escape = packet.find(static_cast<char>(Slip::Esc));
+        CHECK(escape != std::string::npos);
+        clearReceived();
+        CHECK(writeAll(master, std::string_view(packet).substr(0, escape + 1)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(writeAll(master, std::string_view(packet).substr(escape + 1, 3)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        {
+            std::lock_guard<std::mutex> lock(receivedMutex);
+            CHECK(received.empty());
+        }
+        CHECK(writeAll(master, packet.substr(escape + 4) + slipPacket(textFrame("hold:\n"))));
+        CHECK(waitForCommands(2));
+        {
+            std::lock_guard<std::mutex> lock(receivedMutex);
+            CHECK(received.size() == 2 && received[0] == std::vector<double>({-2.0, 8.545594, 30}));
+        }
+
+        // Outgoing messages leave as SLIP packets, framed for the peer that went binary
+        CHECK(serial.send_message("status:ok\n"));
+        std::vector<std::string> packets;
+        Slip::Decoder decoder(4096);
+        auto deadline = Clock::now() + std::chrono::seconds(2);
+        while (packets.empty() && Clock::now() < deadline) {
+            pollfd fd{master, POLLIN, 0};
+            if (poll(&fd, 1, 100) > 0) {
+                char buffer[256];
+                ssize_t n = read(master, buffer, sizeof(buffer));
+                if (n > 0) {
+                    decoder.feed(std::string_view(buffer, n), [&](std::string_view p) { packets.emplace_back(p); });
+                }
+            }
+        }
+        BinaryProtocol::Frame reply;
+        CHECK(packets.size() == 1);
+        CHECK(!packets.empty() && BinaryProtocol::decodeFrame(packets[0], reply).status == BinaryProtocol::FrameStatus::Ok);
+        CHECK(!packets.empty() && reply.payload == "status:ok\n");
+
+        // The reader is parked in epoll_wait with no timeout; only the eventfd can wake it
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto start = Clock::now();
+        serial.stop();
+        auto stopMs = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+        std::cout << "stop() took " << stopMs << " ms" << std::endl;
+        CHECK(stopMs < 100);
+
+        // Restartable after stop(), and stop() again from the destructor
+        CHECK(serial.start());
+        clearReceived();
+        CHECK(writeAll(master, slipPacket(textFrame("land:\n"))));
+        CHECK(waitForCommands(1));
+    }
+    close(slave);
+    close(master);
+}
+
+}
+
+int main() {
+    auto subscription = GetEventChannel<CommandReceivedEvent>().subscribe(
+            [](CommandId, const std::vector<double>& parameters, uint32_t) {
+                std::lock_guard<std::mutex> lock(receivedMutex);
+                received.push_back(parameters);
+                receivedCondition.notify_all();
+            });
+
+    testSlipEscaping();
+    testSerialPort();
+    return testResult();
+}
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include "../Communications/SharedMemoryChannel.h"
+#include "TestCheck.h"
+
+// SharedMemoryRing over an ordinary buffer: messages across the wrap, then the consumer facing
+// positions and lengths a misbehaving peer wrote into the mapping. Each corruption must be
+// rejected without reading outside the data area, must empty the ring, and must leave it usable.
+
+namespace {
+
+const size_t capacity = 4096;
+
+struct Ring {
+    SharedMemoryRing::Header header{};
+    std::vector<char> data = std::vector<char>(capacity);
+    SharedMemoryRing ring{&header, data.data(), capacity};
+
+    uint64_t head() const { return header.head.load(); }
+    uint64_t tail() const { return header.tail.load(); }
+
+    void writeLength(uint64_t position, uint32_t length) {
+        std::memcpy(data.data() + (position & (capacity - 1)), &length, sizeof(length));
+    }
+
+    // The ring is empty and still carries messages
+    bool recovered() {
+        std::string message;
+        if (ring.pop(message) || head() != tail()) {
+            return false;
+        }
+        return ring.push("land:\n") && ring.pop(message) && message == "land:\n" && !ring.pop(message);
+    }
+};
+
+void testWrap() {
+    Ring ring;
+    std::string message;
+    // Messages of changing sizes walk the positions across the end of the data area many times
+    for (size_t i = 0; i < 2000; ++i) {
+        std::string sent(1 + (i * 37) % 700, static_cast<char>('a' + i % 26));
+        CHECK(ring.ring.push(sent));
+        CHECK(ring.ring.pop(message));
+        CHECK(message == sent);
+    }
+    CHECK(ring.tail() > 10 * capacity);
+    CHECK(!ring.ring.pop(message));
+
+    CHECK(ring.ring.push(std::string(SharedMemoryRing::maxMessage(capacity), 'x')));
+    CHECK(!ring.ring.push(std::string(SharedMemoryRing::maxMessage(capacity) + 1, 'x')));
+    CHECK(ring.ring.pop(message) && message.size() == SharedMemoryRing::maxMessage(capacity));
+}
+
+void testCorruptLength() {
+    // Longer than any message
+    Ring ring;
+    CHECK(ring.ring.push("hold:\n"));
+    ring.writeLength(ring.head(), 0x7FFFFFFF);
+    std::string message;
+    CHECK(!ring.ring.pop(message));
+    CHECK(ring.recovered());
+
+    // Within maxMessage, but running past the end of the data area
+    Ring nearEnd;
+    nearEnd.header.head = nearEnd.header.tail = capacity - 64;
+    CHECK(nearEnd.ring.push("hold:\n"));
+    CHECK(nearEnd.head() == capacity - 64);
+    nearEnd.writeLength(nearEnd.head(), 1000);
+    CHECK(!nearEnd.ring.pop(message));
+    CHECK(nearEnd.recovered());
+
+    // Within the data area, but longer than what the producer published
+    Ring beyondTail;
+    CHECK(beyondTail.ring.push("hold:\n"));
+    beyondTail.writeLength(beyondTail.head(), 200);
+    CHECK(!beyondTail.ring.pop(message));
+    CHECK(beyondTail.recovered());
+}
+
+void testCorruptPositions() {
+    std::string message;
+
+    // Tail more than the capacity ahead of head, and tail behind head
+    Ring ahead;
+    CHECK(ahead.ring.push("hold:\n"));
+    ahead.header.tail = ahead.head() + capacity + 8;
+    CHECK(!ahead.ring.pop(message));
+    CHECK(ahead.recovered());
+
+    Ring behind;
+    behind.header.head = 4096;
+    behind.header.tail = 1024;
+    CHECK(!behind.ring.pop(message));
+    CHECK(behind.head() == behind.tail());
+
+    // Head with no room for a record header before the end of the data area
+    Ring unaligned;
+    unaligned.header.head = capacity - 2;
+    unaligned.header.tail = capacity + 64;
+    CHECK(!unaligned.ring.pop(message));
+    CHECK(unaligned.head() == unaligned.tail());
+
+    // A wrap marker with nothing after it
+    Ring wrap;
+    wrap.header.head = wrap.header.tail = capacity - 64;
+    wrap.header.tail = capacity;
+    wrap.writeLength(capacity - 64, UINT32_MAX);
+    CHECK(!wrap.ring.pop(message));
+    CHECK(wrap.recovered());
+}
+
+}
+
+int main() {
+    testWrap();
+    testCorruptLength();
+    testCorruptPositions();
+    return testResult();
+}
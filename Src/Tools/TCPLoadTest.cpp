@@ -0,0 +1,294 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include "../../Events/EventChannels.h"
+#include "../Communications/TCPServer.h"
+#ifdef HAVE_IO_URING
+#include "../Communications/IoUring.h"
+#include "../Communications/IoUringTCPServer.h"
+#endif
+#include "TestCheck.h"
+
+// Hundreds of concurrent loopback connections against one TCP reactor. Every client sends a batch
+// of commands in two writes cut mid-line, then the server broadcasts to all of them, then they all
+// disconnect. Checks that each command arrives exactly once and in order under its own client id,
+// that every client gets every broadcast byte, that the server closes every connection, and that
+// the server's thread count does not grow with the number of clients.
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+void usage(const std::string& bin_name) {
+    std::cerr << "Usage : " << bin_name << " [epoll|io_uring] [port] [connections] [commands]\n"
+              << "Defaults to epoll, port 9890, 500 connections and 20 commands per connection.\n";
+}
+
+struct Server {
+    std::shared_ptr<ICommunication> transport;
+    std::function<size_t()> connectionCount;
+};
+
+Server makeServer(bool io_uring, int port) {
+#ifdef HAVE_IO_URING
+    if (io_uring) {
+        auto server = std::make_shared<IoUringTCPServer>(port);
+        return {server, [server]() { return server->getClientQueueStats().size(); }};
+    }
+#else
+    (void)io_uring;
+#endif
+    auto server = std::make_shared<TCPServer>(port);
+    return {server, [server]() { return server->getClientQueueStats().size(); }};
+}
+
+size_t threadCount() {
+    size_t count = 0;
+    if (DIR* tasks = opendir("/proc/self/task")) {
+        while (dirent* entry = readdir(tasks)) {
+            count += entry->d_name[0] != '.';
+        }
+        closedir(tasks);
+    }
+    return count;
+}
+
+bool waitFor(const std::function<bool()>& done, std::chrono::seconds timeout) {
+    auto deadline = Clock::now() + timeout;
+    while (!done()) {
+        if (Clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Commands seen per client id. A client's commands carry its index and a sequence number.
+struct ClientCommands {
+    double index = -1;
+    double lastSequence = -1;
+    size_t count = 0;
+    bool ordered = true;
+    bool sameIndex = true;
+};
+
+std::mutex commandsMutex;
+std::unordered_map<uint32_t, ClientCommands> commandsByClient;
+std::atomic<size_t> commandsReceived{0};
+
+}
+
+int main(int argc, char** argv) {
+    if (argc > 5) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::string backend = argc > 1 ? argv[1] : "epoll";
+    if (backend != "epoll" && backend != "io_uring") {
+        usage(argv[0]);
+        return 1;
+    }
+    int port = argc > 2 ? std::stoi(argv[2]) : 9890;
+    size_t connections = argc > 3 ? std::stoul(argv[3]) : 500;
+    size_t commands = argc > 4 ? std::stoul(argv[4]) : 20;
+#ifdef HAVE_IO_URING
+    if (backend == "io_uring" && !IoUring::supported()) {
+        std::cout << "io_uring is not available here, nothing to test" << std::endl;
+        return 0;
+    }
+#else
+    if (backend == "io_uring") {
+        std::cerr << "Built without io_uring support" << std::endl;
+        return 1;
+    }
+#endif
+
+    // Each connection takes a descriptor on both ends
+    rlimit files{};
+    getrlimit(RLIMIT_NOFILE, &files);
+    files.rlim_cur = files.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &files);
+    if (files.rlim_cur < 2 * connections + 64) {
+        connections = (files.rlim_cur - 64) / 2;
+        std::cout << "Open file limit allows " << connections << " connections" << std::endl;
+    }
+
+    CREATE_EVENT("send_ack", const std::string & command);
+    CREATE_EVENT("command_received", CommandId command, const std::vector<double> & parameters, uint32_t client);
+    auto subscription = GetEventChannel<CommandReceivedEvent>().subscribe(
+            [](CommandId, const std::vector<double>& parameters, uint32_t client) {
+                std::lock_guard<std::mutex> lock(commandsMutex);
+                ClientCommands& seen = commandsByClient[client];
+                if (seen.count == 0) {
+                    seen.index = parameters[0];
+                }
+                seen.sameIndex = seen.sameIndex && parameters[0] == seen.index;
+                seen.ordered = seen.ordered && parameters[1] == seen.lastSequence + 1;
+                seen.lastSequence = parameters[1];
+                ++seen.count;
+                commandsReceived.fetch_add(1, std::memory_order_relaxed);
+            });
+
+    Server server = makeServer(backend == "io_uring", port);
+    if (!server.transport->start()) {
+        std::cerr << "Server did not start" << std::endl;
+        return 1;
+    }
+    size_t serverThreads = threadCount();
+
+    // Connect
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    std::vector<int> clients;
+    auto start = Clock::now();
+    for (size_t i = 0; i < connections; ++i) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            std::cerr << "Client " << i << " could not connect: " << strerror(errno) << std::endl;
+            if (fd >= 0) {
+                close(fd);
+            }
+            break;
+        }
+        clients.push_back(fd);
+    }
+    CHECK(clients.size() == connections);
+    CHECK(waitFor([&]() { return server.connectionCount() == clients.size(); }, std::chrono::seconds(10)));
+    std::cout << clients.size() << " connections accepted in " << millisecondsSince(start) << " ms" << std::endl;
+
+    // Send: every client's batch goes out in two writes cut inside a line, all first halves
+    // before any second half, so the reactor sees partial messages on every connection at once
+    std::vector<std::string> batches(clients.size());
+    for (size_t i = 0; i < clients.size(); ++i) {
+        for (size_t sequence = 0; sequence < commands; ++sequence) {
+            batches[i] += "fly_to:" + std::to_string(i) + "," + std::to_string(sequence) + ",30\n";
+        }
+    }
+    start = Clock::now();
+    for (size_t i = 0; i < clients.size(); ++i) {
+        CHECK(writeAll(clients[i], batches[i].data(), batches[i].size() / 2));
+    }
+    for (size_t i = 0; i < clients.size(); ++i) {
+        size_t half = batches[i].size() / 2;
+        CHECK(writeAll(clients[i], batches[i].data() + half, batches[i].size() - half));
+    }
+    size_t expected = clients.size() * commands;
+    CHECK(waitFor([&]() { return commandsReceived.load() >= expected; }, std::chrono::seconds(20)));
+    double sendMs = millisecondsSince(start);
+    std::cout << commandsReceived.load() << " commands received in " << sendMs << " ms, "
+              << static_cast<uint64_t>(commandsReceived.load() / (sendMs / 1000.0)) << " commands/s" << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(commandsMutex);
+        CHECK(commandsReceived.load() == expected);
+        CHECK(commandsByClient.size() == clients.size());
+        size_t incomplete = 0;
+        size_t disordered = 0;
+        for (const auto& [client, seen] : commandsByClient) {
+            incomplete += seen.count != commands;
+            disordered += !seen.ordered || !seen.sameIndex;
+        }
+        CHECK(incomplete == 0);
+        CHECK(disordered == 0);
+    }
+
+    // Broadcast to every client and read it all back through one epoll
+    const size_t broadcasts = 20;
+    std::string expectedBytes;
+    for (size_t i = 0; i < broadcasts; ++i) {
+        expectedBytes += "status:" + std::to_string(i) + "\n";
+    }
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<size_t> receivedBytes(clients.size(), 0);
+    std::vector<bool> intact(clients.size(), true);
+    for (size_t i = 0; i < clients.size(); ++i) {
+        fcntl(clients[i], F_SETFL, fcntl(clients[i], F_GETFL) | O_NONBLOCK);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, clients[i], &event);
+    }
+    start = Clock::now();
+    for (size_t i = 0; i < broadcasts; ++i) {
+        CHECK(server.transport->send_message("status:" + std::to_string(i) + "\n"));
+    }
+    size_t complete = 0;
+    auto deadline = Clock::now() + std::chrono::seconds(20);
+    while (complete < clients.size() && Clock::now() < deadline) {
+        epoll_event events[64];
+        int ready = epoll_wait(epollFd, events, 64, 100);
+        for (int e = 0; e < ready; ++e) {
+            size_t i = events[e].data.u64;
+            char buffer[4096];
+            ssize_t n;
+            while ((n = read(clients[i], buffer, sizeof(buffer))) > 0) {
+                size_t offset = receivedBytes[i];
+                intact[i] = intact[i] && offset + n <= expectedBytes.size() &&
+                            expectedBytes.compare(offset, n, buffer, n) == 0;
+                receivedBytes[i] += n;
+                complete += receivedBytes[i] == expectedBytes.size() && offset < expectedBytes.size();
+            }
+        }
+    }
+    close(epollFd);
+    std::cout << broadcasts << " broadcasts reached " << complete << " clients in " << millisecondsSince(start)
+              << " ms" << std::endl;
+    CHECK(complete == clients.size());
+    size_t damaged = 0;
+    for (bool ok : intact) {
+        damaged += !ok;
+    }
+    CHECK(damaged == 0);
+
+    // The reactor serves every connection from the threads it started with
+    std::cout << "Server threads: " << serverThreads << " before connecting, " << threadCount() << " with "
+              << clients.size() << " clients" << std::endl;
+    CHECK(threadCount() == serverThreads);
+
+    // Disconnect
+    start = Clock::now();
+    for (int fd : clients) {
+        close(fd);
+    }
+    CHECK(waitFor([&]() { return server.connectionCount() == 0; }, std::chrono::seconds(10)));
+    std::cout << "All connections closed by the server in " << millisecondsSince(start) << " ms" << std::endl;
+
+    subscription.unsubscribe();
+    server.transport->stop();
+    return testResult();
+}
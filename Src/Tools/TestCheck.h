@@ -0,0 +1,31 @@
+#ifndef TESTCHECK_H
+#define TESTCHECK_H
+
+#include <iostream>
+
+// Assertions for the test executables registered with ctest. A failed CHECK is reported and
+// counted rather than aborting, so one run shows every failure; main returns testResult().
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline int testResult() {
+    if (testFailures() == 0) {
+        std::cout << "All checks passed" << std::endl;
+        return 0;
+    }
+    std::cerr << testFailures() << " check(s) failed" << std::endl;
+    return 1;
+}
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; \
+            ++testFailures(); \
+        } \
+    } while (0)
+
+#endif // TESTCHECK_H
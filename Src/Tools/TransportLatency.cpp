@@ -0,0 +1,279 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <ctime>
+#include <csignal>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "../../Events/EventChannels.h"
+#include "../Communications/UDPServer.h"
+#include "../Communications/TCPServer.h"
+#include "../Communications/UnixSocketServer.h"
+#include "../Communications/SharedMemoryTransport.h"
+#ifdef HAVE_IO_URING
+#include "../Communications/IoUring.h"
+#include "../Communications/IoUringUDPServer.h"
+#include "../Communications/IoUringTCPServer.h"
+#endif
+
+// Loopback round trips through one transport backend. A forked client sends a command and waits
+// for the server's reply, which the command_received handler sends back, so each round trip
+// crosses the receive path, the processor thread and the send path. Reports latency percentiles
+// and the server process's CPU time per round trip; the client runs in its own process so its
+// CPU is not counted. unix and shm are the local transports for companion processes, to compare
+// against udp on loopback; they take no io_uring backend.
+
+using Clock = std::chrono::steady_clock;
+
+void usage(const std::string& bin_name) {
+    std::cerr << "Usage : " << bin_name << " <udp|tcp|unix|shm> <epoll|io_uring> [port] [round_trips]\n"
+              << "Defaults to port 9880 and 50000 round trips. unix and shm derive their socket path or\n"
+              << "shared memory name from the port.\n";
+}
+
+std::string unixPath(int port) {
+    return "/tmp/transport_latency_" + std::to_string(port) + ".sock";
+}
+
+std::string sharedMemoryName(int port) {
+    return "transport_latency_" + std::to_string(port);
+}
+
+double processCpuSeconds() {
+    timespec cpu{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+    return cpu.tv_sec + cpu.tv_nsec / 1e9;
+}
+
+int connectClient(const std::string& transport, int port) {
+    sockaddr_in server{};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sockaddr_un local{};
+    local.sun_family = AF_UNIX;
+    std::strncpy(local.sun_path, unixPath(port).c_str(), sizeof(local.sun_path) - 1);
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        int fd;
+        int connected;
+        if (transport == "unix") {
+            fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+            connected = fd >= 0 ? connect(fd, (sockaddr*)&local, sizeof(local)) : -1;
+        } else {
+            fd = socket(AF_INET, transport == "tcp" ? SOCK_STREAM : SOCK_DGRAM, 0);
+            connected = fd >= 0 ? connect(fd, (sockaddr*)&server, sizeof(server)) : -1;
+        }
+        if (connected == 0) {
+            return fd;
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return -1;
+}
+
+// Runs in the forked client. Waits on ready until the server is listening, then tells the
+// server process when the timed part starts and ends by writing to control.
+int runClient(const std::string& transport, int port, size_t round_trips, int ready, int control) {
+    char marker = 0;
+    if (read(ready, &marker, 1) != 1) {
+        return 1;
+    }
+    const std::string command = "takeoff:\n";
+    int fd = -1;
+    SharedMemoryChannel channel;
+    std::function<bool()> roundTrip;
+    if (transport == "shm") {
+        if (!channel.open(sharedMemoryName(port))) {
+            return 1;
+        }
+        roundTrip = [&channel, &command, reply = std::string()]() mutable -> bool {
+            if (!channel.toService().push(command)) {
+                return false;
+            }
+            auto deadline = Clock::now() + std::chrono::seconds(1);
+            while (!channel.toClient().pop(reply)) {
+                if (Clock::now() > deadline) {
+                    errno = ETIMEDOUT;
+                    return false;
+                }
+                channel.toClient().wait(1000);
+            }
+            return true;
+        };
+    } else {
+        fd = connectClient(transport, port);
+        if (fd < 0) {
+            std::cerr << "Client could not connect: " << strerror(errno) << std::endl;
+            return 1;
+        }
+        timeval timeout{1, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        roundTrip = [fd, &command]() -> bool {
+            char reply[2048];
+            if (send(fd, command.data(), command.size(), 0) != static_cast<ssize_t>(command.size())) {
+                return false;
+            }
+            return recv(fd, reply, sizeof(reply), 0) > 0;
+        };
+    }
+
+    const size_t warmup = 1000;
+    for (size_t i = 0; i < warmup; ++i) {
+        if (!roundTrip()) {
+            std::cerr << "Warm-up round trip failed: " << strerror(errno) << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<uint64_t> latencies;
+    latencies.reserve(round_trips);
+    marker = 's';
+    if (write(control, &marker, 1) != 1) {
+        return 1;
+    }
+    auto start = Clock::now();
+    for (size_t i = 0; i < round_trips; ++i) {
+        auto sent = Clock::now();
+        if (!roundTrip()) {
+            std::cerr << "Round trip " << i << " failed: " << strerror(errno) << std::endl;
+            return 1;
+        }
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - sent).count());
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    marker = 'e';
+    if (write(control, &marker, 1) != 1) {
+        return 1;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p / 100.0 * latencies.size()))] / 1000.0;
+    };
+    std::cout << round_trips << " round trips, " << static_cast<uint64_t>(round_trips / seconds) << "/s, latency us:"
+              << " p50 " << percentile(50) << " p90 " << percentile(90) << " p99 " << percentile(99)
+              << " p99.9 " << percentile(99.9) << " max " << latencies.back() / 1000.0 << std::endl;
+    if (fd >= 0) {
+        close(fd);
+    }
+    return 0;
+}
+
+std::shared_ptr<ICommunication> makeServer(const std::string& transport, bool io_uring, int port) {
+    if (transport == "unix" || transport == "shm") {
+        if (io_uring) {
+            std::cerr << transport << " has no io_uring backend" << std::endl;
+            return nullptr;
+        }
+        if (transport == "unix") {
+            return std::make_shared<UnixSocketServer>(unixPath(port));
+        }
+        return std::make_shared<SharedMemoryTransport>(sharedMemoryName(port), 1 << 18);
+    }
+    bool tcp = transport == "tcp";
+#ifdef HAVE_IO_URING
+    if (io_uring) {
+        if (!IoUring::supported()) {
+            return nullptr;
+        }
+        if (tcp) {
+            return std::make_shared<IoUringTCPServer>(port);
+        }
+        return std::make_shared<IoUringUDPServer>(port);
+    }
+#else
+    if (io_uring) {
+        std::cerr << "Built without io_uring support" << std::endl;
+        return nullptr;
+    }
+#endif
+    if (tcp) {
+        return std::make_shared<TCPServer>(port);
+    }
+    return std::make_shared<UDPServer>(port);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3 || argc > 5) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::string transport = argv[1];
+    std::string backend = argv[2];
+    if ((transport != "udp" && transport != "tcp" && transport != "unix" && transport != "shm")
+        || (backend != "epoll" && backend != "io_uring")) {
+        usage(argv[0]);
+        return 1;
+    }
+    int port = argc > 3 ? std::stoi(argv[3]) : 9880;
+    size_t round_trips = argc > 4 ? std::stoul(argv[4]) : 50000;
+
+    // Fork before any server thread exists
+    int ready[2];
+    int control[2];
+    if (pipe(ready) < 0 || pipe(control) < 0) {
+        std::cerr << "Error creating pipe: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    pid_t client = fork();
+    if (client < 0) {
+        std::cerr << "Error forking client: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    if (client == 0) {
+        close(ready[1]);
+        close(control[0]);
+        _exit(runClient(transport, port, round_trips, ready[0], control[1]));
+    }
+    close(ready[0]);
+    close(control[1]);
+
+    CREATE_EVENT("send_ack", const std::string & command);
+    CREATE_EVENT("command_received", CommandId command, const std::vector<double> & parameters, uint32_t client);
+    std::shared_ptr<ICommunication> server = makeServer(transport, backend == "io_uring", port);
+    if (!server || !server->start()) {
+        kill(client, SIGTERM);
+        waitpid(client, nullptr, 0);
+        return 1;
+    }
+    auto subscription = GetEventChannel<CommandReceivedEvent>().subscribe([&server](CommandId, const std::vector<double>&, uint32_t) {
+        server->send_message("ack\n");
+    });
+    char marker = 'r';
+    if (write(ready[1], &marker, 1) != 1) {
+        kill(client, SIGTERM);
+    }
+    close(ready[1]);
+
+    double cpu_start = 0;
+    double cpu_end = 0;
+    while (read(control[0], &marker, 1) == 1) {
+        if (marker == 's') {
+            cpu_start = processCpuSeconds();
+        } else if (marker == 'e') {
+            cpu_end = processCpuSeconds();
+        }
+    }
+    int status = 0;
+    waitpid(client, &status, 0);
+    subscription.unsubscribe();
+    server->stop();
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || cpu_end == 0) {
+        std::cerr << "Client failed" << std::endl;
+        return 1;
+    }
+    std::cout << transport << "/" << backend << ": server CPU " << (cpu_end - cpu_start) * 1e6 / round_trips
+              << " us per round trip" << std::endl;
+    return 0;
+}
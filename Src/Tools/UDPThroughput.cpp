@@ -0,0 +1,173 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "../../Events/EventChannels.h"
+#include "../Communications/UDPServer.h"
+
+// Loopback throughput of UDPServer. Clients send text commands to the server, counted as they
+// reach the command_received event, then the server broadcasts to every client. Each phase reports
+// datagrams per second and socket syscalls per datagram from UDPServer::getTransferStats().
+
+using Clock = std::chrono::steady_clock;
+
+void usage(const std::string& bin_name) {
+    std::cerr << "Usage : " << bin_name << " [port] [datagrams] [clients]\n"
+              << "Defaults to port 9870, 200000 datagrams and 16 clients.\n";
+}
+
+int openClient(int port, sockaddr_in& server) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        std::cerr << "Error creating client socket: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    server = {};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    timeval timeout{0, 200000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+// Waits until counter has not moved for quiet, so the tail of a phase is not cut off
+template <typename Counter>
+void waitUntilQuiet(Counter counter, std::chrono::milliseconds quiet) {
+    uint64_t last = counter();
+    auto changed = Clock::now();
+    while (Clock::now() - changed < quiet) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        uint64_t now = counter();
+        if (now != last) {
+            last = now;
+            changed = Clock::now();
+        }
+    }
+}
+
+void report(const std::string& phase, uint64_t datagrams, uint64_t calls, Clock::duration elapsed) {
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    std::cout << phase << ": " << datagrams << " datagrams in " << seconds * 1000.0 << " ms, "
+              << static_cast<uint64_t>(datagrams / seconds) << " datagrams/s, "
+              << (datagrams ? static_cast<double>(calls) / datagrams : 0.0) << " syscalls/datagram" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 4) {
+        usage(argv[0]);
+        return 1;
+    }
+    int port = argc > 1 ? std::stoi(argv[1]) : 9870;
+    size_t datagrams = argc > 2 ? std::stoul(argv[2]) : 200000;
+    size_t client_count = argc > 3 ? std::stoul(argv[3]) : 16;
+    if (client_count == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    CREATE_EVENT("send_ack", const std::string & command);
+    CREATE_EVENT("command_received", CommandId command, const std::vector<double> & parameters, uint32_t client);
+    std::atomic<uint64_t> commands{0};
+    auto subscription = GetEventChannel<CommandReceivedEvent>().subscribe([&](CommandId, const std::vector<double>&, uint32_t) {
+        commands.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    UDPServer server(port);
+    if (!server.start()) {
+        return 1;
+    }
+
+    std::vector<int> clients;
+    sockaddr_in server_address;
+    for (size_t i = 0; i < client_count; ++i) {
+        int fd = openClient(port, server_address);
+        if (fd < 0) {
+            return 1;
+        }
+        clients.push_back(fd);
+    }
+
+    // Every client announces itself first so the broadcast phase reaches all of them
+    const std::string command = "takeoff:";
+    while (commands.load() < client_count) {
+        for (size_t i = commands.load(); i < client_count; ++i) {
+            sendto(clients[i], command.data(), command.size(), 0, (sockaddr*)&server_address, sizeof(server_address));
+            waitUntilQuiet([&]() { return commands.load(); }, std::chrono::milliseconds(20));
+        }
+    }
+
+    // Receive: clients take turns sending, keeping at most window commands in flight so the socket
+    // buffer never overflows and the rate measured is the server's, not the kernel's drop rate.
+    const uint64_t window = 128;
+    UDPServer::TransferStats before = server.getTransferStats();
+    uint64_t published = commands.load();
+    auto start = Clock::now();
+    for (size_t n = 0; n < datagrams; ++n) {
+        while (n - (commands.load(std::memory_order_relaxed) - published) >= window) {
+            std::this_thread::yield();
+        }
+        sendto(clients[n % client_count], command.data(), command.size(), 0, (sockaddr*)&server_address, sizeof(server_address));
+    }
+    waitUntilQuiet([&]() { return commands.load(); }, std::chrono::milliseconds(200));
+    auto elapsed = Clock::now() - start - std::chrono::milliseconds(200);
+    UDPServer::TransferStats received = server.getTransferStats();
+    report("receive", received.datagramsReceived - before.datagramsReceived, received.receiveCalls - before.receiveCalls, elapsed);
+    std::cout << "  " << commands.load() - published << " of " << datagrams << " commands published" << std::endl;
+
+    // Send: broadcasts go out in bursts that fit the outbound queues, so nothing is dropped and the
+    // rate is the sender thread's.
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<bool> receiving{true};
+    std::vector<std::thread> readers;
+    for (int fd : clients) {
+        readers.emplace_back([&, fd]() {
+            char buffer[2048];
+            while (receiving) {
+                if (recv(fd, buffer, sizeof(buffer), 0) > 0) {
+                    delivered.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    const std::string telemetry(200, 't');
+    const size_t burst = 128;
+    size_t broadcasts = datagrams / client_count;
+    start = Clock::now();
+    for (size_t sent = 0; sent < broadcasts; sent += burst) {
+        for (size_t n = 0; n < burst && sent + n < broadcasts; ++n) {
+            server.send_message(telemetry);
+        }
+        bool drained = false;
+        while (!drained) {
+            std::this_thread::yield();
+            drained = true;
+            for (const auto& stats : server.getClientQueueStats()) {
+                drained = drained && stats.queue.depth == 0;
+            }
+        }
+    }
+    elapsed = Clock::now() - start;
+    UDPServer::TransferStats sent = server.getTransferStats();
+    sent.datagramsSent -= received.datagramsSent;
+    sent.sendCalls -= received.sendCalls;
+    waitUntilQuiet([&]() { return delivered.load(); }, std::chrono::milliseconds(200));
+    receiving = false;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    report("broadcast", sent.datagramsSent, sent.sendCalls, elapsed);
+    std::cout << "  " << broadcasts << " broadcasts to " << client_count << " clients, "
+              << delivered.load() << " datagrams delivered" << std::endl;
+
+    for (int fd : clients) {
+        close(fd);
+    }
+    server.stop();
+    return 0;
+}
@@ -4,10 +4,13 @@
 #include <thread>
 #include "Src/Modules/TelemetryManager.h"
 #include "Src/Modules/CommandManager.h"
+#include "Src/Modules/CommandScheduler.h"
 #include "inih/cpp/INIReader.h"
 #include "Events/EventManager.h"
+#include "Events/CommandTrace.h"
 #include "Src/Modules/CommunicationManager.h"
 #include <chrono>
+#include <future>
 #include "Src/Modules/AddonsManager.h"
 #include "Src/Modules/UDPVideoStreamer.h"
 #include <fcntl.h>
@@ -30,17 +33,6 @@ void usage(const std::string& bin_name) {
               << "For example, to connect to the simulator use URL: udp://:14540\n";
 }
 
-void main_thread_function(std::shared_ptr<System> system,
-                          std::shared_ptr<CommandManager> command_manager,
-                          std::shared_ptr<TelemetryManager> telemetry_manager,
-                          std::shared_ptr<CommunicationManager> communication_manager) {
-    telemetry_manager->start();
-
-    while (true) {
-        std::this_thread::sleep_for(std::chrono::seconds(3));
-    }
-}
-
 void stream_thread_function() {
     try {
         UDPVideoStreamer streamer(0, "192.168.20.11", 12345);  // Use appropriate IP and port
@@ -56,19 +48,28 @@ int main(int argc, char** argv) {
         usage(argv[0]);
         return 1;
     }
+    // Field recording: every event invoke goes to an mmap'd journal that Src/Tools/EventReplay replays.
+    INIReader config("../config.ini");
+    std::string journal_path = config.GetString("Journal", "RecordPath", "");
+    if (!journal_path.empty()) {
+        GetEventManager().startJournal(journal_path, static_cast<size_t>(config.GetInteger("Journal", "CapacityMB", 64)) << 20);
+    }
+
     CREATE_EVENT("send_ack" , const std::string & command);
+    GetEventManager().startMetricsDump(std::chrono::seconds(60));
 
-    auto communication_manager = std::make_shared<CommunicationManager>(ECT_UDP,8080);
-    communication_manager->start();\
+    // Ground station links from [Links] in config.ini
+    auto communication_manager = std::make_shared<CommunicationManager>();
+    communication_manager->start();
+    GetEventManager().timers().scheduleEvery(std::chrono::seconds(60), [communication_manager]() {
+        communication_manager->dumpLinkStats(std::cout);
+    });
 
     CREATE_EVENT("InfoRequest");
     CREATE_EVENT("set_brightness");
-    CREATE_EVENT("command_received", const std::string & command, const std::vector<float> & parameters);
+    CREATE_EVENT("command_received", CommandId command, const std::vector<double> & parameters, uint32_t client);
 
     std::thread stream_thread(stream_thread_function);
-//    SUBSCRIBE_TO_EVENT("send_ack", ([communication_manager]( const std::string & command) {
-//        communication_manager->send_message_all("Ack: " + command);
-//    }));
     auto manager = make_shared<AddonsManager>();
     manager->start();
 
@@ -114,29 +115,46 @@ int main(int argc, char** argv) {
    sleep_for(std::chrono::seconds(3));
 
 
-    SUBSCRIBE_TO_EVENT("InfoRequest", ([telemetry_manager, communication_manager]() {
-    communication_manager->send_message_all(telemetry_manager->getTelemetryData().print());
+    // Handlers make blocking calls, so they run on executors instead of the receive threads.
+    // Each subscriber gets its own strand to keep its invocations in order.
+    auto event_executor = std::make_shared<ThreadPoolExecutor>(2);
+
+    SUBSCRIBE_TO_EVENT_ASYNC("InfoRequest", StrandExecutor::create(event_executor), ([telemetry_manager, communication_manager]() {
+    communication_manager->route_message(telemetry_manager->getTelemetryData().print(), CommunicationManager::Traffic::Telemetry);
     }));
 
-    SUBSCRIBE_TO_EVENT("command_received", [command_manager](const std::string& command, const std::vector<float>& parameters) {
+    // Commands are executed by the scheduler's lane workers; the receive threads only enqueue.
+    auto command_scheduler = std::make_shared<CommandScheduler>([command_manager](CommandId command, const std::vector<double>& parameters) {
         if (command_manager != nullptr && command_manager->IsViable()) {
             if (command_manager->is_command_valid(command)){
             auto result = command_manager->handle_command(command, parameters);
             if(result != CommandManager::Result::Success)
                 cerr << "Command Failed" << std::endl;
         }else {
-                std::cerr << "Invalid command: " << command << std::endl;
+                std::cerr << "Invalid command: " << commandName(command) << std::endl;
             }
         }
         else {
             std::cerr << "Command manager not set or not viable." << std::endl;
         }
     });
+    command_scheduler->start();
+    // Receive-to-MAVSDK latency per stage of UDP and TCP commands
+    GetEventManager().timers().scheduleEvery(std::chrono::seconds(60), []() {
+        GetCommandLatency().dump(std::cout);
+    });
 
+    SUBSCRIBE_TO_EVENT("command_received", [command_scheduler](CommandId command, const std::vector<double>& parameters, uint32_t client) {
+        command_scheduler->submit(command, parameters, client);
+    });
+
+
+    telemetry_manager->start();
 
-    std::thread main_thread(main_thread_function, system, command_manager, telemetry_manager, communication_manager);
+    // All work runs on the transport, scheduler and timer threads; block here without polling.
+    std::promise<void> shutdown;
+    shutdown.get_future().wait();
 
-    main_thread.join();
     stream_thread.join();
     manager->stop();
 